@@ -1,5 +1,6 @@
 #include "BackupHelper.h"
 
+#include <DataLayer/Database/Database.h>
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
 #include <DataLayer/DataStorageLayer/ScenarioStorage.h>
 
@@ -74,10 +75,22 @@ void BackupHelper::saveBackup(const QString& _filePath, const QString& _newName)
 		const QString backupVersionsFileName =
                 QString("%1%2.versions.backup.%3").arg(backupPath, backupBaseName, kBackupVersionsExtension);
 
+		//
+		// Переносим изменения из журнала в файл проекта, чтобы они попали в копию.
+		// Резервная копия может создаваться в фоновом потоке, где основное соединение
+		// с базой данных недоступно, поэтому используем соединение текущего потока.
+		// Если перенести изменения не удалось, то копия файла будет без них, поэтому не делаем её
+		//
+		const bool isCheckpointed = DatabaseLayer::Database::checkpoint(_filePath);
+		if (!isCheckpointed) {
+			qWarning("Backup of the project file is skipped: journal checkpoint failed");
+		}
+
 		//
 		// Копируем файл во временную резервную копию
 		//
-		if (QFile::copy(_filePath, tmpBackupFileName)) {
+		if (isCheckpointed
+			&& QFile::copy(_filePath, tmpBackupFileName)) {
 			//
 			// Если скопировать удалось, переименовываем временную копию
 			//
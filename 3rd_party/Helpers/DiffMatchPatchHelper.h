@@ -7,108 +7,283 @@
 #include <QDomDocument>
 #include <QDebug>
 #include <QHash>
+#include <QPair>
 #include <QSet>
 #include <QString>
-#include <QRegularExpression>
+
+#include <cstring>
 
 namespace {
+    /**
+     * @brief Код спецсимвола, соответствующего первому тэгу таблицы
+     */
+    const int kFirstTagChar = 44032;
+
+    /**
+     * @brief Таблица соответствий xml-тэгов и спецсимволов, спецсимвол тэга - символ юникода
+     *        с кодом kFirstTagChar + индекс тэга в таблице
+     * @note Для карты соответсвия используем символы юникода, которые врядли будут использоваться
+     *
+     * WARNING: Добавлять новые теги, только в конец таблицы, ни в коем случае не в начало,
+     *			или середину, иначе это порушит совместимость со всеми предыдущими патчами
+     */
+    const char* const kTags[] = {
+        "<scene_heading>",          // 가
+        "</scene_heading>",         // 각
+        "<scene_characters>",       // 갂
+        "</scene_characters>",      // 갃
+        "<action>",                 // 간
+        "</action>",                // 갅
+        "<character>",              // 갆
+        "</character>",             // 갇
+        "<parenthetical>",          // 갈
+        "</parenthetical>",         // 갉
+        "<dialog>",                 // 갊
+        "</dialog>",                // 갋
+        "<transition>",             // 갌
+        "</transition>",            // 갍
+        "<note>",                   // 갎
+        "</note>",                  // 갏
+        "<title_header>",           // 감
+        "</title_header>",          // 갑
+        "<title>",                  // 값
+        "</title>",                 // 갓
+        "<noprintable_text>",       // 갔
+        "</noprintable_text>",      // 강
+        "<scene_group>",            // 갖
+        "</scene_group>",           // 갗
+        "<scene_group_header>",     // 갘
+        "</scene_group_header>",    // 같
+        "<scene_group_footer>",     // 갚
+        "</scene_group_footer>",    // 갛
+        "<folder>",                 // 개
+        "</folder>",                // 객
+        "<folder_header>",          // 갞
+        "</folder_header>",         // 갟
+        "<folder_footer>",          // 갠
+        "</folder_footer>",         // 갡
+
+        "<v><![CDATA[",             // 갢
+        "]]></v>",                  // 갣
+
+        "<scene_description>",      // 갤
+        "</scene_description>",     // 갥
+        "<undefined>",              // 갦
+        "</undefined>",             // 갧
+        "<lyrics>",                 // 갨
+        "</lyrics>"                 // 갩
+    };
+
+    /**
+     * @brief Количество тэгов в таблице
+     */
+    const int kTagsCount = sizeof(kTags) / sizeof(kTags[0]);
+
+    /**
+     * @brief Максимальная длина тэга из таблицы
+     */
+    const int kMaxTagLength = 21;
+
+    /**
+     * @brief Начало и конец текста блока
+     */
+    /** @{ */
+    const QLatin1String kCDataStart("<v><![CDATA[");
+    const QLatin1String kCDataEnd("]]></v>");
+    /** @} */
+
+    /**
+     * @brief Обрамление xml сценария
+     */
+    const QLatin1String kCommonXmlTags[] = {
+        QLatin1String("<?xml version=\"1.0\"?>\n"),
+        QLatin1String("<scenario version=\"1.0\">\n"),
+        QLatin1String("</scenario>\n")
+    };
+
     /**
      * @brief Является ли строка тэгом
      */
-    static bool isTag(const QString& _tag) {
-        return !_tag.isEmpty() && _tag.startsWith("<") && _tag.endsWith(">");
+    static bool isTag(const char* _tag) {
+        const uint length = qstrlen(_tag);
+        return length > 0 && _tag[0] == '<' && _tag[length - 1] == '>';
     }
 
     /**
      * @brief Является ли тэг открывающим
      */
-    static bool isOpenTag(const QString& _tag) {
-        return isTag(_tag) && !_tag.contains("/");
+    static bool isOpenTag(const char* _tag) {
+        return isTag(_tag) && std::strchr(_tag, '/') == nullptr;
     }
 
     /**
      * @brief Является ли тэг закрывающим
      */
-    static bool isCloseTag(const QString& _tag) {
-        return isTag(_tag) && _tag.contains("/");
+    static bool isCloseTag(const char* _tag) {
+        return isTag(_tag) && std::strchr(_tag, '/') != nullptr;
     }
 
     /**
-     * @brief Удалить все xml-тэги сценария
+     * @brief Получить тэг, соответствующий спецсимволу
+     * @return Тэг, или nullptr, если символ не является спецсимволом
      */
-    QString removeCommonXmlTagsForScenario(const QString& _xml) {
-        QString result = _xml;
-        result = result.remove("<?xml version=\"1.0\"?>\n");
-        result = result.remove("<scenario version=\"1.0\">\n");
-        result = result.remove("</scenario>\n");
+    static const char* tagForChar(QChar _char) {
+        const int index = _char.unicode() - kFirstTagChar;
+        return index >= 0 && index < kTagsCount ? kTags[index] : nullptr;
+    }
 
-        return result;
+    /**
+     * @brief Является ли символ спецсимволом открывающего тэга
+     */
+    static bool isOpenTagChar(QChar _char) {
+        const char* tag = tagForChar(_char);
+        return tag != nullptr && isOpenTag(tag);
+    }
+
+    /**
+     * @brief Является ли символ спецсимволом закрывающего тэга
+     */
+    static bool isCloseTagChar(QChar _char) {
+        const char* tag = tagForChar(_char);
+        return tag != nullptr && isCloseTag(tag);
+    }
+
+    /**
+     * @brief Карта соответствий xml-тэгов и спецсимволов, формируется по таблице тэгов
+     */
+    static const QHash<QString, QChar>& tagsChars() {
+        static QHash<QString, QChar> s_tagsChars;
+        if (s_tagsChars.isEmpty()) {
+            s_tagsChars.reserve(kTagsCount);
+            for (int index = 0; index < kTagsCount; ++index) {
+                s_tagsChars.insert(QLatin1String(kTags[index]), QChar(kFirstTagChar + index));
+            }
+        }
+        return s_tagsChars;
     }
 
     /**
-     * @brief Удалить все xml-тэги сценария
+     * @brief Начинается ли текст в заданной позиции с заданной строки
      */
-    QString removeXmlTagsForScenario(const QString& _xml, const QHash<QString,QString> _tagsMap) {
-        QString result = _xml;
-        result = removeCommonXmlTagsForScenario(result);
-
-        result = result.remove("<scene_group>\n");
-        result = result.remove("</scene_group>\n");
-        result = result.remove("<folder>\n");
-        result = result.remove("</folder>\n");
-        result = result.remove("<reviews>\n");
-        result = result.remove("</reviews>\n");
-        result = result.remove("<reviews/>\n");
-        result = result.remove("<review>\n");
-        result = result.remove("</review>\n");
-        result = result.remove("<review/>\n");
-        result = result.remove("<review_comment>\n");
-        result = result.remove("</review_comment>\n");
-        result = result.remove("<review_comment/>\n");
-        result = result.remove("<formatting>\n");
-        result = result.remove("</formatting>\n");
-        result = result.remove("<formatting/>\n");
-        result = result.remove("<format>\n");
-        result = result.remove("</format>\n");
-        result = result.remove("<format/>\n");
-
-        for (const QString& tag : _tagsMap.keys()) {
+    static bool startsWithAt(const QString& _text, int _position, const QLatin1String& _string) {
+        return _text.midRef(_position, _string.size()) == _string;
+    }
+
+    /**
+     * @brief Получить длину обрамления xml сценария, начинающегося в заданной позиции
+     * @return Длина обрамления, или 0, если в позиции его нет
+     */
+    static int commonXmlTagLengthAt(const QString& _xml, int _position) {
+        for (const QLatin1String& tag : kCommonXmlTags) {
+            if (startsWithAt(_xml, _position, tag)) {
+                return tag.size();
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Сущности, которыми экранируется текст сценария, и соответствующие им символы
+     * @note Соответствует TextEditHelper::toHtmlEscaped
+     */
+    const QPair<QLatin1String, QChar> kHtmlEntities[] = {
+        { QLatin1String("&amp;"), QChar('&') },
+        { QLatin1String("&lt;"), QChar('<') },
+        { QLatin1String("&gt;"), QChar('>') },
+        { QLatin1String("&quot;"), QChar('"') },
+        { QLatin1String("&#10;"), QChar('\n') }
+    };
+
+    /**
+     * @brief Добавить к результату фрагмент текста, заменив экранирующие сущности их символами
+     */
+    static void appendHtmlUnescaped(const QString& _text, int _from, int _to, QString& _result) {
+        int position = _from;
+        while (position < _to) {
+            const int entityStart = _text.indexOf('&', position);
+            if (entityStart == -1
+                || entityStart >= _to) {
+                break;
+            }
+
+            _result.append(_text.midRef(position, entityStart - position));
+
             //
-            // Для CDATA не убираем перенос строки,
-            // т.к. он должен учитываться за отдельный символ
+            // Неизвестную сущность оставляем как есть
             //
-            const QString suffix = isTag(tag) ? "\n" : "";
-            result = result.remove(tag + suffix);
+            QChar entityChar = '&';
+            int entityLength = 1;
+            for (const auto& entity : kHtmlEntities) {
+                if (entityStart + entity.first.size() <= _to
+                    && startsWithAt(_text, entityStart, entity.first)) {
+                    entityChar = entity.second;
+                    entityLength = entity.first.size();
+                    break;
+                }
+            }
+            _result.append(entityChar);
+            position = entityStart + entityLength;
+        }
+        _result.append(_text.midRef(position, _to - position));
+    }
+
+    /**
+     * @brief Удалить все xml-тэги сценария, оставив только текст блоков и переносы строк между ними
+     * @note Текст разбирается за один проход, тэги вместе с последующим переносом строки удаляются,
+     *       текст внутри CDATA остаётся без изменений, за исключением экранирующих сущностей,
+     *       каждая из которых, как и в документе, считается за один символ
+     */
+    QString removeXmlTagsForScenario(const QString& _xml) {
+        QString result;
+        result.reserve(_xml.size());
+
+        const int xmlLength = _xml.length();
+        int position = 0;
+        while (position < xmlLength) {
+            //
+            // Текст блока копируем целиком
+            //
+            if (startsWithAt(_xml, position, kCDataStart)) {
+                const int textStart = position + kCDataStart.size();
+                int textEnd = _xml.indexOf(kCDataEnd, textStart);
+                if (textEnd == -1) {
+                    textEnd = xmlLength;
+                }
+                appendHtmlUnescaped(_xml, textStart, textEnd, result);
+                //
+                // ... а перенос строки после него учитывается за отдельный символ
+                //
+                position = textEnd + kCDataEnd.size();
+                continue;
+            }
+
+            //
+            // Тэги удаляем вместе с переносом строки после них
+            //
+            if (_xml.at(position) == '<') {
+                const int tagEnd = _xml.indexOf('>', position);
+                if (tagEnd == -1) {
+                    break;
+                }
+                position = tagEnd + 1;
+                if (position < xmlLength
+                    && _xml.at(position) == '\n') {
+                    ++position;
+                }
+                continue;
+            }
+
+            //
+            // Текст вне тэгов тоже может содержать сущности
+            //
+            int textEnd = _xml.indexOf('<', position);
+            if (textEnd == -1) {
+                textEnd = xmlLength;
+            }
+            appendHtmlUnescaped(_xml, position, textEnd, result);
+            position = textEnd;
         }
 
-        auto cleanResult = [&result] (const QString& _pattern) {
-            result = result.remove(QRegularExpression(_pattern, QRegularExpression::MultilineOption
-                                                      | QRegularExpression::DotMatchesEverythingOption
-                                                      | QRegularExpression::InvertedGreedinessOption));
-        };
-        cleanResult("<scene_heading(.*)>\n");
-        cleanResult("<scene_group_header(.*)>\n");
-        cleanResult("<folder_header(.*)>\n");
-        cleanResult("<review(.*)>\n");
-        cleanResult("<review_comment(.*)>\n");
-        cleanResult("<format(.*)>\n");
-        //
-        cleanResult("<scene_characters(.*)>\n");
-        cleanResult("<action(.*)>\n");
-        cleanResult("<character(.*)>\n");
-        cleanResult("<parenthetical(.*)>\n");
-        cleanResult("<dialog(.*)>\n");
-        cleanResult("<transition(.*)>\n");
-        cleanResult("<note(.*)>\n");
-        cleanResult("<title_header(.*)>\n");
-        cleanResult("<title(.*)>\n");
-        cleanResult("<noprintable_text(.*)>\n");
-        cleanResult("<scene_description(.*)>\n");
-        cleanResult("<undefined(.*)>\n");
-        cleanResult("<lyrics(.*)>\n");
-
-        result = TextEditHelper::removeXmlTags(result);
-        result = TextEditHelper::fromHtmlEscaped(result);
         return result;
     }
 }
@@ -141,6 +316,80 @@ public:
                     );
     }
 
+    /**
+     * @brief Сформировать патч между фрагментами двух xml-текстов, отличающихся только этими фрагментами
+     * @param _plainPosition - позиция фрагментов в плоском тексте, одинаковая для обоих текстов
+     * @note Патч совпадает по формату с патчем, сформированным по текстам целиком
+     */
+    static QString makePatchXml(const QString& _xml1, const QString& _xml2, int _plainPosition) {
+        diff_match_patch dmp;
+        QList<Patch> patches = dmp.patch_make(xmlToPlain(_xml1), xmlToPlain(_xml2));
+        for (Patch& patch : patches) {
+            patch.start1 += _plainPosition;
+            patch.start2 += _plainPosition;
+        }
+        return plainToXml(dmp.patch_toText(patches));
+    }
+
+    /**
+     * @brief Определить диапазон плоского текста исходного xml-текста, который затрагивает патч
+     * @return Есть ли в патче изменения
+     */
+    static bool patchRange(const QString& _patch, int& _from, int& _to) {
+        diff_match_patch dmp;
+        const QList<Patch> patches = dmp.patch_fromText(xmlToPlain(_patch));
+        if (patches.isEmpty()) {
+            return false;
+        }
+
+        //
+        // Позиции каждого следующего патча указаны с учётом применения предыдущих,
+        // поэтому для исходного текста их нужно сместить на суммарное изменение длины
+        //
+        int patchesDelta = 0;
+        _from = -1;
+        _to = -1;
+        for (const Patch& patch : patches) {
+            const int start = patch.start1 - patchesDelta;
+            if (_from == -1
+                || start < _from) {
+                _from = start;
+            }
+            if (_to < start + patch.length1) {
+                _to = start + patch.length1;
+            }
+            patchesDelta += patch.length2 - patch.length1;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Применить патч к фрагменту xml-текста, начинающемуся в заданной позиции плоского текста
+     * @return Удалось ли применить все части патча
+     */
+    static bool applyPatchXml(const QString& _xml, const QString& _patch, int _plainPosition, QString& _result) {
+        diff_match_patch dmp;
+        QList<Patch> patches = dmp.patch_fromText(xmlToPlain(_patch));
+        for (Patch& patch : patches) {
+            patch.start1 -= _plainPosition;
+            patch.start2 -= _plainPosition;
+        }
+        const QPair<QString, QVector<bool>> result = dmp.patch_apply(patches, xmlToPlain(_xml));
+        if (result.second.contains(false)) {
+            return false;
+        }
+
+        _result = plainToXml(result.first);
+        return true;
+    }
+
+    /**
+     * @brief Получить длину плоского текста, соответствующего xml-тексту
+     */
+    static int plainLength(const QString& _xml) {
+        return xmlToPlain(_xml).length();
+    }
+
     /**
      * @brief Применить патч для простого текста
      */
@@ -191,7 +440,7 @@ public:
                 //
                 // Считаем длину убирая xml-тэги и последний перевод строки
                 //
-                QString plain = removeXmlTagsForScenario(xml, tagsMap());
+                QString plain = removeXmlTagsForScenario(xml);
                 if (plain.endsWith("\n")) {
                     plain.chop(1);
                 }
@@ -312,7 +561,7 @@ public:
             //
             // Идём до открывающего тега
             //
-            if (isOpenTag(tagsMap().key(oldXmlPlain.at(oldStartPosForXml)))) {
+            if (isOpenTagChar(oldXmlPlain.at(oldStartPosForXml))) {
                 break;
             }
         }
@@ -321,7 +570,7 @@ public:
             //
             // Идём до закрывающего тэга, он находится в конце строки
             //
-            if (isCloseTag(tagsMap().key(oldXmlPlain.at(oldEndPosForXml)))) {
+            if (isCloseTagChar(oldXmlPlain.at(oldEndPosForXml))) {
                 ++oldEndPosForXml;
                 break;
             }
@@ -337,7 +586,7 @@ public:
             //
             // Идём до открывающего тега
             //
-            if (isOpenTag(tagsMap().key(newXmlPlain.at(newStartPosForXml)))) {
+            if (isOpenTagChar(newXmlPlain.at(newStartPosForXml))) {
                 break;
             }
         }
@@ -346,7 +595,7 @@ public:
             //
             // Идём до закрывающего тэга, он находится в конце строки
             //
-            if (isCloseTag(tagsMap().key(newXmlPlain.at(newEndPosForXml)))) {
+            if (isCloseTagChar(newXmlPlain.at(newEndPosForXml))) {
                 ++newEndPosForXml;
                 break;
             }
@@ -359,12 +608,12 @@ public:
         //
         const QString oldXmlPart = oldXmlPlain.left(oldStartPosForXml);
         const int oldXmlPartLength = oldXmlPart.length();
-        const int oldPlainPartLength = ::removeXmlTagsForScenario(plainToXml(oldXmlPart), tagsMap()).length();
+        const int oldPlainPartLength = ::removeXmlTagsForScenario(plainToXml(oldXmlPart)).length();
         int oldStartPosForPlain = oldStartPosForXml - (oldXmlPartLength - oldPlainPartLength);
         //
         const QString newXmlPart = newXmlPlain.left(newStartPosForXml);
         const int newXmlPartLength = newXmlPart.length();
-        const int newPlainPartLength = ::removeXmlTagsForScenario(plainToXml(newXmlPart), tagsMap()).length();
+        const int newPlainPartLength = ::removeXmlTagsForScenario(plainToXml(newXmlPart)).length();
         int newStartPosForPlain = newStartPosForXml - (newXmlPartLength - newPlainPartLength);
 
 
@@ -455,7 +704,7 @@ public:
                     //
                     // Идём до открывающего тега
                     //
-                    if (isOpenTag(tagsMap().key(oldXml.at(oldStartPosForXml)))) {
+                    if (isOpenTagChar(oldXml.at(oldStartPosForXml))) {
                         break;
                     }
                 }
@@ -464,7 +713,7 @@ public:
                     //
                     // Идём до закрывающего тэга, он находится в конце строки
                     //
-                    if (isCloseTag(tagsMap().key(oldXml.at(oldEndPosForXml)))) {
+                    if (isCloseTagChar(oldXml.at(oldEndPosForXml))) {
                         ++oldEndPosForXml;
                         break;
                     }
@@ -480,7 +729,7 @@ public:
                     //
                     // Идём до открывающего тега
                     //
-                    if (isOpenTag(tagsMap().key(newXml.at(newStartPosForXml)))) {
+                    if (isOpenTagChar(newXml.at(newStartPosForXml))) {
                         break;
                     }
                 }
@@ -489,7 +738,7 @@ public:
                     //
                     // Идём до закрывающего тэга, он находится в конце строки
                     //
-                    if (isCloseTag(tagsMap().key(newXml.at(newEndPosForXml)))) {
+                    if (isCloseTagChar(newXml.at(newEndPosForXml))) {
                         ++newEndPosForXml;
                         break;
                     }
@@ -502,12 +751,12 @@ public:
                 //
                 const QString oldXmlPart = oldXml.left(oldStartPosForXml);
                 const int oldXmlPartLength = oldXmlPart.length();
-                const int oldPlainPartLength = ::removeXmlTagsForScenario(plainToXml(oldXmlPart), tagsMap()).length();
+                const int oldPlainPartLength = ::removeXmlTagsForScenario(plainToXml(oldXmlPart)).length();
                 int oldStartPosForPlain = oldStartPosForXml - (oldXmlPartLength - oldPlainPartLength);
                 //
                 const QString newXmlPart = newXml.left(newStartPosForXml);
                 const int newXmlPartLength = newXmlPart.length();
-                const int newPlainPartLength = ::removeXmlTagsForScenario(plainToXml(newXmlPart), tagsMap()).length();
+                const int newPlainPartLength = ::removeXmlTagsForScenario(plainToXml(newXmlPart)).length();
                 int newStartPosForPlain = newStartPosForXml - (newXmlPartLength - newPlainPartLength);
 
 
@@ -533,6 +782,8 @@ public:
 private:
     /**
      * @brief Преобразовать xml в плоский текст, заменяя тэги спецсимволами
+     * @note Текст разбирается за один проход, тэги заменяются в том числе и внутри текста блоков,
+     *       т.к. от этого зависит совместимость с патчами, сформированными ранее
      */
     static QString xmlToPlain(const QString& _xml) {
         //
@@ -540,120 +791,79 @@ private:
         //		 Может быть не самой лучшей идеей, если работают одновременно несколько авторов их
         //		 карты замен будут разными и тогда сценарии не сойдутся
         //
-        QString plain = _xml;
-        foreach (const QString& key, tagsMap().keys()) {
-            plain.replace(key, tagsMap().value(key));
+        static const QChar s_cdataStartChar = tagsChars().value(kCDataStart);
+        static const QChar s_cdataEndChar = tagsChars().value(kCDataEnd);
+
+        QString plain;
+        plain.reserve(_xml.size());
+
+        const int xmlLength = _xml.length();
+        int position = 0;
+        while (position < xmlLength) {
+            const QChar character = _xml.at(position);
+            if (character == '<') {
+                //
+                // Тэг из таблицы заменяем спецсимволом
+                //
+                if (startsWithAt(_xml, position, kCDataStart)) {
+                    plain.append(s_cdataStartChar);
+                    position += kCDataStart.size();
+                    continue;
+                }
+                int tagEnd = position + 1;
+                while (tagEnd < xmlLength
+                       && tagEnd - position < kMaxTagLength
+                       && _xml.at(tagEnd) != '>') {
+                    ++tagEnd;
+                }
+                if (tagEnd < xmlLength
+                    && _xml.at(tagEnd) == '>') {
+                    const QString tag = QString::fromRawData(_xml.constData() + position, tagEnd - position + 1);
+                    const QChar tagChar = tagsChars().value(tag);
+                    if (!tagChar.isNull()) {
+                        plain.append(tagChar);
+                        position = tagEnd + 1;
+                        continue;
+                    }
+                }
+
+                //
+                // ... а обрамление xml сценария удаляем
+                //
+                const int commonXmlTagLength = commonXmlTagLengthAt(_xml, position);
+                if (commonXmlTagLength > 0) {
+                    position += commonXmlTagLength;
+                    continue;
+                }
+            } else if (character == ']'
+                       && startsWithAt(_xml, position, kCDataEnd)) {
+                plain.append(s_cdataEndChar);
+                position += kCDataEnd.size();
+                continue;
+            }
+
+            plain.append(character);
+            ++position;
         }
-        return ::removeCommonXmlTagsForScenario(plain);
+        return plain;
     }
 
     /**
      * @brief Преобразовать плоский текст в xml, заменяя спецсимволы на тэги
      */
     static QString plainToXml(const QString& _plain) {
-        QString xml = _plain;
-        foreach (const QString& value, tagsMap().values()) {
-            xml.replace(value, tagsMap().key(value));
+        QString xml;
+        xml.reserve(_plain.size() * 2);
+        for (const QChar& character : _plain) {
+            const char* tag = tagForChar(character);
+            if (tag != nullptr) {
+                xml.append(QLatin1String(tag));
+            } else {
+                xml.append(character);
+            }
         }
         return xml;
     }
-
-    /**
-     * @brief Добавить тэг и его закрывающий аналог в карту соответствий
-     */
-    static void addTag(const QString& _tag, QHash<QString, QString>& _tagsMap, int& _index) {
-        //
-        // Для карты соответсвия используем символы юникода, которые врядли будут использоваться
-        //
-        _tagsMap.insert("<" + _tag + ">", QChar(_index++));
-        _tagsMap.insert("</" + _tag + ">", QChar(_index++));
-    }
-
-    /**
-     * @brief Карта соответствий xml-тэгов и спецсимволов
-     */
-    static const QHash<QString,QString>& tagsMap() {
-        static QHash<QString,QString> s_tagsMap;
-        static int s_charIndex = 44032;
-        if (s_tagsMap.isEmpty()) {
-            //
-            // WARNING: Добавлять новые теги, только в конец карты, ни в коем случае не в начало,
-            //			или середину, иначе это порушит совместимость со всеми предыдущими патчами
-            //
-            addTag("scene_heading", s_tagsMap, s_charIndex);
-            addTag("scene_characters", s_tagsMap, s_charIndex);
-            addTag("action", s_tagsMap, s_charIndex);
-            addTag("character", s_tagsMap, s_charIndex);
-            addTag("parenthetical", s_tagsMap, s_charIndex);
-            addTag("dialog", s_tagsMap, s_charIndex);
-            addTag("transition", s_tagsMap, s_charIndex);
-            addTag("note", s_tagsMap, s_charIndex);
-            addTag("title_header", s_tagsMap, s_charIndex);
-            addTag("title", s_tagsMap, s_charIndex);
-            addTag("noprintable_text", s_tagsMap, s_charIndex);
-            addTag("scene_group", s_tagsMap, s_charIndex);
-            addTag("scene_group_header", s_tagsMap, s_charIndex);
-            addTag("scene_group_footer", s_tagsMap, s_charIndex);
-            addTag("folder", s_tagsMap, s_charIndex);
-            addTag("folder_header", s_tagsMap, s_charIndex);
-            addTag("folder_footer", s_tagsMap, s_charIndex);
-
-            s_tagsMap.insert("<v><![CDATA[", QChar(s_charIndex++));
-            s_tagsMap.insert("]]></v>", QChar(s_charIndex++));
-
-            addTag("scene_description", s_tagsMap, s_charIndex);
-            addTag("undefined", s_tagsMap, s_charIndex);
-            addTag("lyrics", s_tagsMap, s_charIndex);
-
-            /*
-                ("<scene_heading>", "가")
-                ("</scene_heading>", "각")
-                ("<scene_characters>", "갂")
-                ("</scene_characters>", "갃")
-                ("<action>", "간")
-                ("</action>", "갅")
-                ("<character>", "갆")
-                ("</character>", "갇")
-                ("<parenthetical>", "갈")
-                ("</parenthetical>", "갉")
-                ("<dialog>", "갊")
-                ("</dialog>", "갋")
-                ("<transition>", "갌")
-                ("</transition>", "갍")
-                ("<note>", "갎"))
-                ("</note>", "갏")
-                ("<title_header>", "감")
-                ("</title_header>", "갑")
-                ("<title>", "값")
-                ("</title>", "갓")
-                ("<noprintable_text>", "갔")
-                ("</noprintable_text>", "강")
-                ("<scene_group>", "갖")
-                ("</scene_group>", "갗")
-                ("<scene_group_header>", "갘")
-                ("</scene_group_header>", "같")
-                ("<scene_group_footer>", "갚")
-                ("</scene_group_footer>", "갛")
-                ("<folder>", "개")
-                ("</folder>", "객")
-                ("<folder_header>", "갞")
-                ("</folder_header>", "갟")
-                ("<folder_footer>", "갠")
-                ("</folder_footer>", "갡")
-
-                ("<v><![CDATA[", "갢")
-                ("]]></v>", "갣")
-
-                ("<scene_description>", "갤")
-                ("</scene_description>", "갥")
-                ("<undefined>", "갦")
-                ("</undefined>", "갧")
-                ("<lirycs>", "갨")
-                ("</lirycs>", "갩")
-             */
-        }
-        return s_tagsMap;
-    }
 };
 
 #endif // DIFFMATCHPATCHHELPER
@@ -0,0 +1,25 @@
+#ifndef TREAPHELPER_H
+#define TREAPHELPER_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Вспомогательные функции для работы с декартовыми деревьями
+ */
+class TreapHelper {
+public:
+    /**
+     * @brief Сгенерировать приоритет узла
+     * @note Используется генератор xorshift, т.к. от приоритетов нужна лишь равномерность,
+     *       а не криптостойкость. Вызывать следует только из потока документа
+     */
+    static quint32 nextPriority() {
+        static quint32 s_state = 2463534242u;
+        s_state ^= s_state << 13;
+        s_state ^= s_state >> 17;
+        s_state ^= s_state << 5;
+        return s_state;
+    }
+};
+
+#endif // TREAPHELPER_H
@@ -38,6 +38,7 @@
 ****************************************************************************/
 
 #include "PageTextEdit_p.h"
+#include "PageTextLayout.h"
 #include "qlineedit.h"
 #include "qtextbrowser.h"
 
@@ -1535,45 +1536,14 @@ void PageTextEditPrivate::updateDocumentGeometry()
     Q_Q(PageTextEdit);
 
     //
-    // Определим размер документа
-    //
-    QSizeF documentSize(q->width() - vbar->width(), -1);
-    if (m_usePageMode) {
-        int pageWidth = m_pageMetrics.pxPageSize().width();
-        int pageHeight = m_pageMetrics.pxPageSize().height();
-        documentSize = QSizeF(pageWidth, pageHeight);
-    }
-
-    //
-    // Обновим размер документа
+    // Документ настраивается так же, как и для компоновки без редактора, только вне
+    // постраничного режима ширина страницы равна ширине редактора, а высота не ограничена
     //
     QTextDocument* doc = control->document();
-    if (doc->pageSize() != documentSize) {
-        doc->setPageSize(documentSize);
-    }
-
-    //
-    // Заодно и отступы настроим
-    //
-    // ... у документа уберём их
-    //
-    if (doc->documentMargin() != 0) {
-        doc->setDocumentMargin(0);
-    }
-    //
-    // ... и настроим поля документа
-    //
-    QMarginsF rootFrameMargins = m_pageMetrics.pxPageMargins();
-    QTextFrameFormat rootFrameFormat = doc->rootFrame()->frameFormat();
-    if (rootFrameFormat.leftMargin() != rootFrameMargins.left()
-        || rootFrameFormat.topMargin() != rootFrameMargins.top()
-        || rootFrameFormat.rightMargin() != rootFrameMargins.right()
-        || rootFrameFormat.bottomMargin() != rootFrameMargins.bottom()) {
-        rootFrameFormat.setLeftMargin(rootFrameMargins.left());
-        rootFrameFormat.setTopMargin(rootFrameMargins.top());
-        rootFrameFormat.setRightMargin(rootFrameMargins.right());
-        rootFrameFormat.setBottomMargin(rootFrameMargins.bottom());
-        doc->rootFrame()->setFrameFormat(rootFrameFormat);
+    if (m_usePageMode) {
+        PageTextLayout::setupDocument(doc, m_pageMetrics);
+    } else {
+        PageTextLayout::setupDocument(doc, m_pageMetrics, QSizeF(q->width() - vbar->width(), -1));
     }
 }
 
@@ -0,0 +1,73 @@
+#include "PageTextLayout.h"
+
+#include "PageMetrics.h"
+
+#include <QAbstractTextDocumentLayout>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextFrame>
+#include <QTextLayout>
+
+
+void PageTextLayout::setupDocument(QTextDocument* _document, const PageMetrics& _pageMetrics)
+{
+    //
+    // Размер страницы округляем так же, как и в редакторе, чтобы разбивка на страницы совпадала
+    //
+    const int pageWidth = _pageMetrics.pxPageSize().width();
+    const int pageHeight = _pageMetrics.pxPageSize().height();
+    setupDocument(_document, _pageMetrics, QSizeF(pageWidth, pageHeight));
+}
+
+void PageTextLayout::setupDocument(QTextDocument* _document, const PageMetrics& _pageMetrics,
+    const QSizeF& _pageSize)
+{
+    if (_document->pageSize() != _pageSize) {
+        _document->setPageSize(_pageSize);
+    }
+
+    //
+    // У самого документа отступы убираем
+    //
+    if (_document->documentMargin() != 0) {
+        _document->setDocumentMargin(0);
+    }
+    //
+    // ... и настраиваем поля документа
+    //
+    const QMarginsF rootFrameMargins = _pageMetrics.pxPageMargins();
+    QTextFrameFormat rootFrameFormat = _document->rootFrame()->frameFormat();
+    if (rootFrameFormat.leftMargin() != rootFrameMargins.left()
+        || rootFrameFormat.topMargin() != rootFrameMargins.top()
+        || rootFrameFormat.rightMargin() != rootFrameMargins.right()
+        || rootFrameFormat.bottomMargin() != rootFrameMargins.bottom()) {
+        rootFrameFormat.setLeftMargin(rootFrameMargins.left());
+        rootFrameFormat.setTopMargin(rootFrameMargins.top());
+        rootFrameFormat.setRightMargin(rootFrameMargins.right());
+        rootFrameFormat.setBottomMargin(rootFrameMargins.bottom());
+        _document->rootFrame()->setFrameFormat(rootFrameFormat);
+    }
+}
+
+int PageTextLayout::cursorPage(const QTextCursor& _cursor)
+{
+    const QTextDocument* document = _cursor.document();
+    if (document == nullptr
+        || document->pageSize().height() <= 0) {
+        return 1;
+    }
+
+    //
+    // Верхняя граница курсора определяется так же, как и в редакторе - по позиции блока
+    // и строки, в которой находится курсор
+    //
+    const QTextBlock block = _cursor.block();
+    qreal cursorTop = document->documentLayout()->blockBoundingRect(block).top();
+    const QTextLine line = block.layout()->lineForTextPosition(_cursor.positionInBlock());
+    if (line.isValid()) {
+        cursorTop += line.y();
+    }
+
+    return cursorTop / document->pageSize().height() + 1;
+}
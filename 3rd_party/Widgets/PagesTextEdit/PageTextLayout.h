@@ -0,0 +1,42 @@
+#ifndef PAGETEXTLAYOUT_H
+#define PAGETEXTLAYOUT_H
+
+class PageMetrics;
+class QSizeF;
+class QTextCursor;
+class QTextDocument;
+
+
+/**
+ * @brief Постраничная компоновка текстового документа без использования текстового редактора
+ *
+ * Настраивает документ так же, как это делает PageTextEdit в постраничном режиме, поэтому
+ * разбивка на страницы совпадает с редактором, но не требует создания виджетов и может
+ * использоваться при экспорте и формировании статистики
+ *
+ * @note Компоновка текста обращается к шрифтам, поэтому использовать только в потоке интерфейса
+ */
+class PageTextLayout
+{
+public:
+    /**
+     * @brief Настроить размер страницы и поля документа
+     */
+    static void setupDocument(QTextDocument* _document, const PageMetrics& _pageMetrics);
+
+    /**
+     * @brief Настроить документ с заданным размером страницы и полями из параметров страницы
+     * @note Используется редактором и вне постраничного режима, где ширина страницы равна ширине
+     *       редактора, а высота не ограничена
+     */
+    static void setupDocument(QTextDocument* _document, const PageMetrics& _pageMetrics,
+        const QSizeF& _pageSize);
+
+    /**
+     * @brief Получить номер страницы, на которой находится курсор
+     * @note Документ курсора должен быть настроен для постраничной компоновки
+     */
+    static int cursorPage(const QTextCursor& _cursor);
+};
+
+#endif // PAGETEXTLAYOUT_H
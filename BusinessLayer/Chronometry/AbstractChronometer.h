@@ -3,11 +3,37 @@
 
 #include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
 
-class QString;
+#include <QString>
 
 
 namespace BusinessLogic
 {
+    /**
+     * @brief Данные блока, по которым рассчитывается хронометраж
+     * @note Не ссылаются на документ, поэтому рассчитывать по ним можно в любом потоке
+     */
+    struct ChronometerBlock {
+        /**
+         * @brief Тип блока
+         */
+        ScenarioBlockStyle::Type type = ScenarioBlockStyle::Undefined;
+
+        /**
+         * @brief Текст блока, или его часть, длительность которой рассчитывается
+         */
+        QString text;
+
+        /**
+         * @brief Высота блока на странице
+         */
+        qreal height = 0;
+
+        /**
+         * @brief Высота области текста на странице, или 0, если документ не разбит на страницы
+         */
+        qreal pageHeight = 0;
+    };
+
     /**
      * @brief Базовый класс рассчёта хронометража
      */
@@ -21,10 +47,24 @@ namespace BusinessLogic
          */
         virtual QString name() const = 0;
 
+        /**
+         * @brief Загрузить параметры хронометража из настроек
+         * @note Вызывается при изменении настроек, чтобы не обращаться к ним при расчёте каждого блока
+         */
+        virtual void loadSettings() = 0;
+
+        /**
+         * @brief Получить строку с загруженными параметрами хронометража
+         * @note Меняется только при изменении параметров, влияющих на расчёт
+         */
+        virtual QString settingsKey() const = 0;
+
         /**
          * @brief Подсчитать длительность заданного текста определённого типа
+         * @note Параметры хронометра не изменяются после загрузки, поэтому рассчитывать
+         *       можно в любом потоке
          */
-        virtual qreal calculateFrom(const QTextBlock& _block, int _from, int _length) const = 0;
+        virtual qreal calculate(const ChronometerBlock& _block) const = 0;
     };
 }
 
@@ -3,8 +3,6 @@
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
 #include <DataLayer/DataStorageLayer/SettingsStorage.h>
 
-#include <QTextBlock>
-
 using namespace DataStorageLayer;
 using namespace BusinessLogic;
 
@@ -18,19 +16,8 @@ QString CharactersChronometer::name() const
     return "characters-chronometer";
 }
 
-qreal CharactersChronometer::calculateFrom(const QTextBlock& _block, int _from, int _length) const
+void CharactersChronometer::loadSettings()
 {
-    //
-    // Не включаем в хронометраж непечатный текст, заголовок и окончание папки, а также описание сцены
-    //
-    const ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(_block);
-    if (blockType == ScenarioBlockStyle::NoprintableText
-        || blockType == ScenarioBlockStyle::FolderHeader
-        || blockType == ScenarioBlockStyle::FolderFooter
-        || blockType == ScenarioBlockStyle::SceneDescription) {
-        return 0;
-    }
-
     //
     // Рассчитаем длительность одного символа
     //
@@ -44,22 +31,41 @@ qreal CharactersChronometer::calculateFrom(const QTextBlock& _block, int _from,
                 "chronometry/characters/seconds",
                 SettingsStorage::ApplicationSettings)
             .toInt();
-    const bool considerSpaces =
+    m_considerSpaces =
             StorageFacade::settingsStorage()->value(
                 "chronometry/characters/consider-spaces",
                 SettingsStorage::ApplicationSettings)
             .toInt();
-    const qreal characterChron = seconds / characters;
+    m_secondsPerCharacter = seconds / characters;
+}
+
+QString CharactersChronometer::settingsKey() const
+{
+    return QString("%1#%2").arg(m_secondsPerCharacter).arg(int(m_considerSpaces));
+}
+
+qreal CharactersChronometer::calculate(const ChronometerBlock& _block) const
+{
+    //
+    // Не включаем в хронометраж непечатный текст, заголовок и окончание папки, а также описание сцены
+    //
+    const ScenarioBlockStyle::Type blockType = _block.type;
+    if (blockType == ScenarioBlockStyle::NoprintableText
+        || blockType == ScenarioBlockStyle::FolderHeader
+        || blockType == ScenarioBlockStyle::FolderFooter
+        || blockType == ScenarioBlockStyle::SceneDescription) {
+        return 0;
+    }
 
     //
     // Рассчитаем длительность текста
     //
-    QString textForChron = _block.text().mid(_from, _length);
+    QString textForChron = _block.text;
     textForChron = textForChron.remove("\n").simplified();
-    if (!considerSpaces) {
+    if (!m_considerSpaces) {
         textForChron = textForChron.remove(" ");
     }
 
-    const qreal textChron = textForChron.length() * characterChron;
+    const qreal textChron = textForChron.length() * m_secondsPerCharacter;
     return textChron;
 }
@@ -19,10 +19,31 @@ namespace BusinessLogic
          */
         QString name() const override;
 
+        /**
+         * @brief Загрузить параметры хронометража из настроек
+         */
+        void loadSettings() override;
+
+        /**
+         * @brief Получить строку с загруженными параметрами хронометража
+         */
+        QString settingsKey() const override;
+
         /**
          * @brief Подсчитать длительность заданного текста определённого типа
          */
-        qreal calculateFrom(const QTextBlock& _block, int _from, int _length) const override;
+        qreal calculate(const ChronometerBlock& _block) const override;
+
+    private:
+        /**
+         * @brief Длительность одного символа в секундах
+         */
+        qreal m_secondsPerCharacter = 0;
+
+        /**
+         * @brief Учитывать ли пробелы
+         */
+        bool m_considerSpaces = false;
     };
 }
 
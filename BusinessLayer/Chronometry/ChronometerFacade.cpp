@@ -5,23 +5,64 @@
 #include "CharactersChronometer.h"
 #include "ConfigurableChronometer.h"
 
+#include <BusinessLayer/ScenarioDocument/ScenarioTextBlockInfo.h>
+
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
 #include <DataLayer/DataStorageLayer/SettingsStorage.h>
 
 #include <QTextDocument>
 #include <QTextCursor>
 #include <QTextBlock>
+#include <QTextFrame>
+#include <QTextLayout>
 #include <QTime>
 
 using namespace DataStorageLayer;
 using namespace BusinessLogic;
 
+namespace {
+    /**
+     * @brief Получить количество строк блока, от которого может зависеть его хронометраж
+     */
+    static int blockLinesCount(const QTextBlock& _block)
+    {
+        return _block.layout() != nullptr ? _block.layout()->lineCount() : 0;
+    }
+
+    /**
+     * @brief Получить высоту блока на странице
+     */
+    static qreal blockHeight(const QTextBlock& _block)
+    {
+        const QTextBlockFormat blockFormat = _block.blockFormat();
+        return blockFormat.lineHeight() * blockLinesCount(_block)
+                + blockFormat.topMargin()
+                + blockFormat.bottomMargin();
+    }
+
+    /**
+     * @brief Получить высоту области текста на странице документа, от которой может зависеть
+     *        хронометраж блока, или 0, если документ не разбит на страницы
+     */
+    static qreal pageTextHeight(const QTextDocument* _document)
+    {
+        if (_document == nullptr
+            || _document->pageSize().height() <= 0) {
+            return 0;
+        }
+
+        const QTextFrameFormat rootFrameFormat = _document->rootFrame()->frameFormat();
+        return _document->pageSize().height()
+                - rootFrameFormat.topMargin()
+                - rootFrameFormat.bottomMargin();
+    }
+}
+
 
 bool ChronometerFacade::chronometryUsed()
 {
-    return StorageFacade::settingsStorage()->value(
-                "chronometry/used",
-                SettingsStorage::ApplicationSettings).toInt();
+    updateSettings();
+    return s_chronometryUsed;
 }
 
 qreal ChronometerFacade::calculate(const QTextBlock& _block)
@@ -70,9 +111,15 @@ qreal ChronometerFacade::calculate(QTextDocument* _document, int _fromCursorPosi
                     //
                     // Посчитать его хронометраж, добавив к результату
                     //
-                    const int from = cursor.selectionStart() - cursor.block().position();
+                    const QTextBlock block = cursor.block();
+                    const int from = cursor.selectionStart() - block.position();
                     const int length = cursor.selectionEnd() - cursor.selectionStart();
-                    chronometry += chronometer()->calculateFrom(cursor.block(), from, length);
+                    if (from == 0
+                        && length == block.length() - 1) {
+                        chronometry += calculateFull(block);
+                    } else {
+                        chronometry += chronometer()->calculate(chronometerBlock(block, from, length));
+                    }
                     cursor.clearSelection();
                 }
             } while (!cursor.atEnd()
@@ -88,6 +135,51 @@ qreal ChronometerFacade::calculate(QTextDocument* _document)
     return calculate(_document, 0, _document->characterCount());
 }
 
+qreal ChronometerFacade::calculateFull(const QTextBlock& _block)
+{
+    const QSharedPointer<const AbstractChronometer> currentChronometer = chronometer();
+
+    //
+    // Используем закэшированный хронометраж, если с момента его расчёта не изменились
+    // ни сам блок, ни его раскладка на строки, ни геометрия страницы, ни параметры хронометража
+    //
+    TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(_block.userData());
+    const int linesCount = blockLinesCount(_block);
+    const qreal pageHeight = pageTextHeight(_block.document());
+    if (blockInfo != nullptr
+        && blockInfo->hasDuration(_block.revision(), s_chronometerRevision, linesCount, pageHeight)) {
+        return blockInfo->duration();
+    }
+
+    const qreal duration = currentChronometer->calculate(chronometerBlock(_block));
+    if (blockInfo != nullptr) {
+        blockInfo->setDuration(duration, _block.revision(), s_chronometerRevision, linesCount, pageHeight);
+    }
+    return duration;
+}
+
+ChronometerBlock ChronometerFacade::chronometerBlock(const QTextBlock& _block, int _from, int _length)
+{
+    ChronometerBlock block;
+    block.type = ScenarioBlockStyle::forBlock(_block);
+    block.text = _from == 0 && _length == -1 ? _block.text() : _block.text().mid(_from, _length);
+    block.height = blockHeight(_block);
+    block.pageHeight = pageTextHeight(_block.document());
+    return block;
+}
+
+QSharedPointer<const AbstractChronometer> ChronometerFacade::chronometer()
+{
+    updateSettings();
+    return s_chronometer;
+}
+
+int ChronometerFacade::chronometerRevision()
+{
+    updateSettings();
+    return s_chronometerRevision;
+}
+
 QString ChronometerFacade::secondsToTime(int _seconds)
 {
     QString timeString = "0:00";
@@ -107,8 +199,22 @@ QString ChronometerFacade::secondsToTime(qreal _seconds)
     return secondsToTime(qRound(_seconds));
 }
 
-AbstractChronometer* ChronometerFacade::chronometer()
+void ChronometerFacade::updateSettings()
 {
+    //
+    // Параметры хронометража загружаются только после изменения настроек
+    //
+    const int settingsRevision = StorageFacade::settingsStorage()->revision();
+    if (!s_chronometer.isNull()
+        && s_settingsRevision == settingsRevision) {
+        return;
+    }
+
+    s_chronometryUsed =
+            StorageFacade::settingsStorage()->value(
+                "chronometry/used",
+                SettingsStorage::ApplicationSettings).toInt();
+
     static QString CHRONOMETRY_TYPE_KEY = "chronometry/current-chronometer-type";
     static QString CHRONOMETRY_PAGES = PagesChronometer().name();
     static QString CHRONOMETRY_CHARACTERS = CharactersChronometer().name();
@@ -131,30 +237,38 @@ AbstractChronometer* ChronometerFacade::chronometer()
     }
 
     //
-    // Проверить какой используется
-    // Если нужно создать необходимый
+    // Создаём необходимый хронометр заново, а не загружаем параметры в текущий,
+    // т.к. текущим может пользоваться другой поток
     //
+    AbstractChronometer* newChronometer = nullptr;
     if (chronometryType == CHRONOMETRY_PAGES) {
-        if (s_chronometer == 0
-            || s_chronometer->name() != CHRONOMETRY_PAGES) {
-            delete s_chronometer;
-            s_chronometer = new PagesChronometer;
-        }
+        newChronometer = new PagesChronometer;
     } else if (chronometryType == CHRONOMETRY_CHARACTERS) {
-        if (s_chronometer == 0
-            || s_chronometer->name() != CHRONOMETRY_CHARACTERS) {
-            delete s_chronometer;
-            s_chronometer = new CharactersChronometer;
-        }
+        newChronometer = new CharactersChronometer;
     } else {
-        if (s_chronometer == 0
-            || s_chronometer->name() != CHRONOMETRY_CONFIGURABLE) {
-            delete s_chronometer;
-            s_chronometer = new ConfigurableChronometer;
-        }
+        newChronometer = new ConfigurableChronometer;
     }
+    newChronometer->loadSettings();
+    s_chronometer.reset(newChronometer);
 
-    return s_chronometer;
+    //
+    // Закэшированный хронометраж блоков сбрасываем только если изменились параметры хронометража,
+    // а не любые другие настройки
+    //
+    const QString chronometerSettingsKey = s_chronometer->name() + "#" + s_chronometer->settingsKey();
+    if (s_chronometerSettingsKey != chronometerSettingsKey) {
+        s_chronometerSettingsKey = chronometerSettingsKey;
+        ++s_chronometerRevision;
+    }
+
+    //
+    // Запоминаем ревизию после загрузки, т.к. при загрузке могут быть сохранены значения по умолчанию
+    //
+    s_settingsRevision = StorageFacade::settingsStorage()->revision();
 }
 
-AbstractChronometer* ChronometerFacade::s_chronometer = 0;
+QSharedPointer<const AbstractChronometer> ChronometerFacade::s_chronometer;
+bool ChronometerFacade::s_chronometryUsed = false;
+int ChronometerFacade::s_settingsRevision = -1;
+QString ChronometerFacade::s_chronometerSettingsKey;
+int ChronometerFacade::s_chronometerRevision = 0;
@@ -1,6 +1,7 @@
 #ifndef CHRONOMETERFACADE_H
 #define CHRONOMETERFACADE_H
 
+#include <QSharedPointer>
 #include <QString>
 
 class QTextBlock;
@@ -9,6 +10,7 @@ class QTextDocument;
 namespace BusinessLogic
 {
 	class AbstractChronometer;
+	struct ChronometerBlock;
 
 
 	/**
@@ -42,6 +44,31 @@ namespace BusinessLogic
 		 */
 		static qreal calculate(QTextDocument* _document);
 
+		/**
+		 * @brief Вычислить хронометраж блока целиком
+		 * @note Не проверяет, используется ли хронометраж. Хронометраж кэшируется в блоке
+		 *		 до изменения блока, геометрии страницы или параметров хронометража
+		 */
+		static qreal calculateFull(const QTextBlock& _block);
+
+		/**
+		 * @brief Получить данные блока, по которым рассчитывается хронометраж заданной части его текста
+		 * @param _length - длина части текста, или -1, если часть продолжается до конца блока
+		 */
+		static ChronometerBlock chronometerBlock(const QTextBlock& _block, int _from = 0, int _length = -1);
+
+		/**
+		 * @brief Получить текущий хронометр
+		 * @note Хронометр не изменяется после создания, а при изменении настроек создаётся новый,
+		 *		 поэтому полученным хронометром можно пользоваться в другом потоке
+		 */
+		static QSharedPointer<const AbstractChronometer> chronometer();
+
+		/**
+		 * @brief Ревизия параметров хронометража, увеличивается при их изменении
+		 */
+		static int chronometerRevision();
+
 		/**
 		 * @brief Получить строковое представление для заданного количества секунд
 		 */
@@ -52,15 +79,33 @@ namespace BusinessLogic
 
 	private:
 		/**
-		 * @brief Получить необходимый для использования хронометр
+		 * @brief Загрузить настройки хронометража, если они изменились с момента последней загрузки
 		 */
-		static AbstractChronometer* chronometer();
+		static void updateSettings();
 
 	private:
 		/**
 		 * @brief Текущий хронометр
 		 */
-		static AbstractChronometer* s_chronometer;
+		static QSharedPointer<const AbstractChronometer> s_chronometer;
+
+		/**
+		 * @brief Используется ли хронометраж
+		 */
+		static bool s_chronometryUsed;
+
+		/**
+		 * @brief Ревизия настроек, для которой загружены параметры хронометража
+		 */
+		static int s_settingsRevision;
+
+		/**
+		 * @brief Загруженные параметры хронометража и ревизия, увеличивающаяся при их изменении
+		 */
+		/** @{ */
+		static QString s_chronometerSettingsKey;
+		static int s_chronometerRevision;
+		/** @} */
 	};
 }
 
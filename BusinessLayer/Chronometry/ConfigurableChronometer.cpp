@@ -3,8 +3,6 @@
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
 #include <DataLayer/DataStorageLayer/SettingsStorage.h>
 
-#include <QTextBlock>
-
 using namespace DataStorageLayer;
 using namespace BusinessLogic;
 
@@ -18,11 +16,41 @@ QString ConfigurableChronometer::name() const
     return "configurable-chronometer";
 }
 
-qreal ConfigurableChronometer::calculateFrom(const QTextBlock& _block, int _from, int _length) const
+void ConfigurableChronometer::loadSettings()
 {
-    Q_UNUSED(_from);
+    auto loadBlockDuration = [] (const QString& _blockKey) {
+        const int every50 = 50;
+        BlockDuration duration;
+        duration.secondsForParagraph =
+                StorageFacade::settingsStorage()->value(
+                    "chronometry/configurable/seconds-for-paragraph/" + _blockKey,
+                    SettingsStorage::ApplicationSettings)
+                .toDouble();
+        duration.secondsPerCharacter =
+                StorageFacade::settingsStorage()->value(
+                    "chronometry/configurable/seconds-for-every-50/" + _blockKey,
+                    SettingsStorage::ApplicationSettings)
+                .toDouble() / every50;
+        return duration;
+    };
+
+    m_sceneHeadingDuration = loadBlockDuration("scene_heading");
+    m_actionDuration = loadBlockDuration("action");
+    m_dialogueDuration = loadBlockDuration("dialog");
+}
+
+QString ConfigurableChronometer::settingsKey() const
+{
+    QString key;
+    for (const BlockDuration& duration : { m_sceneHeadingDuration, m_actionDuration, m_dialogueDuration }) {
+        key += QString("%1#%2#").arg(duration.secondsForParagraph).arg(duration.secondsPerCharacter);
+    }
+    return key;
+}
 
-    const ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(_block);
+qreal ConfigurableChronometer::calculate(const ChronometerBlock& _block) const
+{
+    const ScenarioBlockStyle::Type blockType = _block.type;
     if (blockType != ScenarioBlockStyle::SceneHeading
         && blockType != ScenarioBlockStyle::Action
         && blockType != ScenarioBlockStyle::Dialogue
@@ -33,40 +61,14 @@ qreal ConfigurableChronometer::calculateFrom(const QTextBlock& _block, int _from
     //
     // Длительность зависит от блока
     //
-    qreal secondsForParagraph = 0;
-    qreal secondsForEvery50 = 0;
-    QString secondsForParagraphKey;
-    QString secondsForEvery50Key;
-
+    const BlockDuration* duration = &m_sceneHeadingDuration;
     if (blockType == ScenarioBlockStyle::Action) {
-        secondsForParagraphKey = "chronometry/configurable/seconds-for-paragraph/action";
-        secondsForEvery50Key = "chronometry/configurable/seconds-for-every-50/action";
+        duration = &m_actionDuration;
     } else if (blockType == ScenarioBlockStyle::Dialogue
                || blockType == ScenarioBlockStyle::Lyrics) {
-        secondsForParagraphKey = "chronometry/configurable/seconds-for-paragraph/dialog";
-        secondsForEvery50Key = "chronometry/configurable/seconds-for-every-50/dialog";
-    } else {
-        secondsForParagraphKey = "chronometry/configurable/seconds-for-paragraph/scene_heading";
-        secondsForEvery50Key = "chronometry/configurable/seconds-for-every-50/scene_heading";
+        duration = &m_dialogueDuration;
     }
 
-    //
-    // Получим значения длительности
-    //
-    secondsForParagraph =
-            StorageFacade::settingsStorage()->value(
-                secondsForParagraphKey,
-                SettingsStorage::ApplicationSettings)
-            .toDouble();
-
-    secondsForEvery50 =
-            StorageFacade::settingsStorage()->value(
-                secondsForEvery50Key,
-                SettingsStorage::ApplicationSettings)
-            .toDouble();
-
-    const int every50 = 50;
-    const qreal secondsPerCharacter = secondsForEvery50 / every50;
-    const qreal textChron = secondsForParagraph + _length * secondsPerCharacter;
+    const qreal textChron = duration->secondsForParagraph + _block.text.length() * duration->secondsPerCharacter;
     return textChron;
 }
@@ -19,10 +19,38 @@ namespace BusinessLogic
          */
         QString name() const override;
 
+        /**
+         * @brief Загрузить параметры хронометража из настроек
+         */
+        void loadSettings() override;
+
+        /**
+         * @brief Получить строку с загруженными параметрами хронометража
+         */
+        QString settingsKey() const override;
+
         /**
          * @brief Подсчитать длительность заданного текста определённого типа
          */
-        qreal calculateFrom(const QTextBlock& _block, int _from, int _length) const override;
+        qreal calculate(const ChronometerBlock& _block) const override;
+
+    private:
+        /**
+         * @brief Параметры длительности блоков одного типа
+         */
+        struct BlockDuration {
+            qreal secondsForParagraph = 0;
+            qreal secondsPerCharacter = 0;
+        };
+
+        /**
+         * @brief Параметры длительности заголовков сцен, описаний действия и реплик
+         */
+        /** @{ */
+        BlockDuration m_sceneHeadingDuration;
+        BlockDuration m_actionDuration;
+        BlockDuration m_dialogueDuration;
+        /** @} */
     };
 }
 
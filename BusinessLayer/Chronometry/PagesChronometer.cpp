@@ -3,9 +3,6 @@
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
 #include <DataLayer/DataStorageLayer/SettingsStorage.h>
 
-#include <QTextBlock>
-#include <QTextDocument>
-
 using namespace DataStorageLayer;
 using namespace BusinessLogic;
 
@@ -59,15 +56,26 @@ QString PagesChronometer::name() const
     return "pages-chronometer";
 }
 
-qreal PagesChronometer::calculateFrom(const QTextBlock& _block, int _from, int _lenght) const
+void PagesChronometer::loadSettings()
+{
+    m_secondsPerPage =
+            StorageFacade::settingsStorage()->value(
+                "chronometry/pages/seconds",
+                SettingsStorage::ApplicationSettings)
+            .toInt();
+}
+
+QString PagesChronometer::settingsKey() const
 {
-    Q_UNUSED(_from);
-    Q_UNUSED(_lenght);
+    return QString::number(m_secondsPerPage);
+}
 
+qreal PagesChronometer::calculate(const ChronometerBlock& _block) const
+{
     //
     // Не включаем в хронометраж непечатный текст, заголовок и окончание папки, а также описание сцены
     //
-    const ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(_block);
+    const ScenarioBlockStyle::Type blockType = _block.type;
     if (blockType == ScenarioBlockStyle::NoprintableText
         || blockType == ScenarioBlockStyle::FolderHeader
         || blockType == ScenarioBlockStyle::FolderFooter
@@ -75,40 +83,14 @@ qreal PagesChronometer::calculateFrom(const QTextBlock& _block, int _from, int _
         return 0;
     }
 
-    //
-    // Получим значение длительности одной страницы текста
-    //
-    const qreal seconds =
-            StorageFacade::settingsStorage()->value(
-                "chronometry/pages/seconds",
-                SettingsStorage::ApplicationSettings)
-            .toInt();
+    const qreal seconds = m_secondsPerPage;
 
     //
     // Если работаем в постраничном режиме, то определяем хронометраж по факту
     //
     qreal chron = 0.0;
-    if (_block.document()->pageSize().height() > 0) {
-        //
-        // Определить высоту текущего блока
-        //
-        const QTextBlockFormat blockFormat = _block.blockFormat();
-        const qreal blockLineHeight = blockFormat.lineHeight();
-        const int blockLineCount = _block.layout()->lineCount();
-        //
-        // ... если блок первый на странице, то для него не нужно учитывать верхний отступ
-        //
-        const qreal blockHeight = blockLineHeight * blockLineCount + blockFormat.topMargin() + blockFormat.bottomMargin();
-
-        //
-        // Определим высоту страницы
-        //
-        const QTextFrameFormat rootFrameFormat = _block.document()->rootFrame()->frameFormat();
-        const qreal pageHeight = _block.document()->pageSize().height()
-                                 - rootFrameFormat.topMargin()
-                                 - rootFrameFormat.bottomMargin();
-
-        chron = blockHeight * seconds / pageHeight;
+    if (_block.pageHeight > 0) {
+        chron = _block.height * seconds / _block.pageHeight;
     }
     //
     // В противном случае, считаем по символам как раньше и было
@@ -160,7 +142,7 @@ qreal PagesChronometer::calculateFrom(const QTextBlock& _block, int _from, int _
         //
         // Подсчитаем хронометраж
         //
-        const QString text = _block.text().mid(_from, _lenght);
+        const QString& text = _block.text;
         const float linesPerPage = 54;
         const float lineChron = seconds / linesPerPage;
         chron = (qreal)(linesInText(text, lineLength) + additionalLines) * lineChron;
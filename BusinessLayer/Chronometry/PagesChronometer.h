@@ -19,10 +19,26 @@ namespace BusinessLogic
          */
         QString name() const override;
 
+        /**
+         * @brief Загрузить параметры хронометража из настроек
+         */
+        void loadSettings() override;
+
+        /**
+         * @brief Получить строку с загруженными параметрами хронометража
+         */
+        QString settingsKey() const override;
+
         /**
          * @brief Подсчитать длительность заданного текста определённого типа
          */
-        qreal calculateFrom(const QTextBlock& _block, int _from, int _lenght) const override;
+        qreal calculate(const ChronometerBlock& _block) const override;
+
+    private:
+        /**
+         * @brief Длительность одной страницы текста в секундах
+         */
+        qreal m_secondsPerPage = 0;
     };
 }
 
@@ -88,6 +88,30 @@ namespace BusinessLogic
 	{
 		return !(lhs == rhs);
 	}
+
+	/**
+	 * @brief Сложить два счётчика
+	 */
+	inline Counter operator +(const Counter& lhs, const Counter& rhs)
+	{
+		Counter result = lhs;
+		result.addWords(rhs.words());
+		result.addCharactersWithSpaces(rhs.charactersWithSpaces());
+		result.addCharactersWithoutSpaces(rhs.charactersWithoutSpaces());
+		return result;
+	}
+
+	/**
+	 * @brief Вычесть один счётчик из другого
+	 */
+	inline Counter operator -(const Counter& lhs, const Counter& rhs)
+	{
+		Counter result = lhs;
+		result.addWords(-rhs.words());
+		result.addCharactersWithSpaces(-rhs.charactersWithSpaces());
+		result.addCharactersWithoutSpaces(-rhs.charactersWithoutSpaces());
+		return result;
+	}
 }
 
 #endif // COUNTER
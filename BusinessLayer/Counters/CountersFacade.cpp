@@ -3,18 +3,19 @@
 #include "Counter.h"
 
 #include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextBlockInfo.h>
 
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
 #include <DataLayer/DataStorageLayer/SettingsStorage.h>
 
 #include <QApplication>
 #include <QTextBlock>
-#include <QTextCursor>
 #include <QTextDocument>
 
 using BusinessLogic::CountersFacade;
 using BusinessLogic::Counter;
 using BusinessLogic::ScenarioBlockStyle;
+using BusinessLogic::TextBlockInfo;
 
 
 Counter CountersFacade::calculate(QTextDocument* _document, int _fromCursorPosition, int _toCursorPosition)
@@ -22,47 +23,44 @@ Counter CountersFacade::calculate(QTextDocument* _document, int _fromCursorPosit
     //
     // Проверить какие счётчики необходимо рассчитать
     //
-    bool calculateWords =
-            DataStorageLayer::StorageFacade::settingsStorage()->value(
-                "counters/words/used",
-                DataStorageLayer::SettingsStorage::ApplicationSettings).toInt();
-    bool calculateCharacters =
-            DataStorageLayer::StorageFacade::settingsStorage()->value(
-                "counters/simbols/used",
-                DataStorageLayer::SettingsStorage::ApplicationSettings).toInt();
+    const bool calculateWords = wordsUsed();
+    const bool calculateCharacters = charactersUsed();
 
     Counter counter;
     //
     // Рассчитываем, если необходимо
     //
     if (calculateWords || calculateCharacters) {
-        //
-        // Определим текст, который необходимо обсчитать
-        //
-        QTextCursor cursor(_document);
-        cursor.setPosition(_fromCursorPosition);
-        do {
-            cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
-
-            const QTextBlock& block = cursor.block();
-            const ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(block);
-            if (block.isVisible()
-                && blockType != ScenarioBlockStyle::NoprintableText
-                && blockType != ScenarioBlockStyle::FolderHeader
-                && blockType != ScenarioBlockStyle::FolderFooter) {
-                QString text = cursor.selectedText();
-                if (calculateWords) {
-                    counter.addWords(wordsCount(text));
-                }
-                if (calculateCharacters) {
-                    counter.addCharactersWithSpaces(charactersWithSpacesCount(text));
-                    counter.addCharactersWithoutSpaces(charactersWithoutSpacesCount(text));
-                }
+        QTextBlock block = _document->findBlock(_fromCursorPosition);
+        int from = _fromCursorPosition;
+        while (block.isValid()) {
+            //
+            // Целиком входящие в промежуток блоки берём из кэша, а у первого блока, если
+            // промежуток начинается не с его начала, обсчитываем только текст после позиции
+            //
+            Counter blockCounter;
+            if (from == block.position()) {
+                blockCounter = calculateFull(block);
+            } else if (isCountable(block)) {
+                const QString blockText = block.text();
+                blockCounter = calculateText(blockText.midRef(from - block.position()));
             }
 
-            cursor.movePosition(QTextCursor::NextCharacter);
-        } while (!cursor.atEnd()
-                 && cursor.position() < _toCursorPosition);
+            if (calculateWords) {
+                counter.addWords(blockCounter.words());
+            }
+            if (calculateCharacters) {
+                counter.addCharactersWithSpaces(blockCounter.charactersWithSpaces());
+                counter.addCharactersWithoutSpaces(blockCounter.charactersWithoutSpaces());
+            }
+
+            block = block.next();
+            if (!block.isValid()
+                || block.position() >= _toCursorPosition) {
+                break;
+            }
+            from = block.position();
+        }
     }
 
     return counter;
@@ -91,30 +89,28 @@ BusinessLogic::Counter CountersFacade::calculateFull(QTextDocument* _document)
 
 BusinessLogic::Counter CountersFacade::calculateFull(const QTextBlock& _block)
 {
-    Counter counter;
     //
     // Считаем только видимые блоки
     //
-    const ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(_block);
-    if (_block.isVisible()
-        && blockType != ScenarioBlockStyle::NoprintableText
-        && blockType != ScenarioBlockStyle::FolderHeader
-        && blockType != ScenarioBlockStyle::FolderFooter) {
-        //
-        // Определим текст, который необходимо обсчитать
-        //
-        QString text = _block.text();
-        //
-        // ... слова
-        //
-        counter.setWords(wordsCount(text));
-        //
-        // ... символы
-        //
-        counter.setCharactersWithSpaces(charactersWithSpacesCount(text));
-        counter.setCharactersWithoutSpaces(charactersWithoutSpacesCount(text));
+    if (!isCountable(_block)) {
+        return Counter();
+    }
+
+    //
+    // Используем закэшированный счётчик, если блок не изменялся с момента его расчёта
+    //
+    TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(_block.userData());
+    if (blockInfo != nullptr
+        && blockInfo->hasCounter(_block.revision())
+        && blockInfo->counter().charactersWithSpaces() == _block.length() - 1) {
+        return blockInfo->counter();
     }
 
+    const QString blockText = _block.text();
+    const Counter counter = calculateText(QStringRef(&blockText));
+    if (blockInfo != nullptr) {
+        blockInfo->setCounter(counter, _block.revision());
+    }
     return counter;
 }
 
@@ -127,14 +123,8 @@ QStringList CountersFacade::countersInfo(int pageCount, const BusinessLogic::Cou
             DataStorageLayer::StorageFacade::settingsStorage()->value(
                 "counters/pages/used",
                 DataStorageLayer::SettingsStorage::ApplicationSettings).toInt();
-    bool calculateWords =
-            DataStorageLayer::StorageFacade::settingsStorage()->value(
-                "counters/words/used",
-                DataStorageLayer::SettingsStorage::ApplicationSettings).toInt();
-    bool calculateCharacters =
-            DataStorageLayer::StorageFacade::settingsStorage()->value(
-                "counters/simbols/used",
-                DataStorageLayer::SettingsStorage::ApplicationSettings).toInt();
+    bool calculateWords = wordsUsed();
+    bool calculateCharacters = charactersUsed();
     //
     // Рассчитать счётчики
     //
@@ -154,19 +144,54 @@ QStringList CountersFacade::countersInfo(int pageCount, const BusinessLogic::Cou
     return result;
 }
 
-int CountersFacade::wordsCount(const QString& _text)
+bool CountersFacade::wordsUsed()
+{
+    return
+            DataStorageLayer::StorageFacade::settingsStorage()->value(
+                "counters/words/used",
+                DataStorageLayer::SettingsStorage::ApplicationSettings).toInt();
+}
+
+bool CountersFacade::charactersUsed()
 {
-    return _text.split(" ", QString::SkipEmptyParts).count();
+    return
+            DataStorageLayer::StorageFacade::settingsStorage()->value(
+                "counters/simbols/used",
+                DataStorageLayer::SettingsStorage::ApplicationSettings).toInt();
 }
 
-int CountersFacade::charactersWithSpacesCount(const QString& _text)
+bool CountersFacade::isCountable(const QTextBlock& _block)
 {
-    return _text.size();
+    const ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(_block);
+    return _block.isVisible()
+            && blockType != ScenarioBlockStyle::NoprintableText
+            && blockType != ScenarioBlockStyle::FolderHeader
+            && blockType != ScenarioBlockStyle::FolderFooter;
 }
 
-int CountersFacade::charactersWithoutSpacesCount(const QString& _text)
+BusinessLogic::Counter CountersFacade::calculateText(const QStringRef& _text)
 {
-    return QString(_text).replace(" ", "").size();
+    //
+    // Словом считается непрерывная последовательность символов, отличных от пробела,
+    // поэтому считаем начала слов и пробелы за один проход без ветвлений и выделения памяти
+    //
+    const ushort* text = _text.utf16();
+    const int size = _text.size();
+    int words = 0;
+    int spaces = 0;
+    int isPreviousSpace = 1;
+    for (int index = 0; index < size; ++index) {
+        const int isSpace = text[index] == ' ';
+        spaces += isSpace;
+        words += isPreviousSpace & (1 - isSpace);
+        isPreviousSpace = isSpace;
+    }
+
+    Counter counter;
+    counter.setWords(words);
+    counter.setCharactersWithSpaces(size);
+    counter.setCharactersWithoutSpaces(size - spaces);
+    return counter;
 }
 
 QString CountersFacade::pageInfo(int _count)
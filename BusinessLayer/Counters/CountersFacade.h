@@ -3,6 +3,7 @@
 
 class QStringList;
 class QString;
+class QStringRef;
 class QTextBlock;
 class QTextDocument;
 
@@ -37,23 +38,29 @@ namespace BusinessLogic
 		 */
         static QStringList countersInfo(int pageCount, const Counter& _counter);
 
+		/**
+		 * @brief Используется ли счётчик слов
+		 */
+		static bool wordsUsed();
 
-	private:
 		/**
-		 * @brief Посчитать кол-во слов
+		 * @brief Используется ли счётчик символов
 		 */
-		static int wordsCount(const QString& _text);
+		static bool charactersUsed();
 
 		/**
-		 * @brief Посчитать кол-во символов с пробелами
+		 * @brief Учитывается ли блок в счётчиках
 		 */
-		static int charactersWithSpacesCount(const QString& _text);
+		static bool isCountable(const QTextBlock& _block);
 
 		/**
-		 * @brief Посчитать кол-во символов без пробелов
+		 * @brief Посчитать кол-во слов и символов в тексте
+		 * @note Не обращается к документу и настройкам, поэтому считать можно в любом потоке
 		 */
-		static int charactersWithoutSpacesCount(const QString& _text);
+		static Counter calculateText(const QStringRef& _text);
+
 
+	private:
 		/**
 		 * @brief Посчитать количество страниц
 		 */
@@ -17,7 +17,7 @@
 #include <3rd_party/Helpers/TextEditHelper.h>
 #include <3rd_party/Helpers/TextUtils.h>
 #include <3rd_party/Widgets/PagesTextEdit/PageMetrics.h>
-#include <3rd_party/Widgets/PagesTextEdit/PageTextEdit.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageTextLayout.h>
 #include <3rd_party/Widgets/QtMindMap/include/graphwidget.h>
 
 #include <QApplication>
@@ -429,13 +429,10 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
     QTextDocument* scenarioDocument = new QTextDocument;
     {
         //
-        // Используем тексовый редактор, чтобы в последствии корректно сформировать переносы блоков
+        // Настраиваем страницы документа, чтобы в последствии корректно сформировать переносы блоков
         //
-        PageTextEdit edit;
-        edit.setUsePageMode(true);
-        edit.setPageFormat(exportStyle.pageSizeId());
-        edit.setPageMargins(exportStyle.pageMargins());
-        edit.setDocument(scenarioDocument);
+        PageTextLayout::setupDocument(scenarioDocument,
+            PageMetrics(exportStyle.pageSizeId(), exportStyle.pageMargins()));
 
         //
         // Копируем содержимое
@@ -553,6 +553,11 @@ DocxExporter::DocxExporter() :
 
 void DocxExporter::exportTo(ScenarioDocument* _scenario, const ExportParameters& _exportParameters) const
 {
+    //
+    // Экспортируем только полностью загруженный сценарий
+    //
+    _scenario->document()->finishLoading();
+
     //
     // Открываем документ на запись
     //
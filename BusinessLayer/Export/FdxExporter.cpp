@@ -37,6 +37,11 @@ FdxExporter::FdxExporter() :
 
 void FdxExporter::exportTo(ScenarioDocument* _scenario, const ExportParameters& _exportParameters) const
 {
+    //
+    // Экспортируем только полностью загруженный сценарий
+    //
+    _scenario->document()->finishLoading();
+
     //
     // Открываем документ на запись
     //
@@ -1,7 +1,9 @@
 #include "FountainExporter.h"
 
+#include <BusinessLayer/ScenarioDocument/ScenarioDocument.h>
 #include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
 #include <BusinessLayer/ScenarioDocument/ScenarioTextBlockInfo.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
 
 #include <3rd_party/Helpers/TextEditHelper.h>
 
@@ -56,6 +58,11 @@ FountainExporter::FountainExporter() :
 
 void FountainExporter::exportTo(ScenarioDocument *_scenario, const ExportParameters &_exportParameters) const
 {
+    //
+    // Экспортируем только полностью загруженный сценарий
+    //
+    _scenario->document()->finishLoading();
+
     //
     // Открываем документ на запись
     //
@@ -592,6 +592,11 @@ PdfExporter::~PdfExporter()
 
 void PdfExporter::exportTo(ScenarioDocument* _scenario, const ExportParameters& _exportParameters) const
 {
+    //
+    // Экспортируем только полностью загруженный сценарий
+    //
+    _scenario->document()->finishLoading();
+
     //
     // Настроим принтер
     //
@@ -661,6 +666,11 @@ void PdfExporter::exportTo(const ResearchModelCheckableProxy* _researchModel, co
 #ifndef MOBILE_OS
 void PdfExporter::printPreview(ScenarioDocument* _scenario, const ExportParameters& _exportParameters)
 {
+    //
+    // Экспортируем только полностью загруженный сценарий
+    //
+    _scenario->document()->finishLoading();
+
     //
     // Настроим принтер
     //
@@ -75,6 +75,12 @@ namespace BusinessLogic
          */
         virtual QString importScript(const ImportParameters& _importParameters) const = 0;
 
+        /**
+         * @brief Описание ошибки последнего импорта сценария
+         * @return Пустая строка, если импорт удался
+         */
+        virtual QString lastError() const { return QString(); }
+
         /**
          * @brief Импорт данных разработки
          * @return Карта элементов разработки
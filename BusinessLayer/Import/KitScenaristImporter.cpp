@@ -1,5 +1,7 @@
 #include "KitScenaristImporter.h"
 
+#include <DataLayer/Database/ScriptBinaryFormat.h>
+
 #include <Domain/Research.h>
 
 #include <QSqlDatabase>
@@ -30,6 +32,7 @@ KitScenaristImporter::KitScenaristImporter() :
 QString KitScenaristImporter::importScript(const ImportParameters& _importParameters) const
 {
     QString result;
+    m_lastError.clear();
 
     {
         QSqlDatabase database = QSqlDatabase::addDatabase(SQL_DRIVER, CONNECTION_NAME);
@@ -38,7 +41,16 @@ QString KitScenaristImporter::importScript(const ImportParameters& _importParame
             QSqlQuery query(database);
             query.exec("SELECT text FROM scenario WHERE is_draft = 0");
             query.next();
-            result = query.record().value("text").toString();
+            //
+            // Текст может храниться в двоичном формате, если прочитать его не удалось,
+            // то ничего не импортируем, чтобы не заменить текущий сценарий пустым
+            //
+            if (!DatabaseLayer::ScriptBinaryFormat::xmlFromValue(query.record().value("text"), result)) {
+                result.clear();
+                m_lastError =
+                    QApplication::translate("BusinessLogic::KitScenaristImporter",
+                        "Script text is saved in an unsupported format. You need update application to latest version for import it.");
+            }
         }
     }
 
@@ -47,6 +59,11 @@ QString KitScenaristImporter::importScript(const ImportParameters& _importParame
     return result;
 }
 
+QString KitScenaristImporter::lastError() const
+{
+    return m_lastError;
+}
+
 QVariantMap KitScenaristImporter::importResearch(const ImportParameters& _importParameters) const
 {
     QVariantMap research;
@@ -27,6 +27,11 @@ namespace BusinessLogic
          */
         QVariantMap importResearch(const ImportParameters &_importParameters) const override;
 
+        /**
+         * @brief Описание ошибки последнего импорта сценария
+         */
+        QString lastError() const override;
+
     private:
         /**
          * @brief Загружить документ разработки из заданного запроса
@@ -37,6 +42,12 @@ namespace BusinessLogic
          * @brief Загрузить документы разработки для указанного элемента в заданной базе данных
          */
         QVariantList loadResearchDocuments(int _parentId, QSqlDatabase& _database) const;
+
+    private:
+        /**
+         * @brief Ошибка последнего импорта сценария
+         */
+        mutable QString m_lastError;
     };
 }
 
@@ -16,14 +16,24 @@
 #include <Domain/Scenario.h>
 
 #include <QCryptographicHash>
+#include <QFutureWatcher>
 #include <QRegularExpression>
 #include <QTextDocument>
 #include <QTextCursor>
 #include <QTextBlock>
 #include <QTimer>
+#include <QtConcurrent>
 
 using namespace BusinessLogic;
 
+namespace {
+    /**
+     * @brief Количество блоков документа, начиная с которого содержимое элементов дерева
+     *        формируется в фоновом потоке
+     */
+    const int kBackgroundBuildMinBlocks = 2000;
+}
+
 
 QString ScenarioDocument::MIME_TYPE = "application/x-scenarist/scenario";
 
@@ -31,7 +41,8 @@ ScenarioDocument::ScenarioDocument(QObject* _parent) :
     QObject(_parent),
     m_xmlHandler(new ScenarioXml(this)),
     m_document(new ScenarioTextDocument(this, m_xmlHandler)),
-    m_model(new ScenarioModel(this, m_xmlHandler))
+    m_model(new ScenarioModel(this, m_xmlHandler)),
+    m_itemsBuildWatcher(new QFutureWatcher<QVector<ScenarioTextSnapshot::ItemContent>>(this))
 {
     initConnections();
 }
@@ -59,35 +70,17 @@ qreal ScenarioDocument::durationAtPosition(int _position) const
         //
         // Определим сцену, в которой находится курсор
         //
-        QMap<int, ScenarioModelItem*>::const_iterator iter = m_modelItems.lowerBound(_position);
-        if (iter == m_modelItems.end()
-            || (iter.key() > _position
-                && iter != m_modelItems.begin())) {
-            --iter;
-        }
-
-        //
-        // Запомним позицию начала сцены
-        //
-        int startPositionInLastScene = iter.key();
+        ScenarioModelItem* item = m_modelItems.nearest(_position);
 
         //
-        // Посчитаем хронометраж всех предыдущих сцен
+        // Возьмём хронометраж всех предыдущих сцен из индекса
         //
-        if (iter.value()->type() == ScenarioModelItem::Scene) {
-            iter.value()->duration();
-        }
-        while (iter != m_modelItems.begin()) {
-            --iter;
-            if (iter.value()->type() == ScenarioModelItem::Scene) {
-                duration += iter.value()->duration();
-            }
-        }
+        duration += m_modelItems.durationBefore(item);
 
         //
         // Добавим к суммарному хрономертажу хронометраж от начала сцены
         //
-        duration += ChronometerFacade::calculate(m_document, startPositionInLastScene, _position);
+        duration += ChronometerFacade::calculate(m_document, item->position(), _position);
     }
 
     return duration;
@@ -149,8 +142,9 @@ QString ScenarioDocument::itemUuid(ScenarioModelItem* _item) const
     SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(textBlockData);
     if (info == nullptr) {
         info = new SceneHeadingBlockInfo(_item->uuid());
+        cursor.block().setUserData(info);
+        ScenarioTextDocument::markBlockDataChanged(cursor.block());
     }
-    cursor.block().setUserData(info);
 
     return info->uuid();
 }
@@ -371,9 +365,10 @@ void ScenarioDocument::setItemDescriptionAtPosition(int _position, const QString
             SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(textBlockData);
             if (info == nullptr) {
                 info = new SceneHeadingBlockInfo(item->uuid());
+                cursor.block().setUserData(info);
+                ScenarioTextDocument::markBlockDataChanged(cursor.block());
             }
             info->setDescription(_description);
-            cursor.block().setUserData(info);
 
             //
             // Обновить описание внутри текста
@@ -570,6 +565,12 @@ void ScenarioDocument::setScenario(Domain::Scenario* _scenario)
 
 QString ScenarioDocument::save() const
 {
+    //
+    // Сохраняем только полностью загруженный сценарий, если же сохранение вызвано во время
+    // загрузки очередной части, то xml будет дополнен ещё не загруженными частями
+    //
+    m_document->finishLoading();
+
     return m_document->scenarioXml();
 }
 
@@ -640,7 +641,7 @@ int ScenarioDocument::positionToInsertMime(ScenarioModelItem* _insertParent, Sce
     // Если необходимо вставить перед заданным элементом
     //
     if (_insertBefore != nullptr) {
-        int insertBeforeItemStartPos = m_modelItems.key(_insertBefore);
+        int insertBeforeItemStartPos = _insertBefore->position();
 
         //
         // Шаг назад
@@ -692,7 +693,13 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
     //
     // Сохраняем изменённый xml и его хэш
     //
-    m_document->updateScenarioXml();
+    m_document->updateScenarioXml(_position, _charsRemoved, _charsAdded);
+
+    //
+    // ... и снимок текста, по которому формируется содержимое элементов дерева
+    //
+    m_textSnapshot.update(m_document, _position, _charsRemoved, _charsAdded);
+
     bool needIncrementPosition = false;
 
     //
@@ -725,46 +732,43 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
         // Удаляем элементы начиная с того, который находится под курсором, если курсор в начале
         // строки, или со следующего за курсором, если курсор не в начале строки
         //
-        QMap<int, ScenarioModelItem*>::iterator iter = m_modelItems.lowerBound(position);
         const int charsAddedDelta = _charsAdded - _charsRemoved;
         const int charsRemovedDelta = _charsRemoved - _charsAdded;
         QVector<ScenarioModelItem*> itemsToDelete;
-        while (iter != m_modelItems.end()
-               && iter.key() >= position
-               && iter.key() < (position + _charsRemoved)) {
+        ScenarioModelItem* itemToDelete = nullptr;
+        while ((itemToDelete = m_modelItems.lowerBound(position)) != nullptr
+               && itemToDelete->position() < (position + _charsRemoved)) {
             //
-            // Элемент для удаления
+            // Расширяем диапозон последующего построения дерева, для включения в него всех
+            // кто был удалён тут по причине не самого оптимального алгоритма
             //
-            ScenarioModelItem* itemToDelete = iter.value();
-
-            if (itemToDelete != nullptr) {
-                //
-                // Расширяем диапозон последующего построения дерева, для включения в него всех
-                // кто был удалён тут по причине не самого оптимального алгоритма
-                //
-                if (itemToDelete->hasChildren()) {
-                    const int charsModified = itemToDelete->endPosition() - position;
-                    if (_charsAdded < charsModified + charsAddedDelta) {
-                        _charsAdded = charsModified + charsAddedDelta;
-                    }
-                    if (_charsRemoved < charsModified - charsRemovedDelta) {
-                        _charsRemoved = charsModified - charsRemovedDelta;
-                    }
+            if (itemToDelete->hasChildren()) {
+                const int charsModified = itemToDelete->endPosition() - position;
+                if (_charsAdded < charsModified + charsAddedDelta) {
+                    _charsAdded = charsModified + charsAddedDelta;
                 }
-
-                //
-                // Добавим элемент в список на удаление, если там нет одно из его предков
-                //
-                if (itemsToDelete.isEmpty()
-                    || !itemToDelete->childOf(itemsToDelete.last())) {
-                    itemsToDelete.append(itemToDelete);
+                if (_charsRemoved < charsModified - charsRemovedDelta) {
+                    _charsRemoved = charsModified - charsRemovedDelta;
                 }
             }
 
+            //
+            // Добавим элемент в список на удаление, если там нет одно из его предков
+            //
+            if (itemsToDelete.isEmpty()
+                || !itemToDelete->childOf(itemsToDelete.last())) {
+                itemsToDelete.append(itemToDelete);
+            }
+
             //
             // Удалим элемент из кэша
             //
-            iter = m_modelItems.erase(iter);
+            m_modelItems.remove(itemToDelete);
+            m_itemsRanges.remove(itemToDelete);
+            m_itemsToBuild.remove(itemToDelete);
+            if (!m_itemsInBuild.isEmpty()) {
+                m_itemsRemovedInBuild.insert(itemToDelete);
+            }
         }
 
         //
@@ -812,28 +816,7 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
             }
         }
 
-        QMutableMapIterator<int, ScenarioModelItem*> removeIter(m_modelItems);
-        QMap<int, ScenarioModelItem*> updatedItems;
-        //
-        // Изымаем элементы из хэша и формируем обновлённый список
-        //
-        while (removeIter.hasNext()) {
-            removeIter.next();
-            if (removeIter.key() >= position) {
-                ScenarioModelItem* item = removeIter.value();
-                item->setPosition(removeIter.key() - _charsRemoved + _charsAdded);
-                updatedItems.insert(item->position(), item);
-                removeIter.remove();
-            }
-        }
-        //
-        // Переносим элементы из обновлённого списка в хэш
-        //
-        QMapIterator<int, ScenarioModelItem*> updateIter(updatedItems);
-        while (updateIter.hasNext()) {
-            updateIter.next();
-            m_modelItems.insert(updateIter.key(), updateIter.value());
-        }
+        m_modelItems.shift(position, _charsAdded - _charsRemoved);
     }
 
 
@@ -845,11 +828,7 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
         // получить первый блок и обновить/создать его
         // идти по документу, до конца вставленных символов и добавлять блоки
         //
-        QMap<int, ScenarioModelItem*>::iterator iter = m_modelItems.lowerBound(_position);
-        if (iter != m_modelItems.begin()
-            && iter.key() > _position) {
-            --iter;
-        }
+        ScenarioModelItem* nearestItem = m_modelItems.nearest(_position);
 
         //
         // Обновляем структуру
@@ -861,7 +840,7 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
         //
         // Если в документе нет ни одного элемента, создадим первый
         //
-        if (iter == m_modelItems.end()) {
+        if (nearestItem == nullptr) {
             currentItem = itemForPosition(0);
             m_model->addItem(currentItem);
             m_modelItems.insert(0, currentItem);
@@ -869,7 +848,7 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
         //
         // Или если вставляется новый элемент в начале текста
         //
-        else if (_position == 0 && iter == m_modelItems.begin() && iter.key() > 0) {
+        else if (_position == 0 && nearestItem->position() > 0) {
             currentItem = itemForPosition(0);
             m_model->prependItem(currentItem);
             m_modelItems.insert(0, currentItem);
@@ -878,8 +857,8 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
         // В противном случае получим необходимый к обновлению элемент
         //
         else {
-            currentItem = iter.value();
-            currentItemStartPos = iter.key();
+            currentItem = nearestItem;
+            currentItemStartPos = nearestItem->position();
         }
 
         //
@@ -1096,6 +1075,8 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
 
     updateDocumentScenesAndDialoguesNumbers();
 
+    buildItems();
+
     m_lastChange.needToCorrectText = true;
 }
 
@@ -1109,23 +1090,37 @@ void ScenarioDocument::correctText()
     m_document->correct(m_lastChange.position, m_lastChange.charactersRemoved, m_lastChange.charactersAdded);
 }
 
+void ScenarioDocument::aboutItemsBuilt()
+{
+    applyBuiltItems(m_itemsBuildWatcher->result());
+
+    //
+    // Сформируем элементы, обновлённые за время построения
+    //
+    buildItems();
+}
+
 void ScenarioDocument::initConnections()
 {
     connect(m_model, &ScenarioModel::fixedScenesChanged, this, &ScenarioDocument::fixedScenesChanged);
+    connect(m_itemsBuildWatcher, &QFutureWatcher<QVector<ScenarioTextSnapshot::ItemContent>>::finished,
+            this, &ScenarioDocument::aboutItemsBuilt);
+    connect(m_document, &ScenarioTextDocument::loadingProgressChanged, this, &ScenarioDocument::loadingProgressChanged);
+    connect(m_document, &ScenarioTextDocument::loadingFinished, this, &ScenarioDocument::loadingFinished);
 
     connectTextDocument();
 }
 
 void ScenarioDocument::connectTextDocument()
 {
-    connect(m_document, &ScenarioTextDocument::contentsChange, this, &ScenarioDocument::aboutContentsChange);
-    connect(m_document, &ScenarioTextDocument::contentsChanged, this, &ScenarioDocument::correctText);
+    connect(m_document, &ScenarioTextDocument::mergedContentsChange, this, &ScenarioDocument::aboutContentsChange);
+    connect(m_document, &ScenarioTextDocument::mergedContentsChanged, this, &ScenarioDocument::correctText);
 }
 
 void ScenarioDocument::disconnectTextDocument()
 {
-    disconnect(m_document, &ScenarioTextDocument::contentsChange, this, &ScenarioDocument::aboutContentsChange);
-    disconnect(m_document, &ScenarioTextDocument::contentsChanged, this, &ScenarioDocument::correctText);
+    disconnect(m_document, &ScenarioTextDocument::mergedContentsChange, this, &ScenarioDocument::aboutContentsChange);
+    disconnect(m_document, &ScenarioTextDocument::mergedContentsChanged, this, &ScenarioDocument::correctText);
 }
 
 void ScenarioDocument::updateItem(ScenarioModelItem* _item, int _itemStartPos, int _itemEndPos)
@@ -1133,11 +1128,10 @@ void ScenarioDocument::updateItem(ScenarioModelItem* _item, int _itemStartPos, i
     //
     // Получим данные элемента
     //
-    QTextCursor cursor(m_document);
-    cursor.setPosition(_itemStartPos);
+    QTextBlock headerBlock = m_document->findBlock(_itemStartPos);
     // ... тип
     ScenarioModelItem::Type itemType = ScenarioModelItem::Undefined;
-    ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(cursor.block());
+    ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(headerBlock);
     if (blockType == ScenarioBlockStyle::SceneHeading) {
         itemType = ScenarioModelItem::Scene;
     } else if (blockType == ScenarioBlockStyle::FolderHeader
@@ -1145,141 +1139,55 @@ void ScenarioDocument::updateItem(ScenarioModelItem* _item, int _itemStartPos, i
         itemType = ScenarioModelItem::Folder;
     }
     // ... заголовок
-    const QString itemHeader = cursor.block().text();
-    // ... название
-    const QString title = itemTitle(_item);
-    // ... цвет
-    const QString colors = itemColors(_item);
-    // ... штамп
-    const QString stamp = itemStamp(_item);
-    // ... номер сцены
-    const QString sceneNumber = itemSceneNumber(_item);
-    // .. зафиксирован ли номер сцены
-    const bool sceneNumberFixed = itemSceneIsFixed(_item);
-    // .. номер в группе фиксации
-    const int numberSuffix = itemSceneNumberSuffix(_item);
-    // .. группа фиксации (сколько раз была зафиксирована)
-    const int sceneNumberFixNesting = itemSceneFixNesting(_item);
-    // ... текст и описание
-    QString itemText;
-    QString description;
-    // ... подвал
-    QString footer;
-    //
-    bool isFirstDescriptionBlock = true; // первый блок описания сцены
-    bool isFirstTextBlock = true; // первый блок текста сцены
-    bool isNeedIncludeBlock = true; // нужно ли включать текущий блок
-    int openedScenesGroups = 0; // кол-во открытых групп
-    int openedFolders = 0; // кол-во открытых папок
-    cursor.movePosition(QTextCursor::NextBlock);
-    while (!cursor.atEnd()
-           && cursor.position() <= _itemEndPos) {
-        cursor.movePosition(QTextCursor::EndOfBlock);
-
-        ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(cursor.block());
-        //
-        // ... исключаем из текста заголовки и описание
-        //
-        switch (blockType) {
-            //
-            // Заголовки никуда не включаем
-            //
-            case ScenarioBlockStyle::SceneHeading: {
-                isNeedIncludeBlock = false;
-                break;
-            }
-
-            //
-            // Не включаем тект папок
-            //
-            case ScenarioBlockStyle::FolderHeader: {
-                ++openedFolders;
-                isNeedIncludeBlock = false;
-                break;
-            }
-            case ScenarioBlockStyle::FolderFooter: {
-                if (openedScenesGroups == 0
-                    && openedFolders == 0) {
-                    footer = cursor.block().text();
-                    --openedFolders;
-                } else {
-                    --openedFolders;
-                    if (openedScenesGroups == 0
-                        && openedFolders == 0) {
-                        isNeedIncludeBlock = true;
-                    }
-                }
-                break;
-            }
-
-            //
-            // Описание сохраняем в описание
-            //
-            case ScenarioBlockStyle::SceneDescription: {
-                if (isNeedIncludeBlock) {
-                    if (!isFirstDescriptionBlock) {
-                        description.append("\n");
-                    } else {
-                        description = "";
-                        isFirstDescriptionBlock = false;
-                    }
-                    description.append(cursor.block().text());
-                }
-                break;
-            }
-
-            //
-            // Весь остальной текст - текст сцены
-            //
-            default: {
-                if (isNeedIncludeBlock) {
-                    if (!isFirstTextBlock) {
-                        itemText.append("\n");
-                    } else {
-                        itemText = "";
-                        isFirstTextBlock = false;
-                    }
-                    ScenarioBlockStyle blockStyle = ScenarioTemplateFacade::getTemplate().blockStyle(blockType);
-                    itemText +=
-                            blockStyle.charFormat().fontCapitalization() == QFont::AllUppercase
-                            ? TextEditHelper::smartToUpper(cursor.block().text())
-                            : cursor.block().text();
-                }
-                break;
-            }
-        }
+    const QString itemHeader = headerBlock.text();
+    // ... название, цвет, штамп, номер сцены и параметры его фиксации
+    QString title;
+    QString colors;
+    QString stamp;
+    QString sceneNumber;
+    bool sceneNumberFixed = false;
+    int numberSuffix = 0;
+    int sceneNumberFixNesting = 0;
+    SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(headerBlock.userData());
+    if (info != nullptr) {
+        title = info->name();
+        colors = info->colors();
+        stamp = info->stamp();
+        sceneNumber = info->sceneNumber();
+        sceneNumberFixed = info->isSceneNumberFixed();
+        numberSuffix = info->sceneNumberSuffix();
+        sceneNumberFixNesting = info->sceneNumberFixNesting();
+    }
 
-        cursor.movePosition(QTextCursor::NextBlock);
+    //
+    // Определим диапазон блоков элемента, в него входят все блоки, начинающиеся не дальше
+    // конца элемента
+    //
+    ScenarioTextSnapshot::ItemRange range;
+    range.firstBlock = headerBlock.blockNumber();
+    const QTextBlock lastBlock = m_document->findBlock(_itemEndPos);
+    if (lastBlock.isValid()) {
+        range.lastBlock = lastBlock.blockNumber();
+        range.isLastBlockInside = lastBlock.position() < _itemEndPos;
+    } else {
+        range.lastBlock = m_document->blockCount() - 1;
+        range.isLastBlockInside = true;
     }
+
+    //
+    // Описание, подвал и длину текста определяем сразу, т.к. от них зависят позиции
+    // элементов, а сам текст, счётчики и хронометраж сформируем по снимку текста позже
+    //
+    const ScenarioTextSnapshot::ItemParts parts = m_textSnapshot.itemParts(range);
     //
     // ... обновляем описание
     //
-    cursor.setPosition(_itemStartPos);
-    SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(cursor.block().userData());
     if (info == nullptr) {
         info = new SceneHeadingBlockInfo(_item->uuid());
+        headerBlock.setUserData(info);
+        ScenarioTextDocument::markBlockDataChanged(headerBlock);
     }
-    info->setDescription(description);
-    cursor.block().setUserData(info);
-    // ... длительность
-    qreal itemDuration = 0;
-    if (itemType == ScenarioModelItem::Scene) {
-        itemDuration = ChronometerFacade::calculate(m_document, _itemStartPos, _itemEndPos);
-    }
-    // ... содержит ли примечания
-    bool hasNote = false;
-    cursor.setPosition(_itemStartPos);
-    while (cursor.position() < _itemEndPos) {
-        cursor.movePosition(QTextCursor::EndOfBlock);
-        if (ScenarioBlockStyle::forBlock(cursor.block())
-            == ScenarioBlockStyle::NoprintableText) {
-            hasNote = true;
-            break;
-        }
-        cursor.movePosition(QTextCursor::NextBlock);
-    }
-    // ... счётчик слов и символов
-    Counter counter = CountersFacade::calculate(m_document, _itemStartPos, _itemEndPos);
+    info->setDescription(parts.description);
 
     //
     // Обновим данные элемента
@@ -1293,30 +1201,157 @@ void ScenarioDocument::updateItem(ScenarioModelItem* _item, int _itemStartPos, i
     _item->setFixed(sceneNumberFixed);
     _item->setNumberSuffix(numberSuffix);
     _item->setName(title);
-    _item->setText(itemText);
-    _item->setDescription(description);
-    _item->setDuration(itemDuration);
-    _item->setHasNote(hasNote);
-    _item->setCounter(counter);
-    _item->setFooter(footer);
+    _item->setDescription(parts.description);
+    _item->setTextLength(parts.textLength);
+    _item->setFooter(parts.footer);
+
+    m_itemsRanges.insert(_item, range);
+    m_itemsToBuild.insert(_item);
+}
+
+void ScenarioDocument::buildItems()
+{
+    //
+    // Если изменились параметры расчёта счётчиков или хронометража, то формируем заново
+    // содержимое всех элементов
+    //
+    const ScenarioTextSnapshot::Calculation calculation = ScenarioTextSnapshot::Calculation::current();
+    if (calculation != m_itemsBuildCalculation) {
+        for (auto iter = m_itemsRanges.constBegin(); iter != m_itemsRanges.constEnd(); ++iter) {
+            m_itemsToBuild.insert(iter.key());
+        }
+    }
+
+    //
+    // Если содержимое элементов уже формируется, то накопившиеся элементы сформируем
+    // после его завершения
+    //
+    if (m_itemsToBuild.isEmpty()
+        || m_itemsBuildWatcher->isRunning()) {
+        return;
+    }
+
+    //
+    // Подготовим задачи, уточнив диапазоны блоков элементов, т.к. с момента обновления
+    // элемента перед ним мог измениться текст, и скопировав их блоки из снимка, чтобы
+    // не разделять сам снимок с фоновым потоком
+    //
+    const bool needToCalculateDuration = !calculation.chronometer.isNull() && !m_document->isEmpty();
+    QVector<ItemBuildTask> tasks;
+    tasks.reserve(m_itemsToBuild.size());
+    for (ScenarioModelItem* item : m_itemsToBuild) {
+        ScenarioTextSnapshot::ItemRange range = m_itemsRanges.value(item);
+        const int firstBlock = m_document->findBlock(item->position()).blockNumber();
+        range.lastBlock += firstBlock - range.firstBlock;
+        range.firstBlock = firstBlock;
+
+        ItemBuildTask task;
+        task.item = item;
+        task.blocks = m_textSnapshot.itemBlocks(range);
+        if (item->type() == ScenarioModelItem::Scene) {
+            task.calculateDuration = needToCalculateDuration;
+            task.duration = calculation.chronometer.isNull() ? -1 : 0;
+        }
+        tasks.append(task);
+    }
+    m_itemsToBuild.clear();
+
+    //
+    // Определим какие блоки пишутся в верхнем регистре
+    //
+    const ScenarioTemplate scenarioTemplate = ScenarioTemplateFacade::getTemplate();
+    QVector<bool> uppercaseTypes(ScenarioBlockStyle::PageSplitter + 1, false);
+    for (int type = 0; type < uppercaseTypes.size(); ++type) {
+        uppercaseTypes[type] =
+                scenarioTemplate.blockStyle(static_cast<ScenarioBlockStyle::Type>(type)).charFormat().fontCapitalization()
+                == QFont::AllUppercase;
+    }
+
+    //
+    // Формируем содержимое, а также рассчитываем счётчики и хронометраж по копиям блоков,
+    // поэтому дальнейшие правки текста их не затрагивают
+    //
+    auto build = [tasks, uppercaseTypes, calculation] {
+        QVector<ScenarioTextSnapshot::ItemContent> contents;
+        contents.reserve(tasks.size());
+        for (const ItemBuildTask& task : tasks) {
+            contents.append(
+                ScenarioTextSnapshot::itemContent(task.blocks, uppercaseTypes, calculation, task.calculateDuration));
+        }
+        return contents;
+    };
+
+    m_itemsInBuild = tasks;
+    m_itemsBuildCalculation = calculation;
+    if (m_document->blockCount() < kBackgroundBuildMinBlocks) {
+        applyBuiltItems(build());
+    } else {
+        m_itemsBuildWatcher->setFuture(QtConcurrent::run(build));
+    }
+}
+
+void ScenarioDocument::applyBuiltItems(const QVector<ScenarioTextSnapshot::ItemContent>& _contents)
+{
+    //
+    // Элементы, удалённые во время построения, пропускаем. Элементы, изменившиеся во время
+    // построения, уже снова поставлены в очередь, поэтому их содержимое применяем сейчас,
+    // а актуальное будет сформировано следующим построением
+    //
+    const QVector<ItemBuildTask> tasks = m_itemsInBuild;
+    const QSet<ScenarioModelItem*> removedItems = m_itemsRemovedInBuild;
+    m_itemsInBuild.clear();
+    m_itemsRemovedInBuild.clear();
+
+    //
+    // Обновляем только те элементы, содержимое которых действительно изменилось
+    //
+    bool isItemsUpdated = false;
+    for (int index = 0; index < tasks.size(); ++index) {
+        const ItemBuildTask& task = tasks.at(index);
+        ScenarioModelItem* item = task.item;
+        if (removedItems.contains(item)) {
+            continue;
+        }
+
+        const ScenarioTextSnapshot::ItemContent& content = _contents.at(index);
+        const qreal duration = task.duration + content.duration;
+        const QString itemText = item->fullText();
+        const bool isTextChanged =
+                itemText.isNull() != content.text.isNull()
+                || itemText != content.text;
+        const bool isTotalsChanged =
+                !item->hasChildren()
+                && (item->counter() != content.counter
+                    || item->duration() != duration);
+        if (!isTextChanged
+            && !isTotalsChanged
+            && item->hasNote() == content.hasNote) {
+            continue;
+        }
+
+        item->setText(content.text);
+        item->setHasNote(content.hasNote);
+        item->setCounter(content.counter);
+        item->setDuration(duration);
+        m_model->updateItem(item);
+        isItemsUpdated = true;
+    }
+
+    if (isItemsUpdated) {
+        emit modelItemsUpdated();
+    }
 }
 
 ScenarioModelItem* ScenarioDocument::itemForPosition(int _position, bool _findNear) const
 {
-    ScenarioModelItem* item = m_modelItems.value(_position, nullptr);
+    ScenarioModelItem* item = m_modelItems.value(_position);
     if (item == nullptr) {
         //
         // Если необходимо ищем ближайшего
         //
         if (_findNear) {
-            QMap<int, ScenarioModelItem*>::const_iterator i = m_modelItems.lowerBound(_position);
-            if (i != m_modelItems.begin()
-                || i != m_modelItems.end()) {
-                if (i != m_modelItems.begin()) {
-                    --i;
-                }
-                item = i.value();
-            } else {
+            item = m_modelItems.nearest(_position);
+            if (item == nullptr) {
                 //
                 // не найден, т.к. в модели нет элементов
                 //
@@ -1352,6 +1387,7 @@ void ScenarioDocument::updateDocumentScenesAndDialoguesNumbers()
                 if (ScenarioModelItem* item = itemForPosition(block.position())) {
                     QTextBlockUserData* textBlockData = block.userData();
                     SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(textBlockData);
+                    const quint64 infoId = info != nullptr ? info->id() : 0;
                     if (info == nullptr) {
                         info = new SceneHeadingBlockInfo(item->uuid());
                     }
@@ -1360,6 +1396,12 @@ void ScenarioDocument::updateDocumentScenesAndDialoguesNumbers()
                     info->setSceneNumberFixNesting(item->fixNesting());
                     info->setSceneNumberSuffix(item->numberSuffix());
                     block.setUserData(info);
+                    //
+                    // ... номер зафиксированной сцены сохраняется в xml
+                    //
+                    if (info->id() != infoId) {
+                        ScenarioTextDocument::markBlockDataChanged(block);
+                    }
                 }
                 break;
             }
@@ -1410,6 +1452,7 @@ void ScenarioDocument::changeSceneNumbersLocking(bool _lock)
        QTextBlockUserData* textBlockData = block.userData();
 
        SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(textBlockData);
+       const quint64 infoId = info != nullptr ? info->id() : 0;
        if (info == nullptr) {
            info = new SceneHeadingBlockInfo(item->uuid());
        }
@@ -1419,6 +1462,9 @@ void ScenarioDocument::changeSceneNumbersLocking(bool _lock)
        info->setSceneNumberFixNesting(item->fixNesting());
        info->setSceneNumberSuffix(item->numberSuffix());
        block.setUserData(info);
+       if (info->id() != infoId) {
+           ScenarioTextDocument::markBlockDataChanged(block);
+       }
    }
    refresh();
 }
@@ -1455,6 +1501,7 @@ void ScenarioDocument::load(const QString& _scenario)
     {
         aboutContentsChange(0, m_document->characterCount(), 0);
         m_document->clear();
+        m_modelItems.clear();
     }
 
     //
@@ -1,12 +1,18 @@
 #ifndef SCENARIODOCUMENT_H
 #define SCENARIODOCUMENT_H
 
+#include "ScenarioModelItemsIndex.h"
+#include "ScenarioTextSnapshot.h"
+
+#include <QHash>
 #include <QObject>
-#include <QMap>
+#include <QSet>
 #include <QUuid>
 
+class QTextBlock;
 class QTextDocument;
 class QAbstractItemModel;
+template<typename T> class QFutureWatcher;
 
 namespace Domain {
     class Scenario;
@@ -271,6 +277,25 @@ namespace BusinessLogic
          */
         void fixedScenesChanged(bool _anyFixed);
 
+        /**
+         * @brief Обновлено содержимое элементов дерева сценария
+         * @note Для больших сценариев содержимое элементов формируется в фоне, поэтому
+         *       счётчики и хронометраж сценария могут обновиться уже после изменения текста
+         */
+        void modelItemsUpdated();
+
+        /**
+         * @brief Изменился прогресс загрузки сценария, в процентах
+         * @note Большой сценарий догружается частями уже после открытия, отчёты и экспорт
+         *       дожидаются окончания загрузки
+         */
+        void loadingProgressChanged(int _progress);
+
+        /**
+         * @brief Сценарий загружен полностью
+         */
+        void loadingFinished();
+
     private slots:
         /**
          * @brief Изменилось содержимое документа
@@ -282,6 +307,11 @@ namespace BusinessLogic
          */
         void correctText();
 
+        /**
+         * @brief Завершилось фоновое формирование содержимого элементов
+         */
+        void aboutItemsBuilt();
+
     private:
         /**
          * @brief Настроить необходимые соединения
@@ -303,6 +333,17 @@ namespace BusinessLogic
          */
         void updateItem(ScenarioModelItem* _item, int _itemStartPos, int _itemEndPos);
 
+        /**
+         * @brief Сформировать по снимку текста содержимое обновлённых элементов
+         * @note Для больших сценариев содержимое формируется в фоновом потоке
+         */
+        void buildItems();
+
+        /**
+         * @brief Применить сформированное содержимое элементов
+         */
+        void applyBuiltItems(const QVector<ScenarioTextSnapshot::ItemContent>& _contents);
+
         /**
          * @brief Создать или получить существующий элемент для позиции в документе
          *		  или ближайший к позиции
@@ -336,9 +377,70 @@ namespace BusinessLogic
         ScenarioModel* m_model = nullptr;
 
         /**
-         * @brief Карта элементов дерева сценария
+         * @brief Индекс позиций элементов дерева сценария
+         */
+        ScenarioModelItemsIndex m_modelItems;
+
+        /**
+         * @brief Снимок текста сценария, по которому формируется содержимое элементов
+         */
+        ScenarioTextSnapshot m_textSnapshot;
+
+        /**
+         * @brief Диапазоны блоков элементов на момент их последнего обновления
+         */
+        QHash<ScenarioModelItem*, ScenarioTextSnapshot::ItemRange> m_itemsRanges;
+
+        /**
+         * @brief Элементы, содержимое которых нужно сформировать
+         */
+        QSet<ScenarioModelItem*> m_itemsToBuild;
+
+        /**
+         * @brief Задача формирования содержимого элемента
+         */
+        struct ItemBuildTask {
+            /**
+             * @brief Элемент
+             * @note В фоновом потоке элемент не используется, т.к. может быть удалён
+             */
+            ScenarioModelItem* item = nullptr;
+
+            /**
+             * @brief Копия блоков элемента
+             */
+            ScenarioTextSnapshot::ItemBlocks blocks;
+
+            /**
+             * @brief Нужно ли рассчитывать хронометраж
+             */
+            bool calculateDuration = false;
+
+            /**
+             * @brief Хронометраж элемента, к которому добавляется рассчитанный
+             */
+            qreal duration = 0;
+        };
+
+        /**
+         * @brief Задачи выполняющегося формирования содержимого элементов
+         */
+        QVector<ItemBuildTask> m_itemsInBuild;
+
+        /**
+         * @brief Элементы, удалённые во время выполняющегося формирования содержимого
+         */
+        QSet<ScenarioModelItem*> m_itemsRemovedInBuild;
+
+        /**
+         * @brief Параметры расчёта, с которыми было сформировано содержимое элементов
+         */
+        ScenarioTextSnapshot::Calculation m_itemsBuildCalculation;
+
+        /**
+         * @brief Наблюдатель за фоновым формированием содержимого элементов
          */
-        QMap<int, ScenarioModelItem*> m_modelItems;
+        QFutureWatcher<QVector<ScenarioTextSnapshot::ItemContent>>* m_itemsBuildWatcher = nullptr;
 
         /**
          * @brief Флаг операции обновления описания сцены, для предотвращения рекурсии
@@ -52,6 +52,7 @@ void ScenarioModel::prependItem(ScenarioModelItem* _item, ScenarioModelItem* _pa
 
         beginInsertRows(parentIndex, itemRowIndex, itemRowIndex);
         _parentItem->prependItem(_item);
+        registerItem(_item);
         ++m_scenesCount;
         endInsertRows();
     }
@@ -86,6 +87,7 @@ void ScenarioModel::addItem(ScenarioModelItem* _item, ScenarioModelItem* _parent
 
         beginInsertRows(parentIndex, itemRowIndex, itemRowIndex);
         _parentItem->insertItem(itemRowIndex, _item);
+        registerItem(_item);
         ++m_scenesCount;
         endInsertRows();
     }
@@ -104,6 +106,7 @@ void ScenarioModel::insertItem(ScenarioModelItem* _item, ScenarioModelItem* _aft
 
         beginInsertRows(parentIndex, itemRowIndex, itemRowIndex);
         parent->insertItem(itemRowIndex, _item);
+        registerItem(_item);
         ++m_scenesCount;
         endInsertRows();
     }
@@ -133,6 +136,7 @@ void ScenarioModel::removeItem(ScenarioModelItem* _item)
     if (itemRowIndex >= 0) {
         beginRemoveRows(itemParentIndex, itemRowIndex, itemRowIndex);
         itemParent->removeItem(_item);
+        unregisterItem(_item);
         --m_scenesCount;
         endRemoveRows();
     }
@@ -147,6 +151,7 @@ void ScenarioModel::removeItems(const QVector<ScenarioModelItem*>& _items)
         beginRemoveRows(itemParentIndex, firstRow, lastRow);
         for (ScenarioModelItem* itemToDelete : _itemsToDelete) {
             _parent->removeItem(itemToDelete);
+            unregisterItem(itemToDelete);
             --m_scenesCount;
         }
         endRemoveRows();
@@ -214,6 +219,13 @@ void ScenarioModel::updateItem(ScenarioModelItem* _item)
     // Если элемент уже в списке, то обновим, в противном случае просто игнорируем
     //
     if (_item->parent() != 0) {
+        //
+        // ... идентификатор элемента мог смениться, поэтому обновим его в индексе
+        //
+        if (m_uuidsForItems.value(_item) != _item->uuid()) {
+            registerItem(_item);
+        }
+
         const QModelIndex indexForUpdate = indexForItem(_item);
         emit dataChanged(indexForUpdate, indexForUpdate);
     }
@@ -876,7 +888,47 @@ QModelIndex ScenarioModel::indexForUuid(const QString& _uuid) const
         return QModelIndex();
     }
 
-    return indexForItem(::scenarioModelItemForUuid(m_rootItem, _uuid));
+    //
+    // Сначала ищем элемент в индексе, а если там его нет, или у него уже другой идентификатор,
+    // то проходим по всему дереву
+    //
+    ScenarioModelItem* item = m_itemsForUuids.value(_uuid);
+    if (item == nullptr
+        || item->uuid() != _uuid) {
+        item = ::scenarioModelItemForUuid(m_rootItem, _uuid);
+    }
+
+    return indexForItem(item);
+}
+
+void ScenarioModel::registerItem(ScenarioModelItem* _item)
+{
+    const QString oldUuid = m_uuidsForItems.value(_item);
+    if (!oldUuid.isNull()
+        && m_itemsForUuids.value(oldUuid) == _item) {
+        m_itemsForUuids.remove(oldUuid);
+    }
+
+    if (!_item->uuid().isEmpty()) {
+        m_itemsForUuids.insert(_item->uuid(), _item);
+    }
+    m_uuidsForItems.insert(_item, _item->uuid());
+
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        registerItem(_item->childAt(childIndex));
+    }
+}
+
+void ScenarioModel::unregisterItem(ScenarioModelItem* _item)
+{
+    const QString uuid = m_uuidsForItems.take(_item);
+    if (m_itemsForUuids.value(uuid) == _item) {
+        m_itemsForUuids.remove(uuid);
+    }
+
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        unregisterItem(_item->childAt(childIndex));
+    }
 }
 
 namespace {
@@ -4,6 +4,7 @@
 #include <BusinessLayer/Counters/Counter.h>
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QSortFilterProxyModel>
 
 
@@ -161,6 +162,17 @@ namespace BusinessLogic
          */
         void fixedScenesChanged(bool _anyFixed);
 
+    private:
+        /**
+         * @brief Добавить элемент и его детей в индекс идентификаторов
+         */
+        void registerItem(ScenarioModelItem* _item);
+
+        /**
+         * @brief Удалить элемент и его детей из индекса идентификаторов
+         */
+        void unregisterItem(ScenarioModelItem* _item);
+
     private:
         /**
          * @brief Корневой элемент дерева
@@ -193,6 +205,17 @@ namespace BusinessLogic
          * @brief Есть ли зафиксированные сцены
          */
         bool m_anySceneLocked = false;
+
+        /**
+         * @brief Индекс элементов модели по их идентификаторам
+         * @note Идентификатор элемента может смениться, пока он находится в модели, поэтому
+         *       индекс обновляется и при обновлении элемента, а найденный в нём элемент
+         *       сверяется с искомым идентификатором
+         */
+        /** @{ */
+        QHash<QString, ScenarioModelItem*> m_itemsForUuids;
+        QHash<ScenarioModelItem*, QString> m_uuidsForItems;
+        /** @} */
     };
 
     /**
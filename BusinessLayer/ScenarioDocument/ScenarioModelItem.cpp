@@ -39,6 +39,10 @@ void ScenarioModelItem::setUuid(const QString& _uuid)
 
 int ScenarioModelItem::position() const
 {
+    if (m_indexNode != nullptr) {
+        return ScenarioModelItemsIndex::position(m_indexNode);
+    }
+
     return m_position;
 }
 
@@ -220,15 +224,34 @@ QString ScenarioModelItem::fullText() const
 void ScenarioModelItem::setText(const QString& _text)
 {
     m_textLength = _text.length();
+    m_fullText = _text;
     QString newText = _text.left(MAX_TEXT_LENGTH);
     newText.replace("\n", " ");
     if (m_text.isNull() != newText.isNull()
         || m_text != newText) {
         m_text = newText;
-        m_fullText = _text;
     }
 }
 
+void ScenarioModelItem::setTextLength(int _length)
+{
+    if (_length < 0) {
+        m_text.clear();
+        m_fullText.clear();
+        m_textLength = 0;
+        return;
+    }
+
+    //
+    // Длина элемента учитывает текст, только если он есть
+    //
+    if (m_text.isNull()) {
+        m_text = "";
+        m_fullText = "";
+    }
+    m_textLength = _length;
+}
+
 qreal ScenarioModelItem::duration() const
 {
     return m_duration;
@@ -236,10 +259,14 @@ qreal ScenarioModelItem::duration() const
 
 void ScenarioModelItem::setDuration(qreal _duration)
 {
-    if (m_duration != _duration) {
-        m_duration = _duration;
-        updateParentDuration();
+    //
+    // Длительность элементов с детьми складывается из длительностей детей
+    //
+    if (hasChildren()) {
+        return;
     }
+
+    changeDuration(_duration);
 }
 
 ScenarioModelItem::Type ScenarioModelItem::type() const
@@ -251,6 +278,13 @@ void ScenarioModelItem::setType(ScenarioModelItem::Type _type)
 {
     if (m_type != _type) {
         m_type = _type;
+
+        //
+        // В индексе учитывается длительность только сцен
+        //
+        if (m_indexNode != nullptr) {
+            ScenarioModelItemsIndex::updateDuration(m_indexNode);
+        }
     }
 }
 
@@ -295,57 +329,60 @@ Counter ScenarioModelItem::counter() const
 
 void ScenarioModelItem::setCounter(const Counter& _counter)
 {
-    if (m_counter != _counter) {
-        m_counter = _counter;
-        updateParentCounter();
+    //
+    // Счётчики элементов с детьми складываются из счётчиков детей
+    //
+    if (hasChildren()) {
+        return;
     }
+
+    changeCounter(_counter);
 }
 
-void ScenarioModelItem::updateParentDuration()
+void ScenarioModelItem::changeDuration(qreal _duration)
 {
+    if (m_duration == _duration) {
+        return;
+    }
+
     //
-    // Если есть дети - обновляем свою длительность
+    // Родители складывают округлённые длительности, поэтому их длительности целые
+    // и изменяются ровно на разницу округлённых значений
     //
-    if (hasChildren()) {
-        int duration = 0;
-        foreach (ScenarioModelItem* child, m_children) {
-            duration += qRound(child->duration());
-        }
-        setDuration(duration);
+    const int delta = qRound(_duration) - qRound(m_duration);
+    m_duration = _duration;
+    if (m_indexNode != nullptr) {
+        ScenarioModelItemsIndex::updateDuration(m_indexNode);
     }
 
     //
-    // Обновляем родителя
+    // Обновляем родителей
     //
-    if (hasParent()) {
-        parent()->updateParentDuration();
+    if (delta == 0) {
+        return;
+    }
+    for (ScenarioModelItem* parent = m_parent; parent != nullptr; parent = parent->m_parent) {
+        parent->m_duration += delta;
+        if (parent->m_indexNode != nullptr) {
+            ScenarioModelItemsIndex::updateDuration(parent->m_indexNode);
+        }
     }
 }
 
-void ScenarioModelItem::updateParentCounter()
+void ScenarioModelItem::changeCounter(const Counter& _counter)
 {
-    //
-    // Если есть дети - обновляем свои счётчики
-    //
-    if (hasChildren()) {
-        Counter counter;
-        foreach (ScenarioModelItem* child, m_children) {
-            counter.setWords(counter.words() + child->counter().words());
-            counter.setCharactersWithSpaces(
-                counter.charactersWithSpaces() + child->counter().charactersWithSpaces()
-                );
-            counter.setCharactersWithoutSpaces(
-                counter.charactersWithoutSpaces() + child->counter().charactersWithoutSpaces()
-                );
-        }
-        setCounter(counter);
+    if (m_counter == _counter) {
+        return;
     }
 
+    const Counter delta = _counter - m_counter;
+    m_counter = _counter;
+
     //
-    // Обновляем родителя
+    // Обновляем родителей
     //
-    if (hasParent()) {
-        parent()->updateParentCounter();
+    for (ScenarioModelItem* parent = m_parent; parent != nullptr; parent = parent->m_parent) {
+        parent->m_counter = parent->m_counter + delta;
     }
 }
 
@@ -355,27 +392,32 @@ void ScenarioModelItem::clear()
     m_text.clear();
     m_footer.clear();
 
-    m_duration = 0;
-    updateParentDuration();
+    changeDuration(0);
 }
 
 //! Вспомогательные методы для организации работы модели
 
 void ScenarioModelItem::prependItem(ScenarioModelItem* _item)
 {
-    //
-    // Устанавливаем себя родителем
-    //
-    _item->m_parent = this;
-
-    //
-    // Добавляем элемент в список детей
-    //
-    m_children.prepend(_item);
+    insertItem(0, _item);
 }
 
 void ScenarioModelItem::appendItem(ScenarioModelItem* _item)
 {
+    insertItem(m_children.size(), _item);
+}
+
+void ScenarioModelItem::insertItem(int _index, ScenarioModelItem* _item)
+{
+    //
+    // С появлением первого ребёнка счётчик и длительность элемента начинают складываться
+    // из счётчиков и длительностей детей
+    //
+    if (!hasChildren()) {
+        changeCounter(Counter());
+        changeDuration(0);
+    }
+
     //
     // Устанавливаем себя родителем
     //
@@ -384,23 +426,27 @@ void ScenarioModelItem::appendItem(ScenarioModelItem* _item)
     //
     // Добавляем элемент в список детей
     //
-    m_children.append(_item);
-}
-
-void ScenarioModelItem::insertItem(int _index, ScenarioModelItem* _item)
-{
-    _item->m_parent = this;
     m_children.insert(_index, _item);
+    updateChildrenRows(_index);
+    changeCounter(m_counter + _item->counter());
+    changeDuration(m_duration + qRound(_item->duration()));
 }
 
 void ScenarioModelItem::removeItem(ScenarioModelItem* _item)
 {
     _item->clear();
+    const Counter itemCounter = _item->counter();
 
     //
-    // removeOne - удаляет объект при помощи delete, так что потом самому удалять не нужно
+    // removeAt лишь убирает указатель из списка детей, сам элемент не удаляется,
+    // т.к. модель ещё обращается к нему, снимая его с регистрации
     //
-    m_children.removeOne(_item);
+    const int itemRow = rowOfChild(_item);
+    if (itemRow != -1) {
+        m_children.removeAt(itemRow);
+        updateChildrenRows(itemRow);
+        changeCounter(m_counter - itemCounter);
+    }
     _item = 0;
 }
 
@@ -421,6 +467,12 @@ ScenarioModelItem* ScenarioModelItem::childAt(int _index) const
 
 int ScenarioModelItem::rowOfChild(ScenarioModelItem* _child) const
 {
+    if (_child != nullptr
+        && _child->m_parent == this
+        && m_children.value(_child->m_row) == _child) {
+        return _child->m_row;
+    }
+
     return m_children.indexOf(_child);
 }
 
@@ -446,3 +498,10 @@ bool ScenarioModelItem::childOf(ScenarioModelItem* _parent) const
     }
     return false;
 }
+
+void ScenarioModelItem::updateChildrenRows(int _fromRow)
+{
+    for (int row = _fromRow; row < m_children.size(); ++row) {
+        m_children.at(row)->m_row = row;
+    }
+}
@@ -1,6 +1,8 @@
 #ifndef SCENARIOMODELITEM_H
 #define SCENARIOMODELITEM_H
 
+#include "ScenarioModelItemsIndex.h"
+
 #include <BusinessLayer/Counters/Counter.h>
 
 #include <QIcon>
@@ -37,6 +39,7 @@ namespace BusinessLogic
 
         /**
          * @brief Позиция элемента
+         * @note Для элемента, находящегося в индексе позиций, позиция определяется индексом
          */
         int position() const;
         void setPosition(int _position);
@@ -118,6 +121,12 @@ namespace BusinessLogic
         QString fullText() const;
         void setText(const QString& _text);
 
+        /**
+         * @brief Задать длину текста элемента, пока сам текст ещё не сформирован
+         * @note Отрицательная длина означает, что текста у элемента нет
+         */
+        void setTextLength(int _length);
+
         /**
          * @brief Длительность элемента
          */
@@ -149,18 +158,20 @@ namespace BusinessLogic
 
     private:
         /**
-         * @brief Обновить длительность
+         * @brief Изменить длительность элемента, скорректировав на разницу длительности всех его родителей
          *
-         * @note Для элементов группирующих в себе подэлементы
+         * @note Длительность элементов, группирующих в себе подэлементы, складывается из
+         *       округлённых длительностей подэлементов
          */
-        void updateParentDuration();
+        void changeDuration(qreal _duration);
 
         /**
-         * @brief Обновить счётчики
+         * @brief Изменить счётчик элемента, скорректировав на разницу счётчики всех его родителей
          *
-         * @note Для элементов группирующих в себе подэлементы
+         * @note Счётчики элементов, группирующих в себе подэлементы, складываются из
+         *       счётчиков подэлементов, поэтому их не нужно пересчитывать целиком
          */
-        void updateParentCounter();
+        void changeCounter(const Counter& _counter);
 
         /**
          * @brief Очистить элемент
@@ -178,6 +189,11 @@ namespace BusinessLogic
          */
         int m_position;
 
+        /**
+         * @brief Узел индекса позиций, в котором находится элемент
+         */
+        ScenarioModelItemsIndex::Node* m_indexNode = nullptr;
+
         /**
          * @brief Номер сцены
          */
@@ -323,6 +339,12 @@ namespace BusinessLogic
          */
         bool childOf(ScenarioModelItem* _parent) const;
 
+    private:
+        /**
+         * @brief Обновить номера детей, начиная с заданного
+         */
+        void updateChildrenRows(int _fromRow);
+
     private:
         /**
          * @brief Родительский элемент
@@ -334,7 +356,19 @@ namespace BusinessLogic
          */
         QList<ScenarioModelItem*> m_children;
 
+        /**
+         * @brief Номер элемента в списке детей родителя
+         * @note Поддерживается при добавлении и удалении детей, а при чтении сверяется со списком
+         *       детей, так что устаревшее значение лишь приводит к поиску элемента в списке
+         */
+        int m_row = -1;
+
     /** @} */
+
+        /**
+         * @brief Индекс позиций сам управляет позицией находящихся в нём элементов
+         */
+        friend class ScenarioModelItemsIndex;
     };
 }
 
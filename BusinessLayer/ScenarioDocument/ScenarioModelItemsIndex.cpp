@@ -0,0 +1,440 @@
+#include "ScenarioModelItemsIndex.h"
+
+#include "ScenarioModelItem.h"
+
+#include <3rd_party/Helpers/TreapHelper.h>
+
+using BusinessLogic::ScenarioModelItem;
+using BusinessLogic::ScenarioModelItemsIndex;
+
+namespace {
+    /**
+     * @brief Получить длительность элемента, учитываемую в индексе
+     * @note Учитываем только сцены, т.к. длительность папок складывается из длительности их сцен
+     */
+    static qreal indexedDuration(const ScenarioModelItem* _item)
+    {
+        return _item->type() == ScenarioModelItem::Scene ? _item->duration() : 0;
+    }
+}
+
+struct ScenarioModelItemsIndex::Node
+{
+    Node* left = nullptr;
+    Node* right = nullptr;
+    Node* parent = nullptr;
+    quint32 priority = TreapHelper::nextPriority();
+
+    /**
+     * @brief Элемент модели
+     */
+    ScenarioModelItem* item = nullptr;
+
+    /**
+     * @brief Смещение позиции элемента относительно предыдущего элемента
+     */
+    int offset = 0;
+
+    /**
+     * @brief Длительность элемента
+     */
+    qreal duration = 0;
+
+    //
+    // Агрегированные значения поддерева
+    //
+
+    int sum = 0;
+    int count = 1;
+    qreal durationSum = 0;
+};
+
+
+int ScenarioModelItemsIndex::position(const Node* _node)
+{
+    int position = sum(_node->left) + _node->offset;
+    for (const Node* node = _node; node->parent != nullptr; node = node->parent) {
+        const Node* parent = node->parent;
+        if (parent->right == node) {
+            position += sum(parent->left) + parent->offset;
+        }
+    }
+    return position;
+}
+
+void ScenarioModelItemsIndex::updateDuration(Node* _node)
+{
+    _node->duration = indexedDuration(_node->item);
+    for (Node* node = _node; node != nullptr; node = node->parent) {
+        pull(node);
+    }
+}
+
+ScenarioModelItemsIndex::ScenarioModelItemsIndex()
+{
+}
+
+ScenarioModelItemsIndex::~ScenarioModelItemsIndex()
+{
+    clear();
+}
+
+void ScenarioModelItemsIndex::clear()
+{
+    int position = 0;
+    destroy(m_root, position);
+    m_root = nullptr;
+}
+
+bool ScenarioModelItemsIndex::isEmpty() const
+{
+    return m_root == nullptr;
+}
+
+bool ScenarioModelItemsIndex::contains(int _position) const
+{
+    return value(_position) != nullptr;
+}
+
+ScenarioModelItem* ScenarioModelItemsIndex::value(int _position) const
+{
+    int nodePosition = 0;
+    const Node* node = lowerBoundNode(_position, &nodePosition);
+    if (node == nullptr
+        || nodePosition != _position) {
+        return nullptr;
+    }
+
+    return node->item;
+}
+
+ScenarioModelItem* ScenarioModelItemsIndex::lowerBound(int _position) const
+{
+    const Node* node = lowerBoundNode(_position);
+    return node != nullptr ? node->item : nullptr;
+}
+
+ScenarioModelItem* ScenarioModelItemsIndex::nearest(int _position) const
+{
+    int nodePosition = 0;
+    const Node* node = lowerBoundNode(_position, &nodePosition);
+    if (node != nullptr
+        && nodePosition == _position) {
+        return node->item;
+    }
+
+    //
+    // Берём предшествующий найденному элемент, а если найденного нет, то последний
+    //
+    const Node* previous = nullptr;
+    if (node != nullptr) {
+        previous = previousNode(node);
+    } else {
+        previous = m_root;
+        while (previous != nullptr
+               && previous->right != nullptr) {
+            previous = previous->right;
+        }
+    }
+
+    if (previous != nullptr) {
+        return previous->item;
+    }
+    return node != nullptr ? node->item : nullptr;
+}
+
+ScenarioModelItem* ScenarioModelItemsIndex::previous(const ScenarioModelItem* _item) const
+{
+    if (_item == nullptr
+        || _item->m_indexNode == nullptr) {
+        return nullptr;
+    }
+
+    const Node* previous = previousNode(_item->m_indexNode);
+    return previous != nullptr ? previous->item : nullptr;
+}
+
+qreal ScenarioModelItemsIndex::durationBefore(const ScenarioModelItem* _item) const
+{
+    if (_item == nullptr
+        || _item->m_indexNode == nullptr) {
+        return 0;
+    }
+
+    const Node* itemNode = _item->m_indexNode;
+    qreal duration = durationSum(itemNode->left);
+    for (const Node* node = itemNode; node->parent != nullptr; node = node->parent) {
+        const Node* parent = node->parent;
+        if (parent->right == node) {
+            duration += durationSum(parent->left) + parent->duration;
+        }
+    }
+    return duration;
+}
+
+void ScenarioModelItemsIndex::insert(int _position, ScenarioModelItem* _item)
+{
+    if (_item->m_indexNode != nullptr) {
+        remove(_item);
+    }
+
+    int nodePosition = 0, nodeIndex = 0;
+    Node* node = lowerBoundNode(_position, &nodePosition, &nodeIndex);
+
+    //
+    // Если в позиции уже есть элемент, то замещаем его
+    //
+    if (node != nullptr
+        && nodePosition == _position) {
+        node->item->m_position = _position;
+        node->item->m_indexNode = nullptr;
+        node->item = _item;
+        _item->m_indexNode = node;
+        updateDuration(node);
+        return;
+    }
+
+    //
+    // В противном случае вставляем новый узел, смещения нового и последующего узлов
+    // отсчитываются от предыдущих им узлов
+    //
+    Node* left = nullptr;
+    Node* right = nullptr;
+    split(m_root, nodeIndex, left, right);
+
+    Node* newNode = new Node;
+    newNode->item = _item;
+    newNode->offset = _position - sum(left);
+    newNode->duration = indexedDuration(_item);
+    pull(newNode);
+    addToFirst(right, -newNode->offset);
+    _item->m_indexNode = newNode;
+
+    m_root = merge(merge(left, newNode), right);
+    m_root->parent = nullptr;
+}
+
+void ScenarioModelItemsIndex::remove(ScenarioModelItem* _item)
+{
+    Node* node = _item->m_indexNode;
+    if (node == nullptr) {
+        return;
+    }
+
+    _item->m_position = position(node);
+    _item->m_indexNode = nullptr;
+    removeAt(indexOf(node));
+}
+
+void ScenarioModelItemsIndex::shift(int _fromPosition, int _delta)
+{
+    if (_delta == 0) {
+        return;
+    }
+
+    int nodePosition = 0, nodeIndex = 0;
+    Node* node = lowerBoundNode(_fromPosition, &nodePosition, &nodeIndex);
+    if (node == nullptr) {
+        return;
+    }
+
+    //
+    // Смещения последующих узлов относительны, поэтому достаточно изменить смещение первого
+    //
+    node->offset += _delta;
+    for (Node* parent = node; parent != nullptr; parent = parent->parent) {
+        pull(parent);
+    }
+
+    //
+    // Удаляем предшествующие элементы, которые оказались не перед смещёнными
+    //
+    nodePosition += _delta;
+    while (nodeIndex > 0) {
+        Node* previous = previousNode(node);
+        const int previousPosition = position(previous);
+        if (previousPosition < nodePosition) {
+            break;
+        }
+
+        previous->item->m_position = previousPosition;
+        previous->item->m_indexNode = nullptr;
+        removeAt(--nodeIndex);
+    }
+}
+
+ScenarioModelItemsIndex::Node* ScenarioModelItemsIndex::lowerBoundNode(int _position, int* _nodePosition, int* _nodeIndex) const
+{
+    Node* result = nullptr;
+    int resultPosition = 0;
+    int basePosition = 0;
+    int baseIndex = 0;
+    Node* node = m_root;
+    while (node != nullptr) {
+        const int currentPosition = basePosition + sum(node->left) + node->offset;
+        if (currentPosition >= _position) {
+            result = node;
+            resultPosition = currentPosition;
+            node = node->left;
+        } else {
+            basePosition = currentPosition;
+            baseIndex += count(node->left) + 1;
+            node = node->right;
+        }
+    }
+
+    if (_nodePosition != nullptr) {
+        *_nodePosition = resultPosition;
+    }
+    //
+    // ... по завершении спуска это количество узлов с позицией меньше заданной
+    //
+    if (_nodeIndex != nullptr) {
+        *_nodeIndex = baseIndex;
+    }
+    return result;
+}
+
+int ScenarioModelItemsIndex::indexOf(const Node* _node)
+{
+    int index = count(_node->left);
+    for (const Node* node = _node; node->parent != nullptr; node = node->parent) {
+        const Node* parent = node->parent;
+        if (parent->right == node) {
+            index += count(parent->left) + 1;
+        }
+    }
+    return index;
+}
+
+ScenarioModelItemsIndex::Node* ScenarioModelItemsIndex::previousNode(const Node* _node)
+{
+    if (_node->left != nullptr) {
+        Node* node = _node->left;
+        while (node->right != nullptr) {
+            node = node->right;
+        }
+        return node;
+    }
+
+    const Node* node = _node;
+    while (node->parent != nullptr
+           && node->parent->left == node) {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+void ScenarioModelItemsIndex::removeAt(int _index)
+{
+    Node* left = nullptr;
+    Node* node = nullptr;
+    Node* right = nullptr;
+    split(m_root, _index, left, right);
+    split(right, 1, node, right);
+
+    //
+    // Смещение следующего узла теперь отсчитывается от предшествующего удаляемому
+    //
+    addToFirst(right, node->offset);
+    delete node;
+
+    m_root = merge(left, right);
+    if (m_root != nullptr) {
+        m_root->parent = nullptr;
+    }
+}
+
+int ScenarioModelItemsIndex::sum(const Node* _node)
+{
+    return _node != nullptr ? _node->sum : 0;
+}
+
+int ScenarioModelItemsIndex::count(const Node* _node)
+{
+    return _node != nullptr ? _node->count : 0;
+}
+
+qreal ScenarioModelItemsIndex::durationSum(const Node* _node)
+{
+    return _node != nullptr ? _node->durationSum : 0;
+}
+
+void ScenarioModelItemsIndex::pull(Node* _node)
+{
+    _node->sum = sum(_node->left) + _node->offset + sum(_node->right);
+    _node->count = count(_node->left) + 1 + count(_node->right);
+    _node->durationSum = durationSum(_node->left) + _node->duration + durationSum(_node->right);
+    if (_node->left != nullptr) {
+        _node->left->parent = _node;
+    }
+    if (_node->right != nullptr) {
+        _node->right->parent = _node;
+    }
+}
+
+void ScenarioModelItemsIndex::addToFirst(Node* _node, int _delta)
+{
+    for (Node* node = _node; node != nullptr; node = node->left) {
+        node->sum += _delta;
+        if (node->left == nullptr) {
+            node->offset += _delta;
+        }
+    }
+}
+
+ScenarioModelItemsIndex::Node* ScenarioModelItemsIndex::merge(Node* _left, Node* _right)
+{
+    if (_left == nullptr) {
+        return _right;
+    }
+    if (_right == nullptr) {
+        return _left;
+    }
+
+    if (_left->priority > _right->priority) {
+        _left->right = merge(_left->right, _right);
+        pull(_left);
+        return _left;
+    }
+
+    _right->left = merge(_left, _right->left);
+    pull(_right);
+    return _right;
+}
+
+void ScenarioModelItemsIndex::split(Node* _node, int _count, Node*& _left, Node*& _right)
+{
+    if (_node == nullptr) {
+        _left = nullptr;
+        _right = nullptr;
+        return;
+    }
+
+    if (_count <= count(_node->left)) {
+        split(_node->left, _count, _left, _node->left);
+        _right = _node;
+    } else {
+        split(_node->right, _count - count(_node->left) - 1, _node->right, _right);
+        _left = _node;
+    }
+    pull(_node);
+}
+
+void ScenarioModelItemsIndex::destroy(Node* _node, int& _position)
+{
+    if (_node == nullptr) {
+        return;
+    }
+
+    //
+    // Обходим узлы по порядку, накапливая позицию, чтобы отвязать элементы от узлов
+    //
+    destroy(_node->left, _position);
+    _position += _node->offset;
+    _node->item->m_position = _position;
+    _node->item->m_indexNode = nullptr;
+    Node* right = _node->right;
+    delete _node;
+    destroy(right, _position);
+}
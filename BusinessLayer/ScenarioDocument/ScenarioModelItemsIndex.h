@@ -0,0 +1,156 @@
+#ifndef SCENARIOMODELITEMSINDEX_H
+#define SCENARIOMODELITEMSINDEX_H
+
+#include <QtGlobal>
+
+
+namespace BusinessLogic
+{
+    class ScenarioModelItem;
+
+
+    /**
+     * @brief Индекс позиций элементов модели сценария в тексте документа
+     *
+     * Элементы хранятся в декартовом дереве по неявному ключу (порядку следования в тексте),
+     * причём каждый узел хранит не абсолютную позицию элемента, а смещение относительно
+     * предыдущего элемента. Благодаря этому сдвиг позиций всех элементов после места изменения
+     * текста сводится к изменению смещения одного узла и выполняется за логарифмическое время,
+     * как и поиск элемента по позиции
+     *
+     * Кроме того, узлы агрегируют длительность сцен своих поддеревьев, что позволяет получать
+     * суммарный хронометраж всех сцен перед заданным элементом за логарифмическое время
+     *
+     * @note Пока элемент находится в индексе, его позиция определяется индексом
+     */
+    class ScenarioModelItemsIndex
+    {
+    public:
+        /**
+         * @brief Узел дерева
+         */
+        struct Node;
+
+        /**
+         * @brief Получить позицию элемента, находящегося в узле
+         */
+        static int position(const Node* _node);
+
+        /**
+         * @brief Обновить длительность элемента, находящегося в узле
+         */
+        static void updateDuration(Node* _node);
+
+    public:
+        ScenarioModelItemsIndex();
+        ~ScenarioModelItemsIndex();
+
+        /**
+         * @brief Очистить индекс
+         * @note Элементы запоминают позиции, которые они имели в индексе
+         */
+        void clear();
+
+        /**
+         * @brief Пуст ли индекс
+         */
+        bool isEmpty() const;
+
+        /**
+         * @brief Есть ли элемент в заданной позиции
+         */
+        bool contains(int _position) const;
+
+        /**
+         * @brief Получить элемент в заданной позиции, или nullptr, если такого нет
+         */
+        ScenarioModelItem* value(int _position) const;
+
+        /**
+         * @brief Получить первый элемент, позиция которого не меньше заданной
+         */
+        ScenarioModelItem* lowerBound(int _position) const;
+
+        /**
+         * @brief Получить элемент, в который входит заданная позиция, а если позиция находится
+         *        перед всеми элементами, то первый элемент
+         */
+        ScenarioModelItem* nearest(int _position) const;
+
+        /**
+         * @brief Получить предыдущий элемент
+         */
+        ScenarioModelItem* previous(const ScenarioModelItem* _item) const;
+
+        /**
+         * @brief Получить суммарную длительность сцен, предшествующих элементу
+         */
+        qreal durationBefore(const ScenarioModelItem* _item) const;
+
+        /**
+         * @brief Добавить элемент в заданную позицию
+         * @note Если в этой позиции уже есть элемент, то он замещается новым
+         */
+        void insert(int _position, ScenarioModelItem* _item);
+
+        /**
+         * @brief Удалить элемент из индекса
+         * @note Элемент запоминает позицию, которую он имел в индексе
+         */
+        void remove(ScenarioModelItem* _item);
+
+        /**
+         * @brief Сместить позиции всех элементов, начиная с заданной позиции
+         * @note Если после смещения элементы совпадут по позиции с предшествующими, то
+         *       в индексе останутся смещённые
+         */
+        void shift(int _fromPosition, int _delta);
+
+    private:
+        /**
+         * @brief Найти первый узел, позиция которого не меньше заданной
+         * @param _nodePosition - позиция найденного узла
+         * @param _nodeIndex - порядковый номер найденного узла
+         */
+        Node* lowerBoundNode(int _position, int* _nodePosition = nullptr, int* _nodeIndex = nullptr) const;
+
+        /**
+         * @brief Получить порядковый номер узла
+         */
+        static int indexOf(const Node* _node);
+
+        /**
+         * @brief Получить предыдущий узел
+         */
+        static Node* previousNode(const Node* _node);
+
+        /**
+         * @brief Удалить узел с заданным порядковым номером
+         */
+        void removeAt(int _index);
+
+        /**
+         * @brief Операции с деревом
+         */
+        /** @{ */
+        static int sum(const Node* _node);
+        static int count(const Node* _node);
+        static qreal durationSum(const Node* _node);
+        static void pull(Node* _node);
+        static void addToFirst(Node* _node, int _delta);
+        static Node* merge(Node* _left, Node* _right);
+        static void split(Node* _node, int _count, Node*& _left, Node*& _right);
+        static void destroy(Node* _node, int& _position);
+        /** @} */
+
+    private:
+        /**
+         * @brief Корень дерева
+         */
+        Node* m_root = nullptr;
+
+        Q_DISABLE_COPY(ScenarioModelItemsIndex)
+    };
+}
+
+#endif // SCENARIOMODELITEMSINDEX_H
@@ -79,7 +79,7 @@ ScenarioReviewModel::ScenarioReviewModel(ScenarioTextDocument *_parent) :
 {
     Q_ASSERT(_parent);
 
-    connect(m_document, &ScenarioTextDocument::contentsChange, this, &ScenarioReviewModel::aboutUpdateReviewModel);
+    connect(m_document, &ScenarioTextDocument::mergedContentsChange, this, &ScenarioReviewModel::aboutUpdateReviewModel);
 }
 
 bool ScenarioReviewModel::isEmpty()
@@ -96,6 +96,58 @@ void TextBlockInfo::setDiffType(TextBlockInfo::DiffType _type)
     updateId();
 }
 
+bool TextBlockInfo::hasCounter(int _revision) const
+{
+    return m_isCounterActual
+            && m_counterRevision == _revision;
+}
+
+BusinessLogic::Counter TextBlockInfo::counter() const
+{
+    return m_counter;
+}
+
+void TextBlockInfo::setCounter(const Counter& _counter, int _revision)
+{
+    m_counter = _counter;
+    m_counterRevision = _revision;
+    m_isCounterActual = true;
+}
+
+void TextBlockInfo::resetCounter()
+{
+    m_isCounterActual = false;
+}
+
+bool TextBlockInfo::hasDuration(int _revision, int _settingsRevision, int _linesCount, qreal _pageHeight) const
+{
+    return m_isDurationActual
+            && m_durationRevision == _revision
+            && m_durationSettingsRevision == _settingsRevision
+            && m_durationLinesCount == _linesCount
+            && qFuzzyCompare(m_durationPageHeight + 1, _pageHeight + 1);
+}
+
+qreal TextBlockInfo::duration() const
+{
+    return m_duration;
+}
+
+void TextBlockInfo::setDuration(qreal _duration, int _revision, int _settingsRevision, int _linesCount, qreal _pageHeight)
+{
+    m_duration = _duration;
+    m_durationRevision = _revision;
+    m_durationSettingsRevision = _settingsRevision;
+    m_durationLinesCount = _linesCount;
+    m_durationPageHeight = _pageHeight;
+    m_isDurationActual = true;
+}
+
+void TextBlockInfo::resetDuration()
+{
+    m_isDurationActual = false;
+}
+
 
 // ****
 
@@ -1,6 +1,8 @@
 #ifndef SCENARIOTEXTBLOCKINFO_H
 #define SCENARIOTEXTBLOCKINFO_H
 
+#include <BusinessLayer/Counters/Counter.h>
+
 #include <QTextBlockUserData>
 
 namespace BusinessLogic
@@ -73,6 +75,30 @@ namespace BusinessLogic
          */
         void setDiffType(DiffType _type);
 
+        /**
+         * @brief Закэшированный счётчик слов и символов текста блока
+         * @note Не влияет на айди блока, т.к. не является данными сценария
+         */
+        /** @{ */
+        bool hasCounter(int _revision) const;
+        Counter counter() const;
+        void setCounter(const Counter& _counter, int _revision);
+        void resetCounter();
+        /** @} */
+
+        /**
+         * @brief Закэшированный хронометраж блока
+         * @note Действителен для ревизии блока, ревизии параметров хронометража, количества строк
+         *       и высоты области текста на странице, при которых он был рассчитан.
+         *       Не влияет на айди блока
+         */
+        /** @{ */
+        bool hasDuration(int _revision, int _settingsRevision, int _linesCount, qreal _pageHeight) const;
+        qreal duration() const;
+        void setDuration(qreal _duration, int _revision, int _settingsRevision, int _linesCount, qreal _pageHeight);
+        void resetDuration();
+        /** @} */
+
     private:
         /**
          * @brief Глобальный айди блока, используется в качестве хэша
@@ -98,6 +124,27 @@ namespace BusinessLogic
          * @brief Цвет фона, при сравнении документов
          */
         QColor m_diffColor;
+
+        /**
+         * @brief Закэшированный счётчик и ревизия блока, для которой он рассчитан
+         */
+        /** @{ */
+        Counter m_counter;
+        int m_counterRevision = 0;
+        bool m_isCounterActual = false;
+        /** @} */
+
+        /**
+         * @brief Закэшированный хронометраж и параметры, для которых он рассчитан
+         */
+        /** @{ */
+        qreal m_duration = 0;
+        int m_durationRevision = 0;
+        int m_durationSettingsRevision = 0;
+        int m_durationLinesCount = 0;
+        qreal m_durationPageHeight = 0;
+        bool m_isDurationActual = false;
+        /** @} */
     };
 
     /**
@@ -19,9 +19,9 @@
 #include <3rd_party/Widgets/QLightBoxWidget/qlightboxprogress.h>
 
 #include <QApplication>
-#include <QCryptographicHash>
 #include <QDomDocument>
 #include <QTextBlock>
+#include <QXmlStreamReader>
 
 //
 // Для отладки работы с патчами
@@ -41,13 +41,28 @@ namespace {
     const int MAX_UNDO_REDO_STACK_SIZE = 100;
 
     /**
-     * @brief Получить хэш текста
+     * @brief Минимальная длина контекста изменения, используемого при формировании патчей
+     * @note Соответствует максимальной длине контекста, который добавляет к патчу diff_match_patch
      */
-    static QByteArray textMd5Hash(const QString& _text) {
-        QCryptographicHash hash(QCryptographicHash::Md5);
-        hash.addData(_text.toUtf8());
-        return hash.result();
-    }
+    const int PATCH_CONTEXT_LENGTH = 32;
+
+    /**
+     * @brief Тэг, с которого начинается текст каждого блока в xml
+     */
+    const QString kBlockTextTag = "<v><![CDATA[";
+
+    /**
+     * @brief Количество блоков, загружаемых сразу при открытии большого сценария,
+     *        с запасом на первый экран
+     */
+    const int kFirstLoadingPartBlocks = 200;
+
+    /**
+     * @brief Количество блоков в каждой из догружаемых частей сценария
+     * @note Меньше интервала обработки событий при вставке блоков из xml, чтобы части
+     *       не загружались рекурсивно по таймеру во время загрузки предыдущей
+     */
+    const int kLoadingPartBlocks = 400;
 
     /**
      * @brief Сохранить изменение
@@ -74,6 +89,14 @@ namespace {
 void ScenarioTextDocument::updateBlockRevision(QTextBlock& _block)
 {
     _block.setRevision(_block.revision() + 1);
+
+    if (TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(_block.userData())) {
+        blockInfo->updateId();
+        blockInfo->resetCounter();
+        blockInfo->resetDuration();
+    }
+
+    markBlockDataChanged(_block);
 }
 
 void ScenarioTextDocument::updateBlockRevision(QTextCursor& _cursor)
@@ -82,31 +105,52 @@ void ScenarioTextDocument::updateBlockRevision(QTextCursor& _cursor)
     updateBlockRevision(block);
 }
 
+void ScenarioTextDocument::markBlockDataChanged(const QTextBlock& _block)
+{
+    const ScenarioTextDocument* document = qobject_cast<const ScenarioTextDocument*>(_block.document());
+    if (document != nullptr) {
+        const_cast<ScenarioTextDocument*>(document)->m_xmlSnapshot.markBlockChanged(_block);
+    }
+}
+
 ScenarioTextDocument::ScenarioTextDocument(QObject *parent, ScenarioXml* _xmlHandler) :
     QTextDocument(parent),
     m_xmlHandler(_xmlHandler),
     m_isPatchApplyProcessed(false),
+    m_xmlSnapshot(this, _xmlHandler),
     m_reviewModel(new ScenarioReviewModel(this)),
     m_bookmarksModel(new ScriptBookmarksModel(this)),
     m_outlineMode(false),
     m_corrector(new ScriptTextCorrector(this))
 {
-    connect(this, &ScenarioTextDocument::contentsChange, this, &ScenarioTextDocument::updateBlocksIds);
+    connect(this, &ScenarioTextDocument::contentsChange, this, &ScenarioTextDocument::aboutContentsChange);
+    connect(this, &ScenarioTextDocument::contentsChanged, this, &ScenarioTextDocument::aboutContentsChanged);
+    connect(this, &ScenarioTextDocument::mergedContentsChange, this, &ScenarioTextDocument::updateBlocksIds);
     connect(m_reviewModel, &ScenarioReviewModel::reviewChanged, this, &ScenarioTextDocument::reviewChanged);
     connect(m_bookmarksModel, &ScriptBookmarksModel::modelChanged, this, &ScenarioTextDocument::bookmarksChanged);
+
+    m_loadingTimer.setInterval(0);
+    connect(&m_loadingTimer, &QTimer::timeout, this, &ScenarioTextDocument::loadNextPart);
 }
 
-bool ScenarioTextDocument::updateScenarioXml()
+bool ScenarioTextDocument::updateScenarioXml(int _position, int _charsRemoved, int _charsAdded)
 {
-    if (!m_isPatchApplyProcessed) {
-        const QString newScenarioXml = m_xmlHandler->scenarioToXml();
-        const QByteArray newScenarioXmlHash = ::textMd5Hash(newScenarioXml);
+    //
+    // Снимок обновляем всегда, чтобы он соответствовал тексту документа
+    //
+    m_xmlSnapshot.update(_position, _charsRemoved, _charsAdded);
+
+    //
+    // Догружаемые части сценария уже учтены в сохранённом xml, поэтому изменением не считаются
+    //
+    if (!m_isPatchApplyProcessed
+        && !m_isLoadingPartProcessed) {
+        const quint64 newScenarioXmlHash = m_xmlSnapshot.hash();
 
         //
         // Если текущий текст сценария отличается от последнего сохранённого
         //
         if (newScenarioXmlHash != m_scenarioXmlHash) {
-            m_scenarioXml = newScenarioXml;
             m_scenarioXmlHash = newScenarioXmlHash;
             return true;
         }
@@ -116,10 +160,33 @@ bool ScenarioTextDocument::updateScenarioXml()
 
 QString ScenarioTextDocument::scenarioXml() const
 {
-    return m_scenarioXml;
+    //
+    // Полный xml собираем только если он отличается от последнего сохранённого
+    //
+    if (m_scenarioXmlHash == m_lastSavedScenarioXmlHash) {
+        return m_lastSavedScenarioXml;
+    }
+
+    //
+    // Если сценарий ещё догружается, то дополняем xml загруженных блоков xml незагруженных частей,
+    // чтобы не сохранить только часть сценария
+    //
+    if (isLoading()) {
+        const QString header = ScenarioXml::mimeHeader();
+        const QString footer = ScenarioXml::mimeFooter();
+        QString xml = m_xmlSnapshot.xml();
+        xml.chop(footer.size());
+        for (const QString& part : m_notLoadedParts) {
+            xml.append(part.midRef(header.size(), part.size() - header.size() - footer.size()));
+        }
+        xml.append(footer);
+        return xml;
+    }
+
+    return m_xmlSnapshot.xml();
 }
 
-QByteArray ScenarioTextDocument::scenarioXmlHash() const
+quint64 ScenarioTextDocument::scenarioXmlHash() const
 {
     return m_scenarioXmlHash;
 }
@@ -147,14 +214,34 @@ void ScenarioTextDocument::load(const QString& _scenarioXml)
     setOutlineMode(false);
 
     //
-    // Загружаем проект
+    // Загружаем проект, если он большой, то сразу загружаем только первую часть,
+    // а остальные догружаем при простое
     //
+    m_loadingTimer.stop();
+    m_notLoadedParts = ScenarioXml::splitXml(scenarioXml, kFirstLoadingPartBlocks, kLoadingPartBlocks);
+    m_loadingPartsCount = m_notLoadedParts.size();
+    const QString firstPart = m_notLoadedParts.takeFirst();
     const bool remainLinkedData = true;
-    m_xmlHandler->xmlToScenario(0, scenarioXml, remainLinkedData);
-    m_scenarioXml = scenarioXml;
-    m_scenarioXmlHash = ::textMd5Hash(scenarioXml);
-    m_lastSavedScenarioXml = m_scenarioXml;
+    m_xmlHandler->xmlToScenario(0, firstPart, remainLinkedData);
+    m_xmlSnapshot.rebuild();
+    m_isFirstLoadingPartActual = m_xmlSnapshot.hash() == ScenarioXmlSnapshot::textHash(firstPart);
+    //
+    // ... сохранённым считаем весь текст сценария, даже если он ещё не загружен целиком
+    //
+    m_scenarioXmlHash = ScenarioXmlSnapshot::textHash(scenarioXml);
+    m_lastSavedScenarioXml = scenarioXml;
     m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
+    //
+    // ... патчи по изменённым фрагментам можно формировать, только если загруженный xml
+    //     совпадает со сформированным из документа
+    //
+    if (!isLoading()) {
+        if (m_xmlSnapshot.hash() == m_scenarioXmlHash) {
+            m_xmlSnapshot.markSaved();
+        }
+    } else {
+        m_loadingTimer.start();
+    }
 
     //
     // Восстанавливаем режим
@@ -166,6 +253,10 @@ void ScenarioTextDocument::load(const QString& _scenarioXml)
 
     emit redoAvailableChanged(false);
 
+    if (isLoading()) {
+        emit loadingProgressChanged(100 / m_loadingPartsCount);
+    }
+
 #ifdef PATCH_DEBUG
     foreach (DomainObject* obj, DataStorageLayer::StorageFacade::scenarioChangeStorage()->all()->toList()) {
         ScenarioChange* ch = dynamic_cast<ScenarioChange*>(obj);
@@ -182,6 +273,19 @@ void ScenarioTextDocument::load(const QString& _scenarioXml)
 #endif
 }
 
+bool ScenarioTextDocument::isLoading() const
+{
+    return !m_notLoadedParts.isEmpty();
+}
+
+void ScenarioTextDocument::finishLoading()
+{
+    while (isLoading()
+           && !m_isLoadingPartProcessed) {
+        loadNextPart();
+    }
+}
+
 QString ScenarioTextDocument::mimeFromSelection(int _startPosition, int _endPosition) const
 {
     QString mime;
@@ -209,16 +313,32 @@ void ScenarioTextDocument::insertFromMime(int _insertPosition, const QString& _m
 
 int ScenarioTextDocument::applyPatch(const QString& _patch, bool _checkXml)
 {
-    updateScenarioXml();
+    //
+    // Патчи формируются для сценария целиком, поэтому применяем их к полностью загруженному
+    //
+    finishLoading();
+
     saveChanges();
 
     m_isPatchApplyProcessed = true;
 
     //
-    // Определим xml для применения патча
+    // Сперва пробуем применить патч только к затрагиваемым им блокам
     //
     const QString patchUncopressed = DatabaseHelper::uncompress(_patch);
-    auto xmlsForUpdate = DiffMatchPatchHelper::changedXml(m_scenarioXml, patchUncopressed, _checkXml);
+    const int fragmentPosition = applyPatchToFragment(patchUncopressed, _checkXml);
+    if (fragmentPosition != -1) {
+        //
+        // Запомним новый текст, чтобы применённый патч не попал в историю изменений повторно
+        //
+        rememberSnapshotAsSaved();
+        return fragmentPosition;
+    }
+
+    //
+    // Если не получилось, то определим xml для применения патча по всему тексту сценария
+    //
+    auto xmlsForUpdate = DiffMatchPatchHelper::changedXml(scenarioXml(), patchUncopressed, _checkXml);
     if (!xmlsForUpdate.first.isValid()
         || !xmlsForUpdate.second.isValid()) {
 
@@ -288,39 +408,36 @@ int ScenarioTextDocument::applyPatch(const QString& _patch, bool _checkXml)
     const bool remainLinkedData = true;
     m_xmlHandler->xmlToScenario(selectionStartPos, xmlsForUpdate.second.xml, remainLinkedData);
 
-    //
-    // Запомним новый текст
-    //
-    m_scenarioXml = m_xmlHandler->scenarioToXml();
-    m_scenarioXmlHash = ::textMd5Hash(m_scenarioXml);
-    m_lastSavedScenarioXml = m_scenarioXml;
-    m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
-
     //
     // Патч применён
     //
     m_isPatchApplyProcessed = false;
 
     //
-    // Завершаем изменение документа
-    // если завершить изменение сразу после вставки текста, но до запоминания его хэша, то
-    // может случиться проблема, что текущий хэш и хэш документа совпадут, что приведёт к
-    // отсутствию одного патча в истории изменений
+    // Завершаем изменение документа, при этом снимок xml обновляется по изменившимся блокам
     //
     cursor.endEditBlock();
 
+    //
+    // Запомним новый текст, чтобы применённый патч не попал в историю изменений повторно
+    //
+    rememberSnapshotAsSaved();
+
     return selectionStartPos;
 }
 
 void ScenarioTextDocument::applyPatches(const QList<QString>& _patches)
 {
+    finishLoading();
+
     m_isPatchApplyProcessed = true;
 
 
     //
     // Применяем патчи
     //
-    QString newXml = m_scenarioXml;
+    const QString currentXml = scenarioXml();
+    QString newXml = currentXml;
     int currentIndex = 0, max = _patches.size();
 
 #ifdef PATCH_DEBUG
@@ -371,7 +488,19 @@ void ScenarioTextDocument::applyPatches(const QList<QString>& _patches)
     }
 
     //
-    // Начинаем изменение текста
+    // Заменяем только группы блоков, xml которых изменился, чтобы остальные блоки
+    // сохранили свою разметку и пользовательские данные
+    //
+    if (applyXmlToFragment(currentXml, newXml)) {
+        //
+        // Запомним новый текст, чтобы применённые патчи не попали в историю изменений повторно
+        //
+        rememberSnapshotAsSaved();
+        return;
+    }
+
+    //
+    // Если не получилось, то начинаем изменение текста
     //
     QTextCursor cursor(this);
     cursor.beginEditBlock();
@@ -387,43 +516,81 @@ void ScenarioTextDocument::applyPatches(const QList<QString>& _patches)
     const bool remainLinkedData = true;
     m_xmlHandler->xmlToScenario(0, ScenarioXml::makeMimeFromXml(newXml), remainLinkedData);
 
-    //
-    // Запомним новый текст
-    //
-    m_scenarioXml = m_xmlHandler->scenarioToXml();
-    m_scenarioXmlHash = ::textMd5Hash(m_scenarioXml);
-    m_lastSavedScenarioXml = m_scenarioXml;
-    m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
-
     //
     // Патч применён
     //
     m_isPatchApplyProcessed = false;
 
     //
-    // Завершаем изменение документа
-    // если завершить изменение сразу после вставки текста, но до запоминания его хэша, то
-    // может случиться проблема, что текущий хэш и хэш документа совпадут, что приведёт к
-    // отсутствию одного патча в истории изменений
+    // Завершаем изменение документа, при этом снимок xml обновляется по изменившимся блокам
     //
     cursor.endEditBlock();
+
+    //
+    // Запомним новый текст, чтобы применённые патчи не попали в историю изменений повторно
+    //
+    rememberSnapshotAsSaved();
 }
 
 Domain::ScenarioChange* ScenarioTextDocument::saveChanges()
 {
     Domain::ScenarioChange* change = 0;
 
+    //
+    // Пока сценарий догружается, сохранённым считается весь его текст, поэтому изменения
+    // пользователя можно сформировать только после загрузки оставшихся частей, а сверять
+    // с сохранённым текстом частично загруженный документ нельзя
+    //
+    if (isLoading()) {
+        if (m_scenarioXmlHash == m_lastSavedScenarioXmlHash) {
+            return change;
+        }
+
+        finishLoading();
+        if (isLoading()) {
+            return change;
+        }
+    }
+
     if (!m_isPatchApplyProcessed) {
+        //
+        // Учтём в снимке xml изменения пользовательских данных блоков, о которых документ
+        // не уведомляет, формируется xml только отмеченных блоков, поэтому делаем это и тогда,
+        // когда текст не изменялся
+        //
+        if (m_xmlSnapshot.isValidationNeeded()
+            || m_scenarioXmlHash != m_lastSavedScenarioXmlHash) {
+            m_xmlSnapshot.validate();
+            m_scenarioXmlHash = m_xmlSnapshot.hash();
+        }
+
         //
         // Если текущий текст сценария отличается от последнего сохранённого
         //
         if (m_scenarioXmlHash != m_lastSavedScenarioXmlHash) {
             //
-            // Сформируем изменения
+            // Сформируем изменения, если известно какой фрагмент xml изменился, то сравниваем
+            // только его, в противном случае сравниваем xml целиком
             //
-            const QString undoPatch = DiffMatchPatchHelper::makePatchXml(m_scenarioXml, m_lastSavedScenarioXml);
+            QString undoPatch;
+            QString redoPatch;
+            ScenarioXmlSnapshot::Change xmlChange;
+            const int savedXmlChangeLength =
+                    m_xmlSnapshot.changeSinceSaved(PATCH_CONTEXT_LENGTH, xmlChange)
+                    ? m_lastSavedScenarioXml.size() - xmlChange.xmlPosition - xmlChange.xmlTailSize
+                    : -1;
+            if (savedXmlChangeLength >= 0) {
+                const QString savedXmlChange = m_lastSavedScenarioXml.mid(xmlChange.xmlPosition, savedXmlChangeLength);
+                undoPatch = DiffMatchPatchHelper::makePatchXml(xmlChange.xml, savedXmlChange, xmlChange.plainPosition);
+                redoPatch = DiffMatchPatchHelper::makePatchXml(savedXmlChange, xmlChange.xml, xmlChange.plainPosition);
+                m_lastSavedScenarioXml.replace(xmlChange.xmlPosition, savedXmlChangeLength, xmlChange.xml);
+            } else {
+                const QString scenarioXml = m_xmlSnapshot.xml();
+                undoPatch = DiffMatchPatchHelper::makePatchXml(scenarioXml, m_lastSavedScenarioXml);
+                redoPatch = DiffMatchPatchHelper::makePatchXml(m_lastSavedScenarioXml, scenarioXml);
+                m_lastSavedScenarioXml = scenarioXml;
+            }
             const QString undoPatchCompressed = DatabaseHelper::compress(undoPatch);
-            const QString redoPatch = DiffMatchPatchHelper::makePatchXml(m_lastSavedScenarioXml, m_scenarioXml);
             const QString redoPatchCompressed = DatabaseHelper::compress(redoPatch);
 
             //
@@ -434,8 +601,8 @@ Domain::ScenarioChange* ScenarioTextDocument::saveChanges()
             //
             // Запомним новый текст
             //
-            m_lastSavedScenarioXml = m_scenarioXml;
             m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
+            m_xmlSnapshot.markSaved();
 
             //
             // Корректируем стеки последних действий
@@ -661,6 +828,308 @@ void ScenarioTextDocument::correct(int _position, int _charsRemoved, int _charsA
     m_corrector->correct(_position, _charsRemoved, _charsAdded);
 }
 
+void ScenarioTextDocument::beginChangesBatch()
+{
+    ++m_changesBatchLevel;
+}
+
+void ScenarioTextDocument::endChangesBatch()
+{
+    if (m_changesBatchLevel == 0) {
+        return;
+    }
+
+    --m_changesBatchLevel;
+    if (m_changesBatchLevel > 0) {
+        return;
+    }
+
+    //
+    // Передаём накопленное изменение обработчикам
+    //
+    const BatchChange change = m_batchChange;
+    m_batchChange = BatchChange();
+    if (change.position != -1) {
+        emit mergedContentsChange(change.position, change.charsRemoved, change.charsAdded);
+    }
+    if (change.isChanged) {
+        emit mergedContentsChanged();
+    }
+}
+
+int ScenarioTextDocument::applyPatchToFragment(const QString& _patch, bool _checkXml)
+{
+    //
+    // Определим группы блоков, которые затрагивает патч
+    //
+    int plainFrom = 0;
+    int plainTo = 0;
+    ScenarioXmlSnapshot::Fragment fragment;
+    if (!DiffMatchPatchHelper::patchRange(_patch, plainFrom, plainTo)
+        || !m_xmlSnapshot.fragment(plainFrom, plainTo, PATCH_CONTEXT_LENGTH, fragment)) {
+        return -1;
+    }
+
+    //
+    // Применяем патч к их xml
+    //
+    QString fragmentXml;
+    for (const ScenarioXmlSnapshot::Fragment::Part& part : fragment.parts) {
+        fragmentXml.append(part.xml);
+    }
+    QString newXml;
+    if (!DiffMatchPatchHelper::applyPatchXml(fragmentXml, _patch, fragment.plainPosition, newXml)) {
+        return -1;
+    }
+
+    //
+    // Не заменяем группы блоков в начале и в конце фрагмента, xml которых не изменился,
+    // но оставляем для замены хотя бы по одной группе с каждой стороны
+    //
+    auto hasBlock = [&newXml] (int _from, int _to) {
+        const int blockTextPosition = newXml.indexOf(kBlockTextTag, _from);
+        return blockTextPosition != -1 && blockTextPosition < _to;
+    };
+    int firstPart = 0;
+    int lastPart = fragment.parts.size() - 1;
+    int newXmlFrom = 0;
+    int newXmlTo = newXml.length();
+    if (!hasBlock(newXmlFrom, newXmlTo)) {
+        return -1;
+    }
+    while (firstPart < lastPart) {
+        const QString& partXml = fragment.parts.at(firstPart).xml;
+        if (!newXml.midRef(newXmlFrom, newXmlTo - newXmlFrom).startsWith(partXml)
+            || !hasBlock(newXmlFrom + partXml.length(), newXmlTo)) {
+            break;
+        }
+        newXmlFrom += partXml.length();
+        ++firstPart;
+    }
+    while (firstPart < lastPart) {
+        const QString& partXml = fragment.parts.at(lastPart).xml;
+        if (!newXml.midRef(newXmlFrom, newXmlTo - newXmlFrom).endsWith(partXml)
+            || !hasBlock(newXmlFrom, newXmlTo - partXml.length())) {
+            break;
+        }
+        newXmlTo -= partXml.length();
+        --lastPart;
+    }
+
+    return replaceFragment(fragment, firstPart, lastPart,
+                           newXml.mid(newXmlFrom, newXmlTo - newXmlFrom), _checkXml);
+}
+
+bool ScenarioTextDocument::applyXmlToFragment(const QString& _currentXml, const QString& _newXml)
+{
+    if (_currentXml == _newXml) {
+        m_isPatchApplyProcessed = false;
+        return true;
+    }
+
+    //
+    // Позиции изменившейся части определяются в текущем xml, а группы блоков по ним ищутся
+    // в снимке, поэтому заменять фрагмент можно, только если текущий xml и есть xml снимка.
+    // Это не так, например, если сохранённый xml сформирован другой версией программы
+    //
+    if (m_xmlSnapshot.isValidationNeeded()) {
+        m_xmlSnapshot.validate();
+    }
+    if (_currentXml != m_xmlSnapshot.xml()) {
+        return false;
+    }
+
+    //
+    // Определим границы изменившейся части xml
+    //
+    const int minSize = qMin(_currentXml.size(), _newXml.size());
+    int prefixSize = 0;
+    while (prefixSize < minSize
+           && _currentXml.at(prefixSize) == _newXml.at(prefixSize)) {
+        ++prefixSize;
+    }
+    int suffixSize = 0;
+    while (suffixSize < minSize - prefixSize
+           && _currentXml.at(_currentXml.size() - suffixSize - 1)
+              == _newXml.at(_newXml.size() - suffixSize - 1)) {
+        ++suffixSize;
+    }
+
+    //
+    // Определим группы блоков, в которые входит изменившаяся часть, захватывая по символу
+    // с каждой стороны, чтобы учесть вставку на границе групп
+    //
+    int xmlFrom = prefixSize - 1;
+    int xmlTo = _currentXml.size() - suffixSize + 1;
+    int lastPartsCount = 0;
+    ScenarioXmlSnapshot::Fragment fragment;
+    while (m_xmlSnapshot.xmlFragment(xmlFrom, xmlTo, fragment)
+           && fragment.parts.size() > lastPartsCount) {
+        int fragmentXmlSize = 0;
+        for (const ScenarioXmlSnapshot::Fragment::Part& part : fragment.parts) {
+            fragmentXmlSize += part.xml.size();
+        }
+
+        //
+        // Xml после фрагмента одинаков в текущем и новом xml
+        //
+        const int newXmlFrom = fragment.xmlPosition;
+        const int newXmlTo = _newXml.size() - (_currentXml.size() - fragment.xmlPosition - fragmentXmlSize);
+        if (newXmlTo < newXmlFrom) {
+            return false;
+        }
+
+        const int blockTextPosition = _newXml.indexOf(kBlockTextTag, newXmlFrom);
+        if (blockTextPosition != -1
+            && blockTextPosition < newXmlTo) {
+            const bool checkXml = false;
+            return replaceFragment(fragment, 0, fragment.parts.size() - 1,
+                                   _newXml.mid(newXmlFrom, newXmlTo - newXmlFrom), checkXml) != -1;
+        }
+
+        //
+        // Если все блоки фрагмента были удалены, то расширяем его соседними группами,
+        // т.к. на месте фрагмента должен остаться хотя бы один блок
+        //
+        xmlFrom = fragment.xmlPosition - 1;
+        xmlTo = fragment.xmlPosition + fragmentXmlSize + 1;
+        lastPartsCount = fragment.parts.size();
+    }
+
+    return false;
+}
+
+int ScenarioTextDocument::replaceFragment(const ScenarioXmlSnapshot::Fragment& _fragment, int _firstPart, int _lastPart, const QString& _xml, bool _checkXml)
+{
+    //
+    // Формируем xml для вставки, убирая тэги folder и scene_group, чтобы избавиться
+    // от несбалансированного xml
+    //
+    QString xmlForUpdate = _xml;
+    xmlForUpdate.remove("<folder>");
+    xmlForUpdate.remove("</folder>");
+    xmlForUpdate.remove("<scene_group>");
+    xmlForUpdate.remove("</scene_group>");
+    xmlForUpdate = ScenarioXml::makeMimeFromXml(xmlForUpdate);
+    //
+    // ... и если нужно, проверим его валидность
+    //
+    if (_checkXml) {
+        QXmlStreamReader reader(xmlForUpdate);
+        while (!reader.atEnd()) {
+            reader.readNext();
+        }
+        if (reader.hasError()) {
+            return -1;
+        }
+    }
+
+    //
+    // Заменяем изменившиеся группы блоков целиком
+    //
+    const ScenarioXmlSnapshot::Fragment::Part& firstReplacedPart = _fragment.parts.at(_firstPart);
+    const ScenarioXmlSnapshot::Fragment::Part& lastReplacedPart = _fragment.parts.at(_lastPart);
+    const int selectionStartPos = firstReplacedPart.position;
+    const int selectionEndPos = lastReplacedPart.position + lastReplacedPart.length - 1;
+
+    QTextCursor cursor(this);
+    cursor.beginEditBlock();
+    setCursorPosition(cursor, selectionStartPos);
+    setCursorPosition(cursor, selectionEndPos, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    //
+    // ... при этом не изменяем идентификаторов сцен, которые находятся в сценарии
+    //
+    const bool remainLinkedData = true;
+    m_xmlHandler->xmlToScenario(selectionStartPos, xmlForUpdate, remainLinkedData);
+
+    //
+    // Патч применён
+    //
+    m_isPatchApplyProcessed = false;
+
+    //
+    // Завершаем изменение документа, при этом снимок xml обновляется по изменившимся блокам
+    //
+    cursor.endEditBlock();
+
+    return selectionStartPos;
+}
+
+void ScenarioTextDocument::loadNextPart()
+{
+    if (!isLoading()
+        || m_isLoadingPartProcessed) {
+        return;
+    }
+
+    //
+    // Дописываем блоки очередной части в конец документа так же, как они были бы вставлены
+    // при загрузке сценария целиком, уведомляя об изменении текста единожды.
+    // Часть остаётся в списке незагруженных до завершения вставки, чтобы сценарий можно было
+    // собрать целиком, если сохранение будет вызвано во время обработки событий при вставке
+    //
+    m_isLoadingPartProcessed = true;
+    beginChangesBatch();
+    m_xmlHandler->appendXmlToScenario(m_notLoadedParts.first());
+    m_notLoadedParts.removeFirst();
+    endChangesBatch();
+    m_isLoadingPartProcessed = false;
+
+    if (isLoading()) {
+        emit loadingProgressChanged((m_loadingPartsCount - m_notLoadedParts.size()) * 100 / m_loadingPartsCount);
+        return;
+    }
+
+    //
+    // Сценарий загружен полностью
+    //
+    m_loadingTimer.stop();
+
+    //
+    // ... если во время загрузки текст изменялся, то изменения будут сформированы
+    //     сравнением полного xml, а если нет, то можно формировать патчи по изменённым фрагментам,
+    //     при условии, что загруженный xml совпадает со сформированным из документа
+    //
+    if (m_scenarioXmlHash != m_lastSavedScenarioXmlHash) {
+        m_scenarioXmlHash = m_xmlSnapshot.hash();
+    } else if (m_xmlSnapshot.hash() == m_scenarioXmlHash) {
+        m_xmlSnapshot.markSaved();
+    } else {
+        //
+        // ... части вставляются так же, как при загрузке целиком, поэтому если первая часть
+        //     сформировалась из документа без изменений, то и весь сценарий должен совпасть
+        //
+        Q_ASSERT_X(!m_isFirstLoadingPartActual, "ScenarioTextDocument::loadNextPart",
+                   "Script loaded by parts differs from the script loaded at once");
+    }
+
+    emit loadingProgressChanged(100);
+    emit loadingFinished();
+}
+
+void ScenarioTextDocument::rememberSnapshotAsSaved()
+{
+    m_scenarioXmlHash = m_xmlSnapshot.hash();
+
+    //
+    // Если известно, какой фрагмент xml изменился с момента последнего сохранения,
+    // то заменяем в сохранённом xml только его
+    //
+    ScenarioXmlSnapshot::Change xmlChange;
+    const int savedXmlChangeLength =
+            m_xmlSnapshot.changeSinceSaved(0, xmlChange)
+            ? m_lastSavedScenarioXml.size() - xmlChange.xmlPosition - xmlChange.xmlTailSize
+            : -1;
+    if (savedXmlChangeLength >= 0) {
+        m_lastSavedScenarioXml.replace(xmlChange.xmlPosition, savedXmlChangeLength, xmlChange.xml);
+    } else {
+        m_lastSavedScenarioXml = m_xmlSnapshot.xml();
+    }
+    m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
+    m_xmlSnapshot.markSaved();
+}
+
 void ScenarioTextDocument::updateBlocksIds(int _position, int _charsRemoved, int _charsAdded)
 {
     Q_UNUSED(_charsRemoved);
@@ -676,6 +1145,47 @@ void ScenarioTextDocument::updateBlocksIds(int _position, int _charsRemoved, int
     }
 }
 
+void ScenarioTextDocument::aboutContentsChange(int _position, int _charsRemoved, int _charsAdded)
+{
+    if (m_changesBatchLevel == 0) {
+        emit mergedContentsChange(_position, _charsRemoved, _charsAdded);
+        return;
+    }
+
+    //
+    // Первое изменение в пакете просто запоминаем
+    //
+    if (m_batchChange.position == -1) {
+        m_batchChange.position = _position;
+        m_batchChange.charsRemoved = _charsRemoved;
+        m_batchChange.charsAdded = _charsAdded;
+        return;
+    }
+
+    //
+    // Последующие объединяем с накопленным: диапазон объединённого изменения покрывает
+    // оба изменения, а его границы пересчитываются в координаты текста до пакета и после
+    // последнего изменения
+    //
+    const int position = qMin(m_batchChange.position, _position);
+    const int changedEnd = qMax(m_batchChange.position + m_batchChange.charsAdded, _position + _charsRemoved);
+    const int sourceEnd = changedEnd - m_batchChange.charsAdded + m_batchChange.charsRemoved;
+    const int targetEnd = changedEnd - _charsRemoved + _charsAdded;
+    m_batchChange.position = position;
+    m_batchChange.charsRemoved = sourceEnd - position;
+    m_batchChange.charsAdded = targetEnd - position;
+}
+
+void ScenarioTextDocument::aboutContentsChanged()
+{
+    if (m_changesBatchLevel == 0) {
+        emit mergedContentsChanged();
+        return;
+    }
+
+    m_batchChange.isChanged = true;
+}
+
 void ScenarioTextDocument::removeIdenticalParts(QPair<DiffMatchPatchHelper::ChangeXml, DiffMatchPatchHelper::ChangeXml>& _xmls, bool _reversed)
 {
     //
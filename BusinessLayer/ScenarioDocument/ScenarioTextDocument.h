@@ -2,10 +2,14 @@
 #define SCENARIOTEXTDOCUMENT_H
 
 #include "ScenarioTemplate.h"
+#include "ScenarioXmlSnapshot.h"
+
 #include <3rd_party/Helpers/DiffMatchPatchHelper.h>
 
+#include <QStringList>
 #include <QTextDocument>
 #include <QTextCursor>
+#include <QTimer>
 
 namespace Domain {
     class ScenarioChange;
@@ -32,20 +36,29 @@ namespace BusinessLogic
         /**
          * @brief Обновить ревизию блока
          * @note Это приходится делать вручную, т.к. изменения пользовательских свойств блока
-         *		 не отслеживаются автоматически
+         *		 не отслеживаются автоматически. Вместе с ревизией обновляется и айди блока,
+         *		 по которому определяется необходимость повторного формирования его xml
          */
         /** @{ */
         static void updateBlockRevision(QTextBlock& _block);
         static void updateBlockRevision(QTextCursor& _cursor);
         /** @} */
 
+        /**
+         * @brief Уведомить снимок xml документа блока об изменении данных блока, от которых
+         *		  зависит его xml, без изменения ревизии
+         */
+        static void markBlockDataChanged(const QTextBlock& _block);
+
     public:
         explicit ScenarioTextDocument(QObject *parent, ScenarioXml* _xmlHandler);
 
         /**
-         * @brief Сформировать xml из сценария и рассчитать его хэш
+         * @brief Обновить xml сценария после изменения текста и рассчитать его хэш
+         * @note Переформировывается xml только затронутых изменением блоков
+         * @return Изменился ли xml сценария
          */
-        bool updateScenarioXml();
+        bool updateScenarioXml(int _position, int _charsRemoved, int _charsAdded);
 
         /**
          * @brief Получить xml сценария
@@ -55,13 +68,25 @@ namespace BusinessLogic
         /**
          * @brief Получить текущий хэш сценария
          */
-        QByteArray scenarioXmlHash() const;
+        quint64 scenarioXmlHash() const;
 
         /**
          * @brief Загрузить сценарий
+         * @note Большой сценарий загружается по частям: первая часть сразу, а остальные
+         *       догружаются в конец документа при простое цикла событий
          */
         void load(const QString& _scenarioXml);
 
+        /**
+         * @brief Догружается ли сценарий
+         */
+        bool isLoading() const;
+
+        /**
+         * @brief Загрузить оставшиеся части сценария не дожидаясь простоя
+         */
+        void finishLoading();
+
         /**
          * @brief Получить майм представление данных в указанном диапазоне
          */
@@ -149,7 +174,39 @@ namespace BusinessLogic
          */
         void correct(int _position = -1, int _charsRemoved = 0, int _charsAdded = 0);
 
+        /**
+         * @brief Начать/завершить пакет изменений
+         *
+         * Изменения, сделанные внутри пакета, передаются обработчикам одним объединённым
+         * изменением при завершении внешнего пакета, так же как изменения внутри блока
+         * операций QTextDocument, но для нескольких последовательных блоков операций
+         */
+        /** @{ */
+        void beginChangesBatch();
+        void endChangesBatch();
+        /** @} */
+
     signals:
+        /**
+         * @brief Объединённое изменение текста документа
+         * @note Вне пакета изменений повторяют сигналы contentsChange и contentsChanged,
+         *       а внутри пакета испускаются один раз при его завершении
+         */
+        /** @{ */
+        void mergedContentsChange(int _position, int _charsRemoved, int _charsAdded);
+        void mergedContentsChanged();
+        /** @} */
+
+        /**
+         * @brief Изменился прогресс загрузки сценария, в процентах
+         */
+        void loadingProgressChanged(int _progress);
+
+        /**
+         * @brief Сценарий загружен полностью
+         */
+        void loadingFinished();
+
         /**
          * @brief Сигналы уведомляющие об этапах применения патчей
          */
@@ -174,11 +231,52 @@ namespace BusinessLogic
         void redoAvailableChanged(bool _isRedoAvailable);
 
     private:
+        /**
+         * @brief Загрузить очередную часть сценария в конец документа
+         */
+        void loadNextPart();
+
+        /**
+         * @brief Применить патч только к затрагиваемым им группам блоков
+         * @return Позиция начала изменённого текста, или -1, если патч не удалось применить
+         *         к фрагменту документа
+         */
+        int applyPatchToFragment(const QString& _patch, bool _checkXml);
+
+        /**
+         * @brief Заменить группы блоков, xml которых отличается в новом xml сценария
+         * @return Удалось ли заменить изменившиеся группы блоков
+         * @note Возможно только если текущий xml совпадает с xml снимка документа
+         */
+        bool applyXmlToFragment(const QString& _currentXml, const QString& _newXml);
+
+        /**
+         * @brief Заменить группы блоков фрагмента с заданной по заданную на блоки из xml
+         * @return Позиция начала заменённого текста, или -1, если xml не прошёл проверку
+         */
+        int replaceFragment(const ScenarioXmlSnapshot::Fragment& _fragment, int _firstPart, int _lastPart, const QString& _xml, bool _checkXml);
+
+        /**
+         * @brief Запомнить текущее состояние снимка xml как последнее сохранённое
+         */
+        void rememberSnapshotAsSaved();
+
         /**
          * @brief Обновить идентификаторы изменившихся блоков
          */
         void updateBlocksIds(int _position, int _charsRemoved, int _charsAdded);
 
+        /**
+         * @brief Передать изменение текста обработчикам, или накопить его, если открыт пакет
+         */
+        void aboutContentsChange(int _position, int _charsRemoved, int _charsAdded);
+
+        /**
+         * @brief Уведомить обработчиков о завершении изменения, или отложить уведомление,
+         *        если открыт пакет
+         */
+        void aboutContentsChanged();
+
         /**
          * @brief Процедура удаления одинаковый первых и последних частей в xml-строках у _xmls
          * _reversed = false - удаляем первые, = true - удаляем последние
@@ -212,23 +310,23 @@ namespace BusinessLogic
         bool m_isPatchApplyProcessed;
 
         /**
-         * @brief  Xml текст сценария и его MD5-хэш
-         * @note Xml сценария не должен быть null т.к. он участвует в формировании патчей,
-         *       а diffMatchPatch этого не допускает, поэтому инициилизируем его пустой строкой
+         * @brief Снимок xml текста сценария, собранный из xml блоков
          */
-        /** @{ */
-        QString m_scenarioXml = "";
-        QByteArray m_scenarioXmlHash;
-        /** @} */
+        ScenarioXmlSnapshot m_xmlSnapshot;
+
+        /**
+         * @brief Хэш текущего xml текста сценария
+         */
+        quint64 m_scenarioXmlHash = 0;
 
         /**
-         * @brief Xml текст сценария и его MD5-хэш на момент последнего сохранения изменений
+         * @brief Xml текст сценария и его хэш на момент последнего сохранения изменений
          * @note Xml сценария не должен быть null т.к. он участвует в формировании патчей,
          *       а diffMatchPatch этого не допускает, поэтому инициилизируем его пустой строкой
          */
         /** @{ */
         QString m_lastSavedScenarioXml = "";
-        QByteArray m_lastSavedScenarioXmlHash;
+        quint64 m_lastSavedScenarioXmlHash = 0;
         /** @} */
 
         /**
@@ -258,6 +356,61 @@ namespace BusinessLogic
          * @brief Корректировщик текста документа
          */
         ScriptTextCorrector* m_corrector;
+
+        /**
+         * @brief Уровень вложенности пакетов изменений
+         */
+        int m_changesBatchLevel = 0;
+
+        /**
+         * @brief Накопленное в пакете изменение
+         */
+        struct BatchChange {
+            /**
+             * @brief Позиция начала изменения, или -1, если изменений не было
+             */
+            int position = -1;
+
+            /**
+             * @brief Количество удалённых символов исходного текста
+             */
+            int charsRemoved = 0;
+
+            /**
+             * @brief Количество добавленных символов
+             */
+            int charsAdded = 0;
+
+            /**
+             * @brief Был ли завершён хотя бы один блок операций
+             */
+            bool isChanged = false;
+        } m_batchChange;
+
+        /**
+         * @brief Части сценария, которые ещё не загружены в документ
+         */
+        QStringList m_notLoadedParts;
+
+        /**
+         * @brief Общее количество частей загружаемого сценария
+         */
+        int m_loadingPartsCount = 0;
+
+        /**
+         * @brief Происходит ли загрузка очередной части сценария
+         */
+        bool m_isLoadingPartProcessed = false;
+
+        /**
+         * @brief Совпал ли xml, сформированный из первой загруженной части, с её исходным xml
+         */
+        bool m_isFirstLoadingPartActual = false;
+
+        /**
+         * @brief Таймер загрузки частей сценария при простое
+         */
+        QTimer m_loadingTimer;
     };
 }
 
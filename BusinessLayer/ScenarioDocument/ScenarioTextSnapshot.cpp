@@ -0,0 +1,342 @@
+#include "ScenarioTextSnapshot.h"
+
+#include <BusinessLayer/Chronometry/AbstractChronometer.h>
+#include <BusinessLayer/Chronometry/ChronometerFacade.h>
+#include <BusinessLayer/Counters/CountersFacade.h>
+
+#include <3rd_party/Helpers/TextEditHelper.h>
+
+#include <QTextBlock>
+#include <QTextDocument>
+
+using BusinessLogic::ChronometerBlock;
+using BusinessLogic::ChronometerFacade;
+using BusinessLogic::Counter;
+using BusinessLogic::CountersFacade;
+using BusinessLogic::ScenarioBlockStyle;
+using BusinessLogic::ScenarioTextSnapshot;
+
+namespace {
+    /**
+     * @brief Часть элемента, к которой относится блок
+     */
+    enum class ItemPart {
+        None,
+        Text,
+        Description,
+        Footer
+    };
+}
+
+
+void ScenarioTextSnapshot::rebuild(QTextDocument* _document)
+{
+    m_blocks.clear();
+    m_blocks.reserve(_document->blockCount());
+    for (QTextBlock block = _document->begin(); block.isValid(); block = block.next()) {
+        m_blocks.append(blockData(block));
+    }
+}
+
+void ScenarioTextSnapshot::update(QTextDocument* _document, int _position, int _charsRemoved, int _charsAdded)
+{
+    Q_UNUSED(_charsRemoved);
+
+    //
+    // Если документ сформирован целиком, то и снимок формируем заново
+    //
+    if (m_blocks.isEmpty()
+        || _charsAdded >= _document->characterCount()) {
+        rebuild(_document);
+        return;
+    }
+
+    //
+    // Определим изменившиеся блоки, количество удалённых блоков определяется по тому,
+    // насколько изменилось количество блоков документа
+    //
+    const QTextBlock firstBlock = _document->findBlock(_position);
+    if (!firstBlock.isValid()) {
+        rebuild(_document);
+        return;
+    }
+    QTextBlock lastBlock = _document->findBlock(_position + _charsAdded);
+    if (!lastBlock.isValid()) {
+        lastBlock = _document->lastBlock();
+    }
+    const int firstIndex = firstBlock.blockNumber();
+    const int lastIndex = lastBlock.blockNumber();
+    const int removedLastIndex = lastIndex - (_document->blockCount() - m_blocks.size());
+    if (removedLastIndex < firstIndex - 1
+        || removedLastIndex >= m_blocks.size()) {
+        rebuild(_document);
+        return;
+    }
+
+    //
+    // Если количество блоков изменилось, то раздвигаем или сдвигаем данные последующих блоков
+    //
+    const int removedCount = removedLastIndex - firstIndex + 1;
+    const int addedCount = lastIndex - firstIndex + 1;
+    if (removedCount != addedCount) {
+        QVector<Block> blocks;
+        blocks.reserve(m_blocks.size() - removedCount + addedCount);
+        for (int index = 0; index < firstIndex; ++index) {
+            blocks.append(m_blocks.at(index));
+        }
+        blocks.resize(firstIndex + addedCount);
+        for (int index = removedLastIndex + 1; index < m_blocks.size(); ++index) {
+            blocks.append(m_blocks.at(index));
+        }
+        m_blocks.swap(blocks);
+    }
+
+    //
+    // Обновляем данные изменившихся блоков
+    //
+    QTextBlock block = firstBlock;
+    for (int index = firstIndex; index <= lastIndex; ++index) {
+        m_blocks[index] = blockData(block);
+        block = block.next();
+    }
+}
+
+template<typename Handler>
+void ScenarioTextSnapshot::walkItem(const QVector<Block>& _blocks, const ItemRange& _range, bool _isDocumentEnd,
+    Handler _handler)
+{
+    const int lastIndex = qMin(_range.lastBlock, _blocks.size() - 1);
+    bool isNeedIncludeBlock = true; // нужно ли включать текущий блок
+    int openedFolders = 0; // кол-во открытых папок
+    for (int index = _range.firstBlock; index <= lastIndex; ++index) {
+        const Block& block = _blocks.at(index);
+        const bool isHeaderBlock = index == _range.firstBlock;
+        const bool isInsideItem = index < _range.lastBlock || _range.isLastBlockInside;
+
+        //
+        // В текст, описание и подвал не входит заголовок элемента и пустой завершающий
+        // документ блок
+        //
+        ItemPart part = ItemPart::None;
+        if (!isHeaderBlock
+            && !(_isDocumentEnd && index == _blocks.size() - 1 && block.text.isEmpty())) {
+            switch (block.type) {
+                //
+                // Заголовки никуда не включаем
+                //
+                case ScenarioBlockStyle::SceneHeading: {
+                    isNeedIncludeBlock = false;
+                    break;
+                }
+
+                //
+                // Не включаем тект папок, а окончание самой папки сохраняем в подвал
+                //
+                case ScenarioBlockStyle::FolderHeader: {
+                    ++openedFolders;
+                    isNeedIncludeBlock = false;
+                    break;
+                }
+
+                case ScenarioBlockStyle::FolderFooter: {
+                    if (openedFolders == 0) {
+                        part = ItemPart::Footer;
+                    } else if (openedFolders == 1) {
+                        isNeedIncludeBlock = true;
+                    }
+                    --openedFolders;
+                    break;
+                }
+
+                //
+                // Описание сохраняем в описание
+                //
+                case ScenarioBlockStyle::SceneDescription: {
+                    if (isNeedIncludeBlock) {
+                        part = ItemPart::Description;
+                    }
+                    break;
+                }
+
+                //
+                // Весь остальной текст - текст элемента
+                //
+                default: {
+                    if (isNeedIncludeBlock) {
+                        part = ItemPart::Text;
+                    }
+                    break;
+                }
+            }
+        }
+
+        _handler(block, isHeaderBlock || isInsideItem, isInsideItem, part);
+    }
+}
+
+ScenarioTextSnapshot::ItemParts ScenarioTextSnapshot::itemParts(const ItemRange& _range) const
+{
+    ItemParts parts;
+    bool isFirstDescriptionBlock = true;
+    walkItem(m_blocks, _range, true, [&parts, &isFirstDescriptionBlock] (const Block& _block, bool, bool, ItemPart _part) {
+        switch (_part) {
+            case ItemPart::Description: {
+                if (!isFirstDescriptionBlock) {
+                    parts.description.append("\n");
+                } else {
+                    parts.description = "";
+                    isFirstDescriptionBlock = false;
+                }
+                parts.description.append(_block.text);
+                break;
+            }
+
+            case ItemPart::Footer: {
+                parts.footer = _block.text;
+                break;
+            }
+
+            case ItemPart::Text: {
+                //
+                // Блоки текста разделяются переносом строки
+                //
+                parts.textLength =
+                        parts.textLength < 0
+                        ? _block.text.length()
+                        : parts.textLength + 1 + _block.text.length();
+                break;
+            }
+
+            default: break;
+        }
+    });
+
+    return parts;
+}
+
+ScenarioTextSnapshot::ItemBlocks ScenarioTextSnapshot::itemBlocks(const ItemRange& _range) const
+{
+    ItemBlocks item;
+    const int lastIndex = qMin(_range.lastBlock, m_blocks.size() - 1);
+    if (_range.firstBlock < 0
+        || _range.firstBlock > lastIndex) {
+        return item;
+    }
+
+    item.blocks = m_blocks.mid(_range.firstBlock, lastIndex - _range.firstBlock + 1);
+    //
+    // Если диапазон выходит за пределы снимка, то последний блок снимка входит в элемент целиком
+    //
+    item.isLastBlockInside = _range.isLastBlockInside || _range.lastBlock > lastIndex;
+    item.isDocumentEnd = lastIndex == m_blocks.size() - 1;
+    return item;
+}
+
+ScenarioTextSnapshot::ItemContent ScenarioTextSnapshot::itemContent(const ItemBlocks& _item,
+    const QVector<bool>& _uppercaseTypes, const Calculation& _calculation, bool _calculateDuration)
+{
+    ItemRange range;
+    range.firstBlock = 0;
+    range.lastBlock = _item.blocks.size() - 1;
+    range.isLastBlockInside = _item.isLastBlockInside;
+
+    const bool calculateDuration = _calculateDuration && !_calculation.chronometer.isNull();
+    const bool calculateCounters = _calculation.calculateWords || _calculation.calculateCharacters;
+
+    ItemContent content;
+    bool isFirstTextBlock = true;
+    walkItem(_item.blocks, range, _item.isDocumentEnd,
+             [&] (const Block& _block, bool _isCounted, bool _isInsideItem, ItemPart _part) {
+        //
+        // ... длительность, граничащий с элементом блок не учитываем
+        //
+        if (calculateDuration
+            && _isCounted) {
+            ChronometerBlock chronometerBlock;
+            chronometerBlock.type = _block.type;
+            chronometerBlock.text = _block.text;
+            chronometerBlock.height = _block.height;
+            chronometerBlock.pageHeight = _block.pageHeight;
+            content.duration += _calculation.chronometer->calculate(chronometerBlock);
+        }
+
+        //
+        // ... примечания
+        //
+        if (_isInsideItem
+            && _block.type == ScenarioBlockStyle::NoprintableText) {
+            content.hasNote = true;
+        }
+
+        //
+        // ... счётчики, только используемые, как и при расчёте по диапазону документа
+        //
+        if (calculateCounters
+            && _isCounted
+            && _block.isCountable) {
+            const Counter blockCounter = CountersFacade::calculateText(QStringRef(&_block.text));
+            if (_calculation.calculateWords) {
+                content.counter.addWords(blockCounter.words());
+            }
+            if (_calculation.calculateCharacters) {
+                content.counter.addCharactersWithSpaces(blockCounter.charactersWithSpaces());
+                content.counter.addCharactersWithoutSpaces(blockCounter.charactersWithoutSpaces());
+            }
+        }
+
+        //
+        // ... текст
+        //
+        if (_part == ItemPart::Text) {
+            if (!isFirstTextBlock) {
+                content.text.append("\n");
+            } else {
+                content.text = "";
+                isFirstTextBlock = false;
+            }
+            content.text +=
+                    _uppercaseTypes.value(_block.type)
+                    ? TextEditHelper::smartToUpper(_block.text)
+                    : _block.text;
+        }
+    });
+
+    return content;
+}
+
+ScenarioTextSnapshot::Calculation ScenarioTextSnapshot::Calculation::current()
+{
+    Calculation calculation;
+    calculation.calculateWords = CountersFacade::wordsUsed();
+    calculation.calculateCharacters = CountersFacade::charactersUsed();
+    if (ChronometerFacade::chronometryUsed()) {
+        calculation.chronometer = ChronometerFacade::chronometer();
+    }
+    calculation.chronometerRevision = ChronometerFacade::chronometerRevision();
+    return calculation;
+}
+
+bool ScenarioTextSnapshot::Calculation::operator==(const Calculation& _other) const
+{
+    //
+    // Хронометр пересоздаётся при любом изменении настроек, поэтому сравниваем
+    // не сами хронометры, а ревизию параметров хронометража
+    //
+    return calculateWords == _other.calculateWords
+            && calculateCharacters == _other.calculateCharacters
+            && chronometer.isNull() == _other.chronometer.isNull()
+            && chronometerRevision == _other.chronometerRevision;
+}
+
+ScenarioTextSnapshot::Block ScenarioTextSnapshot::blockData(const QTextBlock& _block)
+{
+    const ChronometerBlock chronometerBlock = ChronometerFacade::chronometerBlock(_block);
+
+    Block block;
+    block.type = chronometerBlock.type;
+    block.text = chronometerBlock.text;
+    block.isCountable = CountersFacade::isCountable(_block);
+    block.height = chronometerBlock.height;
+    block.pageHeight = chronometerBlock.pageHeight;
+    return block;
+}
@@ -0,0 +1,235 @@
+#ifndef SCENARIOTEXTSNAPSHOT_H
+#define SCENARIOTEXTSNAPSHOT_H
+
+#include "ScenarioTemplate.h"
+
+#include <BusinessLayer/Counters/Counter.h>
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+class QTextBlock;
+class QTextDocument;
+
+
+namespace BusinessLogic
+{
+    class AbstractChronometer;
+
+    /**
+     * @brief Снимок текста сценария, не зависящий от текстового документа
+     *
+     * Для каждого блока документа хранит его тип, текст и данные, от которых зависят счётчики
+     * и хронометраж. Сами счётчики и хронометраж рассчитываются при формировании содержимого
+     * элемента по копии его блоков, поэтому это можно делать в другом потоке, не затрагивая
+     * снимок, который продолжает изменяться вместе с документом
+     */
+    class ScenarioTextSnapshot
+    {
+    public:
+        /**
+         * @brief Данные блока текста
+         */
+        struct Block {
+            /**
+             * @brief Тип блока
+             */
+            ScenarioBlockStyle::Type type = ScenarioBlockStyle::Undefined;
+
+            /**
+             * @brief Текст блока
+             */
+            QString text;
+
+            /**
+             * @brief Учитывается ли блок в счётчиках
+             */
+            bool isCountable = false;
+
+            /**
+             * @brief Высота блока на странице
+             */
+            qreal height = 0;
+
+            /**
+             * @brief Высота области текста на странице, или 0, если документ не разбит на страницы
+             */
+            qreal pageHeight = 0;
+        };
+
+        /**
+         * @brief Диапазон блоков элемента дерева сценария
+         */
+        struct ItemRange {
+            /**
+             * @brief Порядковый номер блока заголовка элемента
+             */
+            int firstBlock = 0;
+
+            /**
+             * @brief Порядковый номер последнего блока, входящего в диапазон
+             */
+            int lastBlock = 0;
+
+            /**
+             * @brief Входит ли последний блок в сам элемент, или лишь граничит с ним
+             * @note Элемент заканчивается либо в конце своего последнего блока, либо в начале
+             *       граничного, поэтому блок входит в элемент целиком или не входит вовсе
+             */
+            bool isLastBlockInside = false;
+        };
+
+        /**
+         * @brief Копия блоков элемента, по которой формируется его содержимое
+         */
+        struct ItemBlocks {
+            /**
+             * @brief Блоки диапазона элемента, начиная с заголовка
+             */
+            QVector<Block> blocks;
+
+            /**
+             * @brief Входит ли последний блок в сам элемент, или лишь граничит с ним
+             */
+            bool isLastBlockInside = false;
+
+            /**
+             * @brief Является ли последний блок последним блоком документа
+             */
+            bool isDocumentEnd = false;
+        };
+
+        /**
+         * @brief Составные части элемента, определяющие его длину в тексте
+         */
+        struct ItemParts {
+            /**
+             * @brief Описание
+             */
+            QString description;
+
+            /**
+             * @brief Подвал
+             */
+            QString footer;
+
+            /**
+             * @brief Длина текста, или -1, если текста у элемента нет
+             */
+            int textLength = -1;
+        };
+
+        /**
+         * @brief Содержимое элемента
+         */
+        struct ItemContent {
+            /**
+             * @brief Текст
+             */
+            QString text;
+
+            /**
+             * @brief Содержит ли примечания
+             */
+            bool hasNote = false;
+
+            /**
+             * @brief Счётчики
+             */
+            Counter counter;
+
+            /**
+             * @brief Хронометраж
+             */
+            qreal duration = 0;
+        };
+
+        /**
+         * @brief Параметры расчёта счётчиков и хронометража
+         */
+        struct Calculation {
+            /**
+             * @brief Считать ли слова
+             */
+            bool calculateWords = false;
+
+            /**
+             * @brief Считать ли символы
+             */
+            bool calculateCharacters = false;
+
+            /**
+             * @brief Хронометр, или нулевой указатель, если хронометраж не используется
+             */
+            QSharedPointer<const AbstractChronometer> chronometer;
+
+            /**
+             * @brief Ревизия параметров хронометража
+             */
+            int chronometerRevision = 0;
+
+            /**
+             * @brief Получить текущие параметры расчёта
+             * @note Обращается к настройкам, поэтому вызывается только из потока документа
+             */
+            static Calculation current();
+
+            bool operator==(const Calculation& _other) const;
+            bool operator!=(const Calculation& _other) const { return !(*this == _other); }
+        };
+
+    public:
+        /**
+         * @brief Сформировать снимок по всему документу
+         */
+        void rebuild(QTextDocument* _document);
+
+        /**
+         * @brief Обновить снимок после изменения текста документа
+         * @note Параметры соответствуют сигналу QTextDocument::contentsChange
+         */
+        void update(QTextDocument* _document, int _position, int _charsRemoved, int _charsAdded);
+
+        /**
+         * @brief Определить описание, подвал и длину текста элемента
+         */
+        ItemParts itemParts(const ItemRange& _range) const;
+
+        /**
+         * @brief Получить копию блоков элемента
+         */
+        ItemBlocks itemBlocks(const ItemRange& _range) const;
+
+        /**
+         * @brief Сформировать содержимое элемента по копии его блоков
+         * @param _uppercaseTypes - для каждого типа блока, пишется ли он в верхнем регистре
+         * @param _calculateDuration - нужно ли рассчитывать хронометраж элемента
+         * @note Не обращается ни к документу, ни к настройкам, поэтому может выполняться в другом потоке
+         */
+        static ItemContent itemContent(const ItemBlocks& _item, const QVector<bool>& _uppercaseTypes,
+            const Calculation& _calculation, bool _calculateDuration);
+
+    private:
+        /**
+         * @brief Получить данные блока документа
+         */
+        static Block blockData(const QTextBlock& _block);
+
+        /**
+         * @brief Пройти блоки элемента, определяя к какой части элемента относится каждый
+         * @param _isDocumentEnd - является ли последний из блоков последним блоком документа
+         */
+        template<typename Handler>
+        static void walkItem(const QVector<Block>& _blocks, const ItemRange& _range, bool _isDocumentEnd,
+            Handler _handler);
+
+    private:
+        /**
+         * @brief Данные блоков
+         */
+        QVector<Block> m_blocks;
+    };
+}
+
+#endif // SCENARIOTEXTSNAPSHOT_H
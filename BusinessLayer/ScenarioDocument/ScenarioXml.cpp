@@ -19,20 +19,11 @@
 #include <QTextTable>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
+#include <QtConcurrent>
 
 using namespace BusinessLogic;
 
 namespace {
-    /**
-     * @brief Шаг увеличения размера кэша при его заполнении
-     */
-    const int kCostIncreaseStep = 100;
-
-    /**
-     * @brief Начальное значение размера кэша
-     */
-    const int kInitialCost  = 3000;
-
     const QString kNodeScript = "scenario";
     const QString kNodeValue = "v";
     const QString kNodeReviewGroup = "reviews";
@@ -75,104 +66,42 @@ namespace {
     const QString SCENARIO_XML_VERSION = "1.0";
 
     /**
-     * @brief Сформировать хэш для текстового блока
+     * @brief Обрамление xml сценария
      */
-    static inline quint64 blockHash(const QTextBlock& _block)
-    {
-        //
-        // TODO: Нужно оптимизировать формирование хэша, т.к. от него напрямую зависит
-        //       скорость формирования xml-документа сценария
-        //
-        TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(_block.userData());
-        if (blockInfo != nullptr) {
-            return blockInfo->id();
-        }
+    /** @{ */
+    const QString kXmlHeader = "<?xml version=\"1.0\"?>\n";
+    const QString kScenarioHeader = "<scenario version=\"1.0\">\n";
+    const QString kScenarioFooter = "</scenario>\n";
+    /** @} */
 
-        //
-        // Формируем уникальную строку, главное, чтобы два разных блока не имели одинакового хэша,
-        // но в то же время, нельзя опираться на позицию блока, т.к. при смещение текста на абзац
-        // вниз, придётся пересчитывать хэши всех остальных блоков
-        //
-        QString hash =
-                _block.text()
-                % "#"
-                % QString::number(_block.revision())
-                % "#"
-                % QString::number(ScenarioBlockStyle::forBlock(_block));
-
-        if (TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(_block.userData())) {
-            if (SceneHeadingBlockInfo* shBlockInfo = dynamic_cast<SceneHeadingBlockInfo*>(blockInfo)) {
-                hash = hash
-                       % "#"
-                       % shBlockInfo->uuid()
-                       % "#"
-                       % shBlockInfo->sceneNumber()
-                       % "#"
-                       % QString::number(shBlockInfo->isSceneNumberFixed())
-                       % "#"
-                       % QString::number(shBlockInfo->sceneNumberFixNesting())
-                       % "#"
-                       % shBlockInfo->colors()
-                       % "#"
-                       % shBlockInfo->stamp()
-                       % "#"
-                       % shBlockInfo->name()
-                       % "#"
-                       % shBlockInfo->description()
-                       % "#"
-                       % (shBlockInfo->hasBookmark() ? "1" : "0")
-                       % "#"
-                       % shBlockInfo->bookmark();
-            } else {
-                hash = hash
-                       % "#"
-                       % (blockInfo->hasBookmark() ? "1" : "0")
-                       % "#"
-                       % blockInfo->bookmark();
-            }
-        }
+    /**
+     * @brief Признак хэша блока, сформированного по его содержимому, а не по айди
+     */
+    const quint64 kStringHashFlag = quint64(1) << 63;
 
-        for (const QTextLayout::FormatRange& range : _block.textFormats()) {
-            if (range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark)) {
-                hash = hash
-                        % "#"
-                        % QString::number(range.start)
-                        % "#"
-                        % QString::number(range.length)
-                        % "#"
-                        % range.format.foreground().color().name()
-                        % "#"
-                        % range.format.background().color().name()
-                        % "#"
-                        % (range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark) ? "1" : "0")
-                        % "#"
-                        % (range.format.boolProperty(ScenarioBlockStyle::PropertyIsHighlight) ? "1" : "0")
-                        % "#"
-                        % (range.format.boolProperty(ScenarioBlockStyle::PropertyIsDone) ? "1" : "0")
-                        % "#"
-                        % range.format.property(ScenarioBlockStyle::PropertyComments).toStringList().join("#")
-                        % "#"
-                        % range.format.property(ScenarioBlockStyle::PropertyCommentsAuthors).toStringList().join("#")
-                        % "#"
-                        % range.format.property(ScenarioBlockStyle::PropertyCommentsDates).toStringList().join("#");
-            }
-            if (range.format.boolProperty(ScenarioBlockStyle::PropertyIsFormatting)) {
-                hash = hash
-                        % "#"
-                        % QString::number(range.start)
-                        % "#"
-                        % QString::number(range.length)
-                        % "#"
-                        % (range.format.font().bold() ? "1" : "0")
-                        % "#"
-                        % (range.format.font().italic() ? "1" : "0")
-                        % "#"
-                        % (range.format.font().underline() ? "1" : "0");
-            }
-        }
+    /**
+     * @brief Через сколько вставленных из xml блоков даём возможность выполниться графическим операциям
+     */
+    const int kProcessEventsBlocksInterval = 500;
 
-        return qHash(hash);
-    }
+    /**
+     * @brief Редакторская заметка или форматирование блока, считанные из xml
+     */
+    struct XmlFormat {
+        int start;
+        int length;
+        QTextCharFormat format;
+    };
+
+    /**
+     * @brief Блок, считанный из xml
+     */
+    struct XmlBlock {
+        ScenarioBlockStyle::Type type = ScenarioBlockStyle::Undefined;
+        QXmlStreamAttributes attributes;
+        QString text;
+        QVector<XmlFormat> formats;
+    };
 
     /**
      * @brief Одинаковы ли форматы редакторских заметок
@@ -247,490 +176,651 @@ QString ScenarioXml::defaultTextXml()
 
 QString ScenarioXml::makeMimeFromXml(const QString& _xml)
 {
-    const QString XML_HEADER = "<?xml version=\"1.0\"?>\n";
-    const QString SCENARIO_HEADER = "<scenario version=\"1.0\">\n";
-    const QString SCENARIO_FOOTER = "</scenario>\n";
-
     QString mimeXml = _xml;
-    if (!mimeXml.contains(XML_HEADER)) {
-        if (!mimeXml.contains(SCENARIO_HEADER)) {
-            mimeXml.prepend(SCENARIO_HEADER);
+    if (!mimeXml.contains(kXmlHeader)) {
+        if (!mimeXml.contains(kScenarioHeader)) {
+            mimeXml.prepend(kScenarioHeader);
         }
-        mimeXml.prepend(XML_HEADER);
+        mimeXml.prepend(kXmlHeader);
     }
-    if (!mimeXml.endsWith(SCENARIO_FOOTER)) {
-        mimeXml.append(SCENARIO_FOOTER);
+    if (!mimeXml.endsWith(kScenarioFooter)) {
+        mimeXml.append(kScenarioFooter);
     }
     return mimeXml;
 }
 
+QString ScenarioXml::mimeHeader()
+{
+    return kXmlHeader + kScenarioHeader;
+}
+
+QString ScenarioXml::mimeFooter()
+{
+    return kScenarioFooter;
+}
+
+QStringList ScenarioXml::splitXml(const QString& _xml, int _firstPartBlocks, int _partBlocks)
+{
+    //
+    // Делим только xml текущей версии, т.к. каждая часть обрамляется его заголовком
+    //
+    QXmlStreamReader reader(_xml);
+    if (!reader.readNextStartElement()
+        || reader.name() != kNodeScript
+        || reader.attributes().value(ATTRIBUTE_VERSION) != SCENARIO_XML_VERSION) {
+        return { _xml };
+    }
+
+    QStringList parts;
+    int partStart = reader.characterOffset();
+    int partBlocks = 0;
+    int partMinBlocks = _firstPartBlocks;
+    int depth = 0;
+    bool isInTable = false;
+    while (!reader.atEnd()) {
+        const int tokenStart = reader.characterOffset();
+        switch (reader.readNext()) {
+            case QXmlStreamReader::StartElement: {
+                //
+                // Считаем блоки верхнего уровня и отслеживаем границы таблиц
+                //
+                if (depth == 0) {
+                    const QString tokenName = reader.name().toString();
+                    if (tokenName == kNodeSplitterStart) {
+                        isInTable = true;
+                    } else if (tokenName == kNodeSplitterEnd) {
+                        isInTable = false;
+                    } else if (ScenarioBlockStyle::typeForName(tokenName) != ScenarioBlockStyle::Undefined) {
+                        ++partBlocks;
+                    }
+                }
+                ++depth;
+                break;
+            }
+
+            case QXmlStreamReader::EndElement: {
+                --depth;
+
+                //
+                // Закрытие корневого элемента завершает последнюю часть
+                //
+                if (depth < 0) {
+                    if (partBlocks > 0) {
+                        parts.append(mimeHeader() + _xml.mid(partStart, tokenStart - partStart) + mimeFooter());
+                    }
+                    partStart = -1;
+                }
+                //
+                // Завершаем часть после очередного блока верхнего уровня, если в неё вошло
+                // достаточно блоков и блок не находится внутри таблицы
+                //
+                else if (depth == 0
+                         && partBlocks >= partMinBlocks
+                         && !isInTable) {
+                    const int partEnd = reader.characterOffset();
+                    parts.append(mimeHeader() + _xml.mid(partStart, partEnd - partStart) + mimeFooter());
+                    partStart = partEnd;
+                    partBlocks = 0;
+                    partMinBlocks = _partBlocks;
+                }
+                break;
+            }
+
+            default: {
+                break;
+            }
+        }
+    }
+
+    //
+    // Если xml некорректен, или его не нужно делить, то оставляем его как есть
+    //
+    if (reader.hasError()
+        || partStart != -1
+        || parts.size() < 2) {
+        return { _xml };
+    }
+
+    return parts;
+}
+
 ScenarioXml::ScenarioXml(ScenarioDocument* _scenario) :
     m_scenario(_scenario),
     m_lastMimeFrom(0),
     m_lastMimeTo(0)
 {
     Q_ASSERT(m_scenario);
-
-    m_xmlCache.setMaxCost(kInitialCost);
 }
 
 QString ScenarioXml::scenarioToXml()
 {
     //
-    // Проверим, чтобы ёмкость кэша была достаточной
+    // Данные блоков собираем последовательно, т.к. документ не допускает одновременного
+    // обращения из нескольких потоков
     //
-    {
-        const int maxCost = m_xmlCache.maxCost();
-        const int currentCost = m_scenario->document()->blockCount();
-        if (currentCost > kInitialCost
-            && (maxCost < currentCost
-                || maxCost > currentCost * 2)) {
-            m_xmlCache.setMaxCost(std::max(kInitialCost, currentCost + kCostIncreaseStep));
-        }
+    QVector<BlockData> blocksData;
+    blocksData.reserve(m_scenario->document()->blockCount());
+    TableState tableState;
+    for (QTextBlock currentBlock = m_scenario->document()->begin();
+         currentBlock.isValid();
+         currentBlock = currentBlock.next()) {
+        blocksData.append(blockData(currentBlock, tableState));
+    }
+
+    //
+    // ... а xml блоков формируем параллельно и склеиваем в исходном порядке
+    //
+    const QVector<QString> blocksXml =
+            QtConcurrent::blockingMapped<QVector<QString>>(blocksData, &ScenarioXml::blockDataToXml);
+    int resultSize = 0;
+    for (const QString& blockXml : blocksXml) {
+        resultSize += blockXml.size();
+    }
+    QString resultXml;
+    resultXml.reserve(resultSize);
+    for (const QString& blockXml : blocksXml) {
+        resultXml.append(blockXml);
+    }
+
+    return makeMimeFromXml(resultXml);
+}
+
+quint64 ScenarioXml::blockHash(const QTextBlock& _block)
+{
+    //
+    // Айди блока обновляется при любом изменении блока и его пользовательских данных,
+    // поэтому для блоков с пользовательскими данными его и используем
+    //
+    TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(_block.userData());
+    if (blockInfo != nullptr) {
+        return blockInfo->id();
     }
 
+    //
+    // Формируем уникальную строку, главное, чтобы два разных блока не имели одинакового хэша,
+    // но в то же время, нельзя опираться на позицию блока, т.к. при смещение текста на абзац
+    // вниз, придётся пересчитывать хэши всех остальных блоков
+    //
+    QString hash =
+            _block.text()
+            % "#"
+            % QString::number(_block.revision())
+            % "#"
+            % QString::number(ScenarioBlockStyle::forBlock(_block));
+
+    for (const QTextLayout::FormatRange& range : _block.textFormats()) {
+        if (range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark)) {
+            hash = hash
+                    % "#"
+                    % QString::number(range.start)
+                    % "#"
+                    % QString::number(range.length)
+                    % "#"
+                    % range.format.foreground().color().name()
+                    % "#"
+                    % range.format.background().color().name()
+                    % "#"
+                    % (range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark) ? "1" : "0")
+                    % "#"
+                    % (range.format.boolProperty(ScenarioBlockStyle::PropertyIsHighlight) ? "1" : "0")
+                    % "#"
+                    % (range.format.boolProperty(ScenarioBlockStyle::PropertyIsDone) ? "1" : "0")
+                    % "#"
+                    % range.format.property(ScenarioBlockStyle::PropertyComments).toStringList().join("#")
+                    % "#"
+                    % range.format.property(ScenarioBlockStyle::PropertyCommentsAuthors).toStringList().join("#")
+                    % "#"
+                    % range.format.property(ScenarioBlockStyle::PropertyCommentsDates).toStringList().join("#");
+        }
+        if (range.format.boolProperty(ScenarioBlockStyle::PropertyIsFormatting)) {
+            hash = hash
+                    % "#"
+                    % QString::number(range.start)
+                    % "#"
+                    % QString::number(range.length)
+                    % "#"
+                    % (range.format.font().bold() ? "1" : "0")
+                    % "#"
+                    % (range.format.font().italic() ? "1" : "0")
+                    % "#"
+                    % (range.format.font().underline() ? "1" : "0");
+        }
+    }
 
     //
-    // Для формирования xml не используем QXmlStreamWriter, т.к. нам нужно хранить по отдельности
-    // xml каждого блока, а QXmlStreamWriter не всегда закрывает последний записанный тэг,
-    // оставляя место для записи атрибутов. В результате это приводит к появлению в xml
-    // странных последовательностей, наподобии ">>" или ">/>"
+    // ... старший бит отличает такой хэш от айди блоков
     //
+    return quint64(qHash(hash)) | kStringHashFlag;
+}
 
-    QString resultXml;
+QString ScenarioXml::blockToXml(QTextBlock& _block, TableState& _state)
+{
+    return blockDataToXml(blockData(_block, _state));
+}
 
-    QTextBlock currentBlock = m_scenario->document()->begin();
-    QString currentBlockXml;
-    bool isInTable = false;
-    bool isSecondColumn = false;
-    do {
-        currentBlockXml.clear();
-        const quint64 currentBlockHash = blockHash(currentBlock);
+ScenarioXml::BlockData ScenarioXml::blockData(QTextBlock& _block, TableState& _state)
+{
+    BlockData data;
+    QTextBlock& currentBlock = _block;
 
+    //
+    // Определим тип текущего блока
+    //
+    const ScenarioBlockStyle::Type currentType = ScenarioBlockStyle::forBlock(currentBlock);
+    data.type = currentType;
+
+    //
+    // Выполним проверки необходимые для корректной обработки таблиц
+    //
+    {
         //
-        // Определим тип текущего блока
+        // Собственно проверяем, что попали или вышли из таблицы
         //
-        ScenarioBlockStyle::Type currentType = ScenarioBlockStyle::forBlock(currentBlock);
-
+        if (currentType == ScenarioBlockStyle::PageSplitter) {
+            _state.isInTable = !_state.isInTable;
+            _state.isSecondColumn = false;
+        }
         //
-        // Выполним проверки необходимые для корректной обработки таблиц
+        // Если начало второй колонки, запишем разделитель
         //
-        {
-            //
-            // Собственно проверяем, что попали или вышли из таблицы
-            //
-            if (currentType == ScenarioBlockStyle::PageSplitter) {
-                isInTable = !isInTable;
-                isSecondColumn = false;
-            }
-            //
-            // Если начало второй колонки, запишем разделитель
-            //
-            if (isInTable
-                && !isSecondColumn) {
-                QTextCursor cursor(currentBlock);
-                if (cursor.currentTable() != nullptr
-                    && cursor.currentTable()->cellAt(cursor).column() == 1) { // вторая колонка
-                    isSecondColumn = true;
-                    resultXml.append(QString("<%1/>\n").arg(kNodeSplitter));
-                }
+        if (_state.isInTable
+            && !_state.isSecondColumn) {
+            QTextCursor cursor(currentBlock);
+            if (cursor.currentTable() != nullptr
+                && cursor.currentTable()->cellAt(cursor).column() == 1) { // вторая колонка
+                _state.isSecondColumn = true;
+                data.splitterXml = QString("<%1/>\n").arg(kNodeSplitter);
             }
         }
+        data.isInTable = _state.isInTable;
+    }
+
+    //
+    // Получить текст под курсором
+    //
+    data.text = currentBlock.text();
+
+    //
+    // Определить параметры текущего абзаца
+    //
+    bool canHaveColors = false; // может иметь цвета
+    switch (currentType) {
+        case ScenarioBlockStyle::SceneHeading: {
+            canHaveColors = true;
+            break;
+        }
+
+        case ScenarioBlockStyle::Parenthetical: {
+            data.needWrite = !data.text.isEmpty();
+            break;
+        }
+
+        case ScenarioBlockStyle::FolderHeader: {
+            canHaveColors = true;
+            break;
+        }
+
+        case ScenarioBlockStyle::PageSplitter: {
+            data.needWrite = false;
+            break;
+        }
+
+        default: {
+            break;
+        }
+    }
 
+    //
+    // Если это декорация, не сохраняем
+    //
+    if (currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsCorrection)) {
+        data.needWrite = false;
+    }
+
+    //
+    // Если разрыв, пробуем сшить
+    //
+    QTextBlock previousBlock;
+    if (currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionStart)) {
         //
-        // Используем кэшированное значение, если
-        // - для блока есть кэш
-        // - блок не разорван по середине
-        // - блок не является границей таблицы
+        // ... сохраняем начальный блок разрыва абзаца
         //
-        if (m_xmlCache.contains(currentBlockHash)
-            && !currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionStart)
-            && !currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionEnd)
-            && currentType != ScenarioBlockStyle::PageSplitter) {
-            resultXml.append(m_xmlCache[currentBlockHash]);
-        }
+        previousBlock = currentBlock;
+        do {
+            currentBlock = currentBlock.next();
+        } while (currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsCorrection));
         //
-        // В противном случае формируем xml
+        // ... если дошли до конца разрыва, то сшиваем его
         //
-        else {
-            //
-            // Получить текст под курсором
-            //
-            QString textToSave = TextEditHelper::toHtmlEscaped(currentBlock.text());
-
-            //
-            // Определить параметры текущего абзаца
-            //
-            bool needWrite = true; // пишем абзац?
-            QString currentNode = ScenarioBlockStyle::typeName(currentType); // имя текущей ячейки
-            bool canHaveColors = false; // может иметь цвета
-            switch (currentType) {
-                case ScenarioBlockStyle::SceneHeading: {
-                    canHaveColors = true;
-                    break;
-                }
+        if (currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionEnd)) {
+            data.hasBreakEnd = true;
+            data.breakEndText = currentBlock.text();
+        }
+    }
 
-                case ScenarioBlockStyle::Parenthetical: {
-                    needWrite = !textToSave.isEmpty();
-                    break;
-                }
+    //
+    // Собрать данные для xml
+    //
+    if (data.needWrite) {
+        data.nodeName = ScenarioBlockStyle::typeName(currentType);
 
-                case ScenarioBlockStyle::FolderHeader: {
-                    canHaveColors = true;
-                    break;
-                }
+        //
+        // NOTE: все данные параграфа остаются в первом блоке, если есть разрыв, так что в
+        //       этом случае нужно смотреть по первому блоку
+        //
+        auto blockUserData = previousBlock.isValid()
+                             ? previousBlock.userData()
+                             : currentBlock.userData();
 
-                case ScenarioBlockStyle::PageSplitter: {
-                    needWrite = false;
-                    break;
+        //
+        // Если возможно, сохраним uuid, цвета элемента, штамп и его заголовок
+        //
+        if (canHaveColors) {
+            SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(blockUserData);
+            if (info == nullptr) {
+                info = new SceneHeadingBlockInfo;
+                if (previousBlock.isValid()) {
+                    previousBlock.setUserData(info);
+                } else {
+                    currentBlock.setUserData(info);
                 }
+                blockUserData = info;
+            }
+            //
+            if (!info->uuid().isEmpty()) {
+                data.uuidColorsAndTitle = QString(" %1=\"%2\"").arg(ATTRIBUTE_UUID, info->uuid());
+            }
+            if (!info->colors().isEmpty()) {
+                data.uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_COLOR, info->colors());
+            }
+            if (!info->stamp().isEmpty()) {
+                data.uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_STAMP, info->stamp());
+            }
+            if (!info->name().isEmpty()) {
+                data.uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_TITLE, TextEditHelper::toHtmlEscaped(info->name()));
+            }
+            if (!info->sceneNumber().isEmpty() && info->isSceneNumberFixed()) {
+                data.uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_SCENE_NUMBER, TextEditHelper::toHtmlEscaped(info->sceneNumber()));
+                data.uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_SCENE_NUMBER_FIX_NESTING, QString::number(info->sceneNumberFixNesting()));
+                data.uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_SCENE_NUMBER_SUFFIX, QString::number(info->sceneNumberSuffix()));
+            }
+        }
 
-                default: {
-                    break;
-                }
+        //
+        // Запишем закладку, если установлена для блока
+        // NOTE: все данные параграфа остаются в первом блоке, если есть разрыв, так что в
+        //       этом случае нужно смотреть по первому блоку
+        //
+        {
+            TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(blockUserData);
+            if (blockInfo != nullptr
+                && blockInfo->hasBookmark()) {
+                data.bookmark = QString(" %1=\"%2\"").arg(ATTRIBUTE_BOOKMARK).arg(TextEditHelper::toHtmlEscaped(blockInfo->bookmark()));
+                data.bookmark += QString(" %1=\"%2\"").arg(ATTRIBUTE_BOOKMARK_COLOR).arg(blockInfo->bookmarkColor().name());
             }
+        }
 
-            //
-            // Если это декорация, не сохраняем
-            //
-            if (currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsCorrection)) {
-                needWrite = false;
+        //
+        // Сформируем список форматов, скорректировав его, если был разрыв
+        //
+        auto ranges = [previousBlock, currentBlock] (bool (*_isFormatEquals)(const QTextCharFormat&, const QTextCharFormat&)) {
+            if (!previousBlock.isValid()) {
+                return currentBlock.textFormats();
             }
 
-            //
-            // Если разрыв, пробуем сшить
-            //
-            QTextBlock previousBlock;
-            if (currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionStart)) {
+            auto ranges = previousBlock.textFormats();
+            for (QTextLayout::FormatRange range : currentBlock.textFormats()) {
                 //
-                // ... сохраняем начальный блок разрыва абзаца
+                // ... если в самом начале разрыва находится часть выделения
+                //     предыдущего блока, объединяем их
                 //
-                previousBlock = currentBlock;
-                do {
-                    currentBlock = currentBlock.next();
-                } while (currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsCorrection));
+                if (range.start == 0
+                    && _isFormatEquals(ranges.last().format, range.format)) {
+                    ranges.last().length += range.length + 1;
+                }
                 //
-                // ... если дошли до конца разрыва, то сшиваем его
+                // ... в противном случае просто сохраняем выделение,
+                //     корректируя стартовую позицию
                 //
-                if (currentBlock.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionEnd)) {
-                    textToSave += " " + TextEditHelper::toHtmlEscaped(currentBlock.text());
+                else {
+                    range.start += previousBlock.length();
+                    ranges.append(range);
                 }
             }
+            return ranges;
+        };
 
-            //
-            // Дописать xml
-            //
-            if (needWrite) {
-                //
-                // NOTE: все данные параграфа остаются в первом блоке, если есть разрыв, так что в
-                //       этом случае нужно смотреть по первому блоку
-                //
-                auto blockUserData = previousBlock.isValid()
-                                     ? previousBlock.userData()
-                                     : currentBlock.userData();
+        //
+        // ... редакторских комментариев
+        //
+        data.hasReviewMarks = hasReviewMarks(previousBlock) || hasReviewMarks(currentBlock);
+        if (data.hasReviewMarks) {
+            data.reviewRanges = ranges(isReviewFormatEquals);
+        }
 
-                //
-                // Если возможно, сохраним uuid, цвета элемента, штамп и его заголовок
-                //
-                QString uuidColorsAndTitle;
-                if (canHaveColors) {
-                    SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(blockUserData);
-                    if (info == nullptr) {
-                        info = new SceneHeadingBlockInfo;
-                        if (previousBlock.isValid()) {
-                            previousBlock.setUserData(info);
-                        } else {
-                            currentBlock.setUserData(info);
-                        }
-                        blockUserData = info;
-                    }
-                    //
-                    if (!info->uuid().isEmpty()) {
-                        uuidColorsAndTitle = QString(" %1=\"%2\"").arg(ATTRIBUTE_UUID, info->uuid());
-                    }
-                    if (!info->colors().isEmpty()) {
-                        uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_COLOR, info->colors());
-                    }
-                    if (!info->stamp().isEmpty()) {
-                        uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_STAMP, info->stamp());
-                    }
-                    if (!info->name().isEmpty()) {
-                        uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_TITLE, TextEditHelper::toHtmlEscaped(info->name()));
-                    }
-                    if (!info->sceneNumber().isEmpty() && info->isSceneNumberFixed()) {
-                        uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_SCENE_NUMBER, TextEditHelper::toHtmlEscaped(info->sceneNumber()));
-                        uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_SCENE_NUMBER_FIX_NESTING, QString::number(info->sceneNumberFixNesting()));
-                        uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_SCENE_NUMBER_SUFFIX, QString::number(info->sceneNumberSuffix()));
-                    }
-                }
+        //
+        // ... и форматирования текста
+        //
+        data.hasFormatting = hasFormatting(previousBlock) || hasFormatting(currentBlock);
+        if (data.hasFormatting) {
+            data.formattingRanges = ranges(isFormattingEquals);
+        }
+    }
 
-                //
-                // Запишем закладку, если установлена для блока
-                // NOTE: все данные параграфа остаются в первом блоке, если есть разрыв, так что в
-                //       этом случае нужно смотреть по первому блоку
-                //
-                QString bookmark;
-                {
-                    TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(blockUserData);
-                    if (blockInfo != nullptr
-                        && blockInfo->hasBookmark()) {
-                        bookmark = QString(" %1=\"%2\"").arg(ATTRIBUTE_BOOKMARK).arg(TextEditHelper::toHtmlEscaped(blockInfo->bookmark()));
-                        bookmark += QString(" %1=\"%2\"").arg(ATTRIBUTE_BOOKMARK_COLOR).arg(blockInfo->bookmarkColor().name());
-                    }
-                }
+    return data;
+}
 
-                //
-                // Открыть ячейку текущего элемента
-                //
-                currentBlockXml.append(QString("<%1%2%3>\n").arg(currentNode, uuidColorsAndTitle, bookmark));
+QString ScenarioXml::blockDataToXml(const BlockData& _data)
+{
+    //
+    // Для формирования xml не используем QXmlStreamWriter, т.к. нам нужно хранить по отдельности
+    // xml каждого блока, а QXmlStreamWriter не всегда закрывает последний записанный тэг,
+    // оставляя место для записи атрибутов. В результате это приводит к появлению в xml
+    // странных последовательностей, наподобии ">>" или ">/>"
+    //
 
-                //
-                // Пишем текст текущего элемента
-                //
-                currentBlockXml.append(QString("<%1><![CDATA[%2]]></%1>\n").arg(kNodeValue, textToSave));
+    QString currentBlockXml;
 
-                //
-                // Пишем редакторские комментарии, если они есть в блоке
-                //
-                if (hasReviewMarks(previousBlock) || hasReviewMarks(currentBlock)) {
-                    auto writeReviewMark = [&currentBlockXml] (const QTextLayout::FormatRange& _range) {
-                        currentBlockXml.append(QString("<%1").arg(kNodeReview));
-                        //
-                        // Данные редакторского выделения
-                        //
-                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_FROM, QString::number(_range.start)));
-                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_LENGTH, QString::number(_range.length)));
-                        if (_range.format.hasProperty(QTextFormat::ForegroundBrush)) {
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_COLOR, _range.format.foreground().color().name()));
-                        }
-                        if (_range.format.hasProperty(QTextFormat::BackgroundBrush)) {
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_BGCOLOR, _range.format.background().color().name()));
-                        }
-                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_IS_HIGHLIGHT,
-                            _range.format.boolProperty(ScenarioBlockStyle::PropertyIsHighlight) ? "true" : "false"));
-                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_DONE,
-                            _range.format.boolProperty(ScenarioBlockStyle::PropertyIsDone) ? "true" : "false"));
-                        currentBlockXml.append(">\n");
-                        //
-                        // ... сами комментарии
-                        //
-                        const QStringList comments = _range.format.property(ScenarioBlockStyle::PropertyComments).toStringList();
-                        const QStringList authors = _range.format.property(ScenarioBlockStyle::PropertyCommentsAuthors).toStringList();
-                        const QStringList dates = _range.format.property(ScenarioBlockStyle::PropertyCommentsDates).toStringList();
-                        for (int commentIndex = 0; commentIndex < comments.size(); ++commentIndex) {
-                            currentBlockXml.append(QString("<%1").arg(kNodeReviewComment));
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_COMMENT,
-                                TextEditHelper::toHtmlEscaped(comments.at(commentIndex))));
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_AUTHOR, authors.at(commentIndex)));
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_DATE, dates.at(commentIndex)));
-                            currentBlockXml.append("/>\n");
-                        }
-                        //
-                        currentBlockXml.append(QString("</%1>\n").arg(kNodeReview));
-                    };
+    //
+    // Дописать xml
+    //
+    if (_data.needWrite) {
+        //
+        // Текст текущего элемента, сшитый с окончанием разрыва
+        //
+        QString textToSave = TextEditHelper::toHtmlEscaped(_data.text);
+        if (_data.hasBreakEnd) {
+            textToSave += " " + TextEditHelper::toHtmlEscaped(_data.breakEndText);
+        }
 
-                    //
-                    // Пишем начало
-                    //
-                    currentBlockXml.append(QString("<%1>\n").arg(kNodeReviewGroup));
-                    //
-                    // Пишем тело
-                    //
-                    // ... но сперва сформируем список форматов, скорректировав его, если был разрыв
-                    //
-                    auto ranges = [previousBlock, currentBlock] {
-                        if (!previousBlock.isValid()) {
-                            return currentBlock.textFormats();
-                        }
+        //
+        // Открыть ячейку текущего элемента
+        //
+        currentBlockXml.append(QString("<%1%2%3>\n").arg(_data.nodeName, _data.uuidColorsAndTitle, _data.bookmark));
 
-                        auto ranges = previousBlock.textFormats();
-                        for (QTextLayout::FormatRange range : currentBlock.textFormats()) {
-                            //
-                            // ... если в самом начале разрыва находится часть выделения
-                            //     предыдущего блока, объединяем их
-                            //
-                            if (range.start == 0
-                                && isReviewFormatEquals(ranges.last().format, range.format)) {
-                                ranges.last().length += range.length + 1;
-                            }
-                            //
-                            // ... в противном случае просто сохраняем выделение,
-                            //     корректируя стартовую позицию
-                            //
-                            else {
-                                range.start += previousBlock.length();
-                                ranges.append(range);
-                            }
-                        }
-                        return ranges;
-                    } ();
-                    QTextLayout::FormatRange lastFormatRange{0, 0, QTextCharFormat()};
-                    for (const QTextLayout::FormatRange& range : ranges) {
-                        if (!range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark)) {
-                            continue;
-                        }
+        //
+        // Пишем текст текущего элемента
+        //
+        currentBlockXml.append(QString("<%1><![CDATA[%2]]></%1>\n").arg(kNodeValue, textToSave));
 
-                        //
-                        // Если следующий формат равен предыдущему и он является продолжает предыдущего
-                        //
-                        if (isReviewFormatEquals(lastFormatRange.format, range.format)
-                            && ((lastFormatRange.start + lastFormatRange.length) == range.start)) {
-                            //
-                            // Объединяем их в одну сущность
-                            //
-                            lastFormatRange.length += range.length;
-                        }
-                        //
-                        // В противном случае
-                        //
-                        else {
-                            //
-                            // Если предыдущий формат был задан, запишем его
-                            //
-                            if (lastFormatRange.length > 0) {
-                                writeReviewMark(lastFormatRange);
-                            }
-                            //
-                            // и перейдём к обработке следующего формата
-                            //
-                            lastFormatRange = range;
-                        }
-                    }
-                    //
-                    // Запишем последний формат
-                    //
-                    writeReviewMark(lastFormatRange);
-                    //
-                    // Пишем конец
-                    //
-                    currentBlockXml.append(QString("</%1>\n").arg(kNodeReviewGroup));
+        //
+        // Пишем редакторские комментарии, если они есть в блоке
+        //
+        if (_data.hasReviewMarks) {
+            auto writeReviewMark = [&currentBlockXml] (const QTextLayout::FormatRange& _range) {
+                currentBlockXml.append(QString("<%1").arg(kNodeReview));
+                //
+                // Данные редакторского выделения
+                //
+                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_FROM, QString::number(_range.start)));
+                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_LENGTH, QString::number(_range.length)));
+                if (_range.format.hasProperty(QTextFormat::ForegroundBrush)) {
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_COLOR, _range.format.foreground().color().name()));
                 }
-
+                if (_range.format.hasProperty(QTextFormat::BackgroundBrush)) {
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_BGCOLOR, _range.format.background().color().name()));
+                }
+                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_IS_HIGHLIGHT,
+                    _range.format.boolProperty(ScenarioBlockStyle::PropertyIsHighlight) ? "true" : "false"));
+                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_DONE,
+                    _range.format.boolProperty(ScenarioBlockStyle::PropertyIsDone) ? "true" : "false"));
+                currentBlockXml.append(">\n");
                 //
-                // Пишем форматирование текста блока
+                // ... сами комментарии
                 //
-                if (hasFormatting(previousBlock) || hasFormatting(currentBlock)) {
-                    auto writeFormatting = [&currentBlockXml] (const QTextLayout::FormatRange& _range) {
-                        currentBlockXml.append(QString("<%1").arg(kNodeFormat));
-                        //
-                        // Данные пользовательского форматирования
-                        //
-                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_FROM, QString::number(_range.start)));
-                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_LENGTH, QString::number(_range.length)));
-                        if (_range.format.hasProperty(QTextFormat::FontWeight)) {
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_BOLD,
-                                                                             _range.format.font().bold() ? "true" : "false"));
-                        }
-                        if (_range.format.hasProperty(QTextFormat::FontItalic)) {
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_ITALIC,
-                                                                             _range.format.font().italic() ? "true" : "false"));
-                        }
-                        if (_range.format.hasProperty(QTextFormat::TextUnderlineStyle)) {
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_UNDERLINE,
-                                                                             _range.format.font().underline() ? "true" : "false"));
-                        }
-                        //
-                        currentBlockXml.append("/>\n");
-                    };
-
-                    //
-                    // Пишем начало
-                    //
-                    currentBlockXml.append(QString("<%1>\n").arg(kNodeFormatGroup));
-                    //
-                    // Пишем тело
-                    //
-                    // ... но сперва сформируем список форматов, скорректировав его, если был разрыв
-                    //
-                    auto ranges = [previousBlock, currentBlock] {
-                        if (!previousBlock.isValid()) {
-                            return currentBlock.textFormats();
-                        }
-
-                        auto ranges = previousBlock.textFormats();
-                        for (QTextLayout::FormatRange range : currentBlock.textFormats()) {
-                            //
-                            // ... если в самом начале разрыва находится часть выделения
-                            //     предыдущего блока, объединяем их
-                            //
-                            if (range.start == 0
-                                && isFormattingEquals(ranges.last().format, range.format)) {
-                                ranges.last().length += range.length + 1;
-                            }
-                            //
-                            // ... в противном случае просто сохраняем выделение,
-                            //     корректируя стартовую позицию
-                            //
-                            else {
-                                range.start += previousBlock.length();
-                                ranges.append(range);
-                            }
-                        }
-                        return ranges;
-                    } ();
-                    QTextLayout::FormatRange lastFormatRange{0, 0, QTextCharFormat()};
-                    for (const QTextLayout::FormatRange& range : ranges) {
-                        if (!range.format.boolProperty(ScenarioBlockStyle::PropertyIsFormatting)) {
-                            continue;
-                        }
+                const QStringList comments = _range.format.property(ScenarioBlockStyle::PropertyComments).toStringList();
+                const QStringList authors = _range.format.property(ScenarioBlockStyle::PropertyCommentsAuthors).toStringList();
+                const QStringList dates = _range.format.property(ScenarioBlockStyle::PropertyCommentsDates).toStringList();
+                for (int commentIndex = 0; commentIndex < comments.size(); ++commentIndex) {
+                    currentBlockXml.append(QString("<%1").arg(kNodeReviewComment));
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_COMMENT,
+                        TextEditHelper::toHtmlEscaped(comments.at(commentIndex))));
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_AUTHOR, authors.at(commentIndex)));
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_DATE, dates.at(commentIndex)));
+                    currentBlockXml.append("/>\n");
+                }
+                //
+                currentBlockXml.append(QString("</%1>\n").arg(kNodeReview));
+            };
 
-                        //
-                        // Если следующий формат равен предыдущему и он является продолжает предыдущего
-                        //
-                        if (isFormattingEquals(lastFormatRange.format, range.format)
-                            && ((lastFormatRange.start + lastFormatRange.length) == range.start)) {
-                            //
-                            // Объединяем их в одну сущность
-                            //
-                            lastFormatRange.length += range.length;
-                        }
-                        //
-                        // В противном случае
-                        //
-                        else {
-                            //
-                            // Если предыдущий формат был задан, запишем его
-                            //
-                            if (lastFormatRange.length > 0) {
-                                writeFormatting(lastFormatRange);
-                            }
-                            //
-                            // и перейдём к обработке следующего формата
-                            //
-                            lastFormatRange = range;
-                        }
-                    }
+            //
+            // Пишем начало
+            //
+            currentBlockXml.append(QString("<%1>\n").arg(kNodeReviewGroup));
+            //
+            // Пишем тело
+            //
+            QTextLayout::FormatRange lastFormatRange{0, 0, QTextCharFormat()};
+            for (const QTextLayout::FormatRange& range : _data.reviewRanges) {
+                if (!range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark)) {
+                    continue;
+                }
+
+                //
+                // Если следующий формат равен предыдущему и он является продолжает предыдущего
+                //
+                if (isReviewFormatEquals(lastFormatRange.format, range.format)
+                    && ((lastFormatRange.start + lastFormatRange.length) == range.start)) {
                     //
-                    // Запишем последний формат
+                    // Объединяем их в одну сущность
+                    //
+                    lastFormatRange.length += range.length;
+                }
+                //
+                // В противном случае
+                //
+                else {
                     //
-                    writeFormatting(lastFormatRange);
+                    // Если предыдущий формат был задан, запишем его
                     //
-                    // Пишем конец
+                    if (lastFormatRange.length > 0) {
+                        writeReviewMark(lastFormatRange);
+                    }
                     //
-                    currentBlockXml.append(QString("</%1>\n").arg(kNodeFormatGroup));
+                    // и перейдём к обработке следующего формата
+                    //
+                    lastFormatRange = range;
                 }
+            }
+            //
+            // Запишем последний формат
+            //
+            writeReviewMark(lastFormatRange);
+            //
+            // Пишем конец
+            //
+            currentBlockXml.append(QString("</%1>\n").arg(kNodeReviewGroup));
+        }
 
+        //
+        // Пишем форматирование текста блока
+        //
+        if (_data.hasFormatting) {
+            auto writeFormatting = [&currentBlockXml] (const QTextLayout::FormatRange& _range) {
+                currentBlockXml.append(QString("<%1").arg(kNodeFormat));
                 //
-                // Закрываем текущий элемент
+                // Данные пользовательского форматирования
                 //
-                currentBlockXml.append(QString("</%1>\n").arg(currentNode));
-            }
+                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_FROM, QString::number(_range.start)));
+                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_LENGTH, QString::number(_range.length)));
+                if (_range.format.hasProperty(QTextFormat::FontWeight)) {
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_BOLD,
+                                                                     _range.format.font().bold() ? "true" : "false"));
+                }
+                if (_range.format.hasProperty(QTextFormat::FontItalic)) {
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_ITALIC,
+                                                                     _range.format.font().italic() ? "true" : "false"));
+                }
+                if (_range.format.hasProperty(QTextFormat::TextUnderlineStyle)) {
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_FORMAT_UNDERLINE,
+                                                                     _range.format.font().underline() ? "true" : "false"));
+                }
+                //
+                currentBlockXml.append("/>\n");
+            };
 
-            else if (currentType == ScenarioBlockStyle::PageSplitter) {
-                currentBlockXml.append(QString("<%1/>\n").arg(isInTable
-                                                            ? kNodeSplitterStart
-                                                            : kNodeSplitterEnd));
-            }
+            //
+            // Пишем начало
+            //
+            currentBlockXml.append(QString("<%1>\n").arg(kNodeFormatGroup));
+            //
+            // Пишем тело
+            //
+            QTextLayout::FormatRange lastFormatRange{0, 0, QTextCharFormat()};
+            for (const QTextLayout::FormatRange& range : _data.formattingRanges) {
+                if (!range.format.boolProperty(ScenarioBlockStyle::PropertyIsFormatting)) {
+                    continue;
+                }
 
-            m_xmlCache.insert(currentBlockHash, new QString(currentBlockXml));
-            resultXml.append(currentBlockXml);
+                //
+                // Если следующий формат равен предыдущему и он является продолжает предыдущего
+                //
+                if (isFormattingEquals(lastFormatRange.format, range.format)
+                    && ((lastFormatRange.start + lastFormatRange.length) == range.start)) {
+                    //
+                    // Объединяем их в одну сущность
+                    //
+                    lastFormatRange.length += range.length;
+                }
+                //
+                // В противном случае
+                //
+                else {
+                    //
+                    // Если предыдущий формат был задан, запишем его
+                    //
+                    if (lastFormatRange.length > 0) {
+                        writeFormatting(lastFormatRange);
+                    }
+                    //
+                    // и перейдём к обработке следующего формата
+                    //
+                    lastFormatRange = range;
+                }
+            }
+            //
+            // Запишем последний формат
+            //
+            writeFormatting(lastFormatRange);
+            //
+            // Пишем конец
+            //
+            currentBlockXml.append(QString("</%1>\n").arg(kNodeFormatGroup));
         }
-        currentBlock = currentBlock.next();
 
+        //
+        // Закрываем текущий элемент
+        //
+        currentBlockXml.append(QString("</%1>\n").arg(_data.nodeName));
+    }
 
-    } while (currentBlock.isValid());
+    else if (_data.type == ScenarioBlockStyle::PageSplitter) {
+        currentBlockXml.append(QString("<%1/>\n").arg(_data.isInTable
+                                                      ? kNodeSplitterStart
+                                                      : kNodeSplitterEnd));
+    }
 
-    return makeMimeFromXml(resultXml);
+    return _data.splitterXml + currentBlockXml;
 }
 
 QString ScenarioXml::scenarioToXml(int _startPosition, int _endPosition, bool _correctLastMime)
@@ -1361,6 +1451,17 @@ void ScenarioXml::xmlToScenario(int _position, const QString& _xml, bool _remain
     }
 }
 
+void ScenarioXml::appendXmlToScenario(const QString& _xml)
+{
+    //
+    // Дописываются только части xml текущей версии, см. splitXml
+    //
+    const int endPosition = m_scenario->document()->characterCount() - 1;
+    const bool remainLinkedData = true;
+    const bool appendBlocks = true;
+    xmlToScenarioV1(endPosition, _xml, remainLinkedData, appendBlocks);
+}
+
 int ScenarioXml::xmlToScenario(ScenarioModelItem* _insertParent, ScenarioModelItem* _insertBefore, const QString& _xml, bool _removeLastMime)
 {
     //
@@ -1417,8 +1518,10 @@ int ScenarioXml::xmlToScenario(ScenarioModelItem* _insertParent, ScenarioModelIt
             if (SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*> (cursor.block().userData())) {
                 SceneHeadingBlockInfo* movedInfo = info->clone();
                 cursor.block().setUserData(nullptr);
+                ScenarioTextDocument::markBlockDataChanged(cursor.block());
                 cursor.movePosition(QTextCursor::NextBlock);
                 cursor.block().setUserData(movedInfo);
+                ScenarioTextDocument::markBlockDataChanged(cursor.block());
             }
         }
 
@@ -1623,273 +1726,284 @@ void ScenarioXml::xmlToScenarioV0(int _position, const QString& _xml)
     cursor.endEditBlock();
 }
 
-void ScenarioXml::xmlToScenarioV1(int _position, const QString& _xml, bool _remainLinkedData)
+void ScenarioXml::xmlToScenarioV1(int _position, const QString& _xml, bool _remainLinkedData, bool _appendBlocks)
 {
     //
-    // Происходит ли обработка первого блока
-    //
-    bool firstBlockHandling = true;
-    //
-    // Необходимо ли изменить тип блока, в который вставляется текст
-    //
-    bool needChangeFirstBlockType = false;
-
-    //
-    // Начинаем операцию вставки
-    //
-    ScriptTextCursor cursor(m_scenario->document());
-    cursor.setPosition(_position);
-    cursor.beginEditBlock();
-
-    //
-    // Если вставка в пустой блок, то изменим его тип
-    //
-    if (cursor.block().text().simplified().isEmpty()) {
-        needChangeFirstBlockType = true;
-    }
-
-    //
-    // Собственно считываем данные
+    // Сперва считываем все блоки из xml, чтобы затем вставить их в документ за один проход.
+    // Первый блок списка соответствует блоку, в который производится вставка, в него попадёт
+    // текст, идущий до первого тэга блока
     //
+    QVector<XmlBlock> blocks(1);
     QXmlStreamReader reader(_xml);
     while (!reader.atEnd()) {
-        //
-        // Даём возможность выполниться графическим операциям
-        //
-        QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-
         switch (reader.readNext()) {
             case QXmlStreamReader::StartElement: {
                 //
                 // Определить тип текущего блока
                 //
-                ScenarioBlockStyle::Type tokenType = ScenarioBlockStyle::Undefined;
-                QString tokenName = reader.name().toString();
-                tokenType = ScenarioBlockStyle::typeForName(tokenName);
+                const QString tokenName = reader.name().toString();
+                const ScenarioBlockStyle::Type tokenType = ScenarioBlockStyle::typeForName(tokenName);
 
                 //
-                // Если определён тип блока, то обработать его
+                // Если определён тип блока, то начинаем новый блок
                 //
                 if (tokenType != ScenarioBlockStyle::Undefined) {
-                    ScenarioBlockStyle currentStyle = ScenarioTemplateFacade::getTemplate().blockStyle(tokenType);
-
-                    if (firstBlockHandling) {
-                        cursor.block().setVisible(true);
-                    } else {
-                        cursor.insertBlock();
-                    }
-
-                    //
-                    // Если необходимо сменить тип блока
-                    //
-                    if ((firstBlockHandling && needChangeFirstBlockType)
-                        || !firstBlockHandling) {
-
-                        //
-                        // Установим стиль блока
-                        //
-                        cursor.setBlockFormat(currentStyle.blockFormat());
-                        cursor.setBlockCharFormat(currentStyle.charFormat());
-                        cursor.setCharFormat(currentStyle.charFormat());
-                    }
-
-                    //
-                    // Корректируем информацию о шаге
-                    //
-                    if (firstBlockHandling) {
-                        firstBlockHandling = false;
-                    }
-
-                    //
-                    // Если необходимо, загрузить информацию о сцене
-                    //
-                    if (tokenType == ScenarioBlockStyle::SceneHeading
-                        || tokenType == ScenarioBlockStyle::FolderHeader) {
-                        SceneHeadingBlockInfo* info = new SceneHeadingBlockInfo;
-                        if (reader.attributes().hasAttribute(ATTRIBUTE_UUID)) {
-                            const QString uuid = reader.attributes().value(ATTRIBUTE_UUID).toString();
-                            if (_remainLinkedData || !isScenarioHaveUuid(uuid)) {
-                                info->setUuid(uuid);
-                            }
-                        }
-                        if (reader.attributes().hasAttribute(ATTRIBUTE_COLOR)) {
-                            info->setColors(reader.attributes().value(ATTRIBUTE_COLOR).toString());
-                        }
-                        if (reader.attributes().hasAttribute(ATTRIBUTE_STAMP)) {
-                            info->setStamp(reader.attributes().value(ATTRIBUTE_STAMP).toString());
-                        }
-                        if (reader.attributes().hasAttribute(ATTRIBUTE_TITLE)) {
-                            info->setName(TextEditHelper::fromHtmlEscaped(reader.attributes().value(ATTRIBUTE_TITLE).toString()));
-                        }
-                        if (reader.attributes().hasAttribute(ATTRIBUTE_SCENE_NUMBER) && _remainLinkedData) {
-                            info->setSceneNumber(reader.attributes().value(ATTRIBUTE_SCENE_NUMBER).toString());
-                            info->setSceneNumberFixed(true);
-                        }
-                        if (reader.attributes().hasAttribute(ATTRIBUTE_SCENE_NUMBER_FIX_NESTING)) {
-                            info->setSceneNumberFixNesting(reader.attributes().value(ATTRIBUTE_SCENE_NUMBER_FIX_NESTING).toInt());
-                        }
-                        if (reader.attributes().hasAttribute(ATTRIBUTE_SCENE_NUMBER_SUFFIX)) {
-                            info->setSceneNumberSuffix(reader.attributes().value(ATTRIBUTE_SCENE_NUMBER_SUFFIX).toInt());
+                    XmlBlock block;
+                    block.type = tokenType;
+                    block.attributes = reader.attributes();
+                    blocks.append(block);
+                }
+                //
+                // Редакторские заметки
+                //
+                else if (tokenName == kNodeReview) {
+                    const int start = reader.attributes().value(ATTRIBUTE_REVIEW_FROM).toInt();
+                    const int length = reader.attributes().value(ATTRIBUTE_REVIEW_LENGTH).toInt();
+                    const bool highlight = reader.attributes().value(ATTRIBUTE_REVIEW_IS_HIGHLIGHT).toString() == "true";
+                    const bool done = reader.attributes().value(ATTRIBUTE_REVIEW_DONE).toString() == "true";
+                    const QColor foreground(reader.attributes().value(ATTRIBUTE_REVIEW_COLOR).toString());
+                    const QColor background(reader.attributes().value(ATTRIBUTE_REVIEW_BGCOLOR).toString());
+                    //
+                    // ... считываем комментарии
+                    //
+                    QStringList comments, authors, dates;
+                    while (reader.readNextStartElement()) {
+                        if (reader.name() == kNodeReviewComment) {
+                            comments << TextEditHelper::fromHtmlEscaped(reader.attributes().value(ATTRIBUTE_REVIEW_COMMENT).toString());
+                            authors << reader.attributes().value(ATTRIBUTE_REVIEW_AUTHOR).toString();
+                            dates << reader.attributes().value(ATTRIBUTE_REVIEW_DATE).toString();
+
+                            reader.skipCurrentElement();
                         }
-                        cursor.block().setUserData(info);
-                    }
-                    //
-                    // Для всех остальных блоков создаём структурку с данными о блоке
-                    //
-                    else {
-                        TextBlockInfo* info = tokenType == ScenarioBlockStyle::Character
-                                              ? new CharacterBlockInfo
-                                              : new TextBlockInfo;
-                        cursor.block().setUserData(info);
                     }
 
-                    //
-                    // Загружаем закладки, если установлены
-                    //
-                    if (reader.attributes().hasAttribute(ATTRIBUTE_BOOKMARK)) {
-                        TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(cursor.block().userData());
-                        blockInfo->setHasBookmark(true);
-                        blockInfo->setBookmark(reader.attributes().value(ATTRIBUTE_BOOKMARK).toString());
-                        blockInfo->setBookmarkColor(reader.attributes().value(ATTRIBUTE_BOOKMARK_COLOR).toString());
-                        cursor.block().setUserData(blockInfo);
-                    }
 
                     //
-                    // Загружаем дифы, если заданы
+                    // Собираем формат редакторской заметки
                     //
-                    if (reader.attributes().hasAttribute(ATTRIBUTE_DIFF_ADDED)
-                        || reader.attributes().hasAttribute(ATTRIBUTE_DIFF_REMOVED)) {
-                        TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(cursor.block().userData());
-
-                        if (reader.attributes().hasAttribute(ATTRIBUTE_DIFF_ADDED)) {
-                            blockInfo->setDiffType(TextBlockInfo::kDiffAdded);
-                        } else if (reader.attributes().hasAttribute(ATTRIBUTE_DIFF_REMOVED)) {
-                            blockInfo->setDiffType(TextBlockInfo::kDiffRemoved);
-                        }
-                        cursor.block().setUserData(blockInfo);
+                    QTextCharFormat reviewFormat;
+                    reviewFormat.setProperty(ScenarioBlockStyle::PropertyIsReviewMark, true);
+                    if (foreground.isValid()) {
+                        reviewFormat.setForeground(foreground);
                     }
-
-                    //
-                    // Скрываем блоки, которых не должно быть видно в текщем режиме сценария
-                    //
-                    if (!m_scenario->document()->visibleBlocksTypes().contains(tokenType)) {
-                        cursor.block().setVisible(false);
+                    if (background.isValid()) {
+                        reviewFormat.setBackground(background);
                     }
+                    reviewFormat.setProperty(ScenarioBlockStyle::PropertyIsHighlight, highlight);
+                    reviewFormat.setProperty(ScenarioBlockStyle::PropertyIsDone, done);
+                    reviewFormat.setProperty(ScenarioBlockStyle::PropertyComments, comments);
+                    reviewFormat.setProperty(ScenarioBlockStyle::PropertyCommentsAuthors, authors);
+                    reviewFormat.setProperty(ScenarioBlockStyle::PropertyCommentsDates, dates);
+
+                    blocks.last().formats.append({ start, length, reviewFormat });
                 }
                 //
-                // Обработка остальных тэгов
+                // Форматирование
                 //
-                else {
+                else if (tokenName == kNodeFormat) {
+                    const int start = reader.attributes().value(ATTRIBUTE_FORMAT_FROM).toInt();
+                    const int length = reader.attributes().value(ATTRIBUTE_FORMAT_LENGTH).toInt();
+                    const bool bold = reader.attributes().value(ATTRIBUTE_FORMAT_BOLD).toString() == "true";
+                    const bool italic = reader.attributes().value(ATTRIBUTE_FORMAT_ITALIC).toString() == "true";
+                    const bool underline = reader.attributes().value(ATTRIBUTE_FORMAT_UNDERLINE).toString() == "true";
+
+
                     //
-                    // Редакторские заметки
+                    // Собираем формат
                     //
-                    if (tokenName == kNodeReview) {
-                        const int start = reader.attributes().value(ATTRIBUTE_REVIEW_FROM).toInt();
-                        const int length = reader.attributes().value(ATTRIBUTE_REVIEW_LENGTH).toInt();
-                        const bool highlight = reader.attributes().value(ATTRIBUTE_REVIEW_IS_HIGHLIGHT).toString() == "true";
-                        const bool done = reader.attributes().value(ATTRIBUTE_REVIEW_DONE).toString() == "true";
-                        const QColor foreground(reader.attributes().value(ATTRIBUTE_REVIEW_COLOR).toString());
-                        const QColor background(reader.attributes().value(ATTRIBUTE_REVIEW_BGCOLOR).toString());
-                        //
-                        // ... считываем комментарии
-                        //
-                        QStringList comments, authors, dates;
-                        while (reader.readNextStartElement()) {
-                            if (reader.name() == kNodeReviewComment) {
-                                comments << TextEditHelper::fromHtmlEscaped(reader.attributes().value(ATTRIBUTE_REVIEW_COMMENT).toString());
-                                authors << reader.attributes().value(ATTRIBUTE_REVIEW_AUTHOR).toString();
-                                dates << reader.attributes().value(ATTRIBUTE_REVIEW_DATE).toString();
-
-                                reader.skipCurrentElement();
-                            }
-                        }
+                    QTextCharFormat format;
+                    format.setProperty(ScenarioBlockStyle::PropertyIsFormatting, true);
+                    format.setFontWeight(bold ? QFont::Bold : QFont::Normal);
+                    format.setFontItalic(italic);
+                    format.setFontUnderline(underline);
 
+                    blocks.last().formats.append({ start, length, format });
+                }
 
-                        //
-                        // Собираем формат редакторской заметки
-                        //
-                        QTextCharFormat reviewFormat;
-                        reviewFormat.setProperty(ScenarioBlockStyle::PropertyIsReviewMark, true);
-                        if (foreground.isValid()) {
-                            reviewFormat.setForeground(foreground);
-                        }
-                        if (background.isValid()) {
-                            reviewFormat.setBackground(background);
-                        }
-                        reviewFormat.setProperty(ScenarioBlockStyle::PropertyIsHighlight, highlight);
-                        reviewFormat.setProperty(ScenarioBlockStyle::PropertyIsDone, done);
-                        reviewFormat.setProperty(ScenarioBlockStyle::PropertyComments, comments);
-                        reviewFormat.setProperty(ScenarioBlockStyle::PropertyCommentsAuthors, authors);
-                        reviewFormat.setProperty(ScenarioBlockStyle::PropertyCommentsDates, dates);
+                break;
+            }
 
+            case QXmlStreamReader::Characters: {
+                if (!reader.isWhitespace()) {
+                    blocks.last().text.append(TextEditHelper::fromHtmlEscaped(reader.text().toString()));
+                }
+                break;
+            }
 
-                        //
-                        // Вставляем в документ
-                        //
-                        QTextCursor reviewCursor = cursor;
-                        int startDelta = 0;
-                        if (reviewCursor.block().position() < _position
-                            && (reviewCursor.block().position() + reviewCursor.block().length()) > _position) {
-                            startDelta = _position - reviewCursor.block().position();
-                        }
-                        reviewCursor.setPosition(reviewCursor.block().position() + start + startDelta);
-                        reviewCursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, length);
-                        reviewCursor.mergeCharFormat(reviewFormat);
-                    }
+            default: {
+                break;
+            }
+        }
+    }
 
-                    //
-                    // Форматирование
-                    //
-                    if (tokenName == kNodeFormat) {
-                        const int start = reader.attributes().value(ATTRIBUTE_FORMAT_FROM).toInt();
-                        const int length = reader.attributes().value(ATTRIBUTE_FORMAT_LENGTH).toInt();
-                        const bool bold = reader.attributes().value(ATTRIBUTE_FORMAT_BOLD).toString() == "true";
-                        const bool italic = reader.attributes().value(ATTRIBUTE_FORMAT_ITALIC).toString() == "true";
-                        const bool underline = reader.attributes().value(ATTRIBUTE_FORMAT_UNDERLINE).toString() == "true";
+    //
+    // Стили блоков, видимые в текущем режиме типы блоков и идентификаторы элементов документа
+    // определяем единожды для всей вставки
+    //
+    const ScenarioTemplate scenarioTemplate = ScenarioTemplateFacade::getTemplate();
+    QMap<ScenarioBlockStyle::Type, ScenarioBlockStyle> blockStyles;
+    const QList<ScenarioBlockStyle::Type> visibleBlocksTypes = m_scenario->document()->visibleBlocksTypes();
+    QSet<QString> usedUuids;
+    if (!_remainLinkedData) {
+        usedUuids = scenarioUuids();
+    }
 
+    //
+    // Начинаем операцию вставки
+    //
+    ScriptTextCursor cursor(m_scenario->document());
+    cursor.setPosition(_position);
+    cursor.beginEditBlock();
 
-                        //
-                        // Собираем формат
-                        //
-                        QTextCharFormat format;
-                        format.setProperty(ScenarioBlockStyle::PropertyIsFormatting, true);
-                        format.setFontWeight(bold ? QFont::Bold : QFont::Normal);
-                        format.setFontItalic(italic);
-                        format.setFontUnderline(underline);
+    //
+    // Если вставка в пустой блок, то изменим его тип
+    //
+    const bool needChangeFirstBlockType = !_appendBlocks && cursor.block().text().simplified().isEmpty();
+
+    //
+    // Собственно вставляем блоки
+    //
+    for (int blockIndex = 0; blockIndex < blocks.size(); ++blockIndex) {
+        //
+        // Даём возможность выполниться графическим операциям, но не чаще, чем раз в несколько
+        // сотен блоков, т.к. обработка событий намного дороже вставки одного блока
+        //
+        if (blockIndex > 0
+            && blockIndex % kProcessEventsBlocksInterval == 0) {
+            QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+        }
 
+        const XmlBlock& block = blocks.at(blockIndex);
 
-                        //
-                        // Вставляем в документ
-                        //
-                        QTextCursor formattingCursor = cursor;
-                        int startDelta = 0;
-                        if (formattingCursor.block().position() < _position
-                            && (formattingCursor.block().position() + formattingCursor.block().length()) > _position) {
-                            startDelta = _position - formattingCursor.block().position();
-                        }
-                        formattingCursor.setPosition(formattingCursor.block().position() + start + startDelta);
-                        formattingCursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, length);
-                        formattingCursor.mergeCharFormat(format);
+        //
+        // Если определён тип блока, то обработать его
+        //
+        if (block.type != ScenarioBlockStyle::Undefined) {
+            if (!blockStyles.contains(block.type)) {
+                blockStyles.insert(block.type, scenarioTemplate.blockStyle(block.type));
+            }
+            const ScenarioBlockStyle& currentStyle = blockStyles[block.type];
+
+            //
+            // Первый блок вставляется в текущий, сменив при необходимости его тип,
+            // а каждый последующий, как и все блоки при дописывании, вставляем сразу с нужным стилем
+            //
+            const bool firstBlockHandling = !_appendBlocks && blockIndex == 1;
+            if (firstBlockHandling) {
+                cursor.block().setVisible(true);
+                if (needChangeFirstBlockType) {
+                    cursor.setBlockFormat(currentStyle.blockFormat());
+                    cursor.setBlockCharFormat(currentStyle.charFormat());
+                    cursor.setCharFormat(currentStyle.charFormat());
+                }
+            } else {
+                cursor.insertBlock(currentStyle.blockFormat(), currentStyle.charFormat());
+            }
+
+            //
+            // Если необходимо, загрузить информацию о сцене
+            //
+            if (block.type == ScenarioBlockStyle::SceneHeading
+                || block.type == ScenarioBlockStyle::FolderHeader) {
+                SceneHeadingBlockInfo* info = new SceneHeadingBlockInfo;
+                if (block.attributes.hasAttribute(ATTRIBUTE_UUID)) {
+                    const QString uuid = block.attributes.value(ATTRIBUTE_UUID).toString();
+                    if (_remainLinkedData || !usedUuids.contains(uuid)) {
+                        info->setUuid(uuid);
                     }
                 }
+                if (block.attributes.hasAttribute(ATTRIBUTE_COLOR)) {
+                    info->setColors(block.attributes.value(ATTRIBUTE_COLOR).toString());
+                }
+                if (block.attributes.hasAttribute(ATTRIBUTE_STAMP)) {
+                    info->setStamp(block.attributes.value(ATTRIBUTE_STAMP).toString());
+                }
+                if (block.attributes.hasAttribute(ATTRIBUTE_TITLE)) {
+                    info->setName(TextEditHelper::fromHtmlEscaped(block.attributes.value(ATTRIBUTE_TITLE).toString()));
+                }
+                if (block.attributes.hasAttribute(ATTRIBUTE_SCENE_NUMBER) && _remainLinkedData) {
+                    info->setSceneNumber(block.attributes.value(ATTRIBUTE_SCENE_NUMBER).toString());
+                    info->setSceneNumberFixed(true);
+                }
+                if (block.attributes.hasAttribute(ATTRIBUTE_SCENE_NUMBER_FIX_NESTING)) {
+                    info->setSceneNumberFixNesting(block.attributes.value(ATTRIBUTE_SCENE_NUMBER_FIX_NESTING).toInt());
+                }
+                if (block.attributes.hasAttribute(ATTRIBUTE_SCENE_NUMBER_SUFFIX)) {
+                    info->setSceneNumberSuffix(block.attributes.value(ATTRIBUTE_SCENE_NUMBER_SUFFIX).toInt());
+                }
+                cursor.block().setUserData(info);
 
-                break;
+                //
+                // ... вставленный элемент тоже учитываем при проверке уникальности идентификаторов
+                //
+                if (!_remainLinkedData) {
+                    usedUuids.insert(info->uuid());
+                }
+            }
+            //
+            // Для всех остальных блоков создаём структурку с данными о блоке
+            //
+            else {
+                TextBlockInfo* info = block.type == ScenarioBlockStyle::Character
+                                      ? new CharacterBlockInfo
+                                      : new TextBlockInfo;
+                cursor.block().setUserData(info);
             }
 
-            case QXmlStreamReader::Characters: {
-                if (!reader.isWhitespace()) {
-                    QString textToInsert = TextEditHelper::fromHtmlEscaped(reader.text().toString());
+            //
+            // Загружаем закладки, если установлены
+            //
+            if (block.attributes.hasAttribute(ATTRIBUTE_BOOKMARK)) {
+                TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(cursor.block().userData());
+                blockInfo->setHasBookmark(true);
+                blockInfo->setBookmark(block.attributes.value(ATTRIBUTE_BOOKMARK).toString());
+                blockInfo->setBookmarkColor(block.attributes.value(ATTRIBUTE_BOOKMARK_COLOR).toString());
+            }
 
-                    //
-                    // Пишем сам текст
-                    //
-                    cursor.insertText(textToInsert);
+            //
+            // Загружаем дифы, если заданы
+            //
+            if (block.attributes.hasAttribute(ATTRIBUTE_DIFF_ADDED)
+                || block.attributes.hasAttribute(ATTRIBUTE_DIFF_REMOVED)) {
+                TextBlockInfo* blockInfo = dynamic_cast<TextBlockInfo*>(cursor.block().userData());
+
+                if (block.attributes.hasAttribute(ATTRIBUTE_DIFF_ADDED)) {
+                    blockInfo->setDiffType(TextBlockInfo::kDiffAdded);
+                } else if (block.attributes.hasAttribute(ATTRIBUTE_DIFF_REMOVED)) {
+                    blockInfo->setDiffType(TextBlockInfo::kDiffRemoved);
                 }
-                break;
             }
 
-            default: {
-                break;
+            //
+            // Скрываем блоки, которых не должно быть видно в текщем режиме сценария
+            //
+            if (!visibleBlocksTypes.contains(block.type)) {
+                cursor.block().setVisible(false);
+            }
+        }
+
+        //
+        // Пишем текст блока целиком
+        //
+        if (!block.text.isEmpty()) {
+            cursor.insertText(block.text);
+        }
+
+        //
+        // Применяем редакторские заметки и форматирование
+        //
+        if (!block.formats.isEmpty()) {
+            const QTextBlock currentBlock = cursor.block();
+            int startDelta = 0;
+            if (currentBlock.position() < _position
+                && (currentBlock.position() + currentBlock.length()) > _position) {
+                startDelta = _position - currentBlock.position();
+            }
+            for (const XmlFormat& format : block.formats) {
+                QTextCursor formatCursor = cursor;
+                formatCursor.setPosition(currentBlock.position() + format.start + startDelta);
+                formatCursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, format.length);
+                formatCursor.mergeCharFormat(format.format);
             }
         }
     }
@@ -1900,21 +2014,19 @@ void ScenarioXml::xmlToScenarioV1(int _position, const QString& _xml, bool _rema
     cursor.endEditBlock();
 }
 
-bool ScenarioXml::isScenarioHaveUuid(const QString& _uuid) const
+QSet<QString> ScenarioXml::scenarioUuids() const
 {
+    QSet<QString> uuids;
     auto currentBlock = m_scenario->document()->begin();
     while (currentBlock.isValid()) {
         const ScenarioBlockStyle::Type currentBlockType = ScenarioBlockStyle::forBlock(currentBlock);
         if (currentBlockType == ScenarioBlockStyle::SceneHeading
             || currentBlockType == ScenarioBlockStyle::FolderHeader) {
             if (SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(currentBlock.userData())) {
-                if (info != nullptr
-                    && info->uuid() == _uuid) {
-                    return true;
-                }
+                uuids.insert(info->uuid());
             }
         }
         currentBlock = currentBlock.next();
     }
-    return false;
+    return uuids;
 }
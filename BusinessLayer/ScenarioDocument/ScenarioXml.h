@@ -1,9 +1,14 @@
 #ifndef SCENARIOXML_H
 #define SCENARIOXML_H
 
-#include <QCache>
+#include "ScenarioTemplate.h"
+
+#include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QTextBlock>
+#include <QTextLayout>
+#include <QVector>
 
 
 namespace BusinessLogic
@@ -33,6 +38,106 @@ namespace BusinessLogic
          */
         static QString makeMimeFromXml(const QString& _xml);
 
+        /**
+         * @brief Начало и окончание, которыми обрамляется xml блоков полного сценария
+         */
+        /** @{ */
+        static QString mimeHeader();
+        static QString mimeFooter();
+        /** @} */
+
+        /**
+         * @brief Разделить xml сценария на части для постепенной загрузки
+         * @param _firstPartBlocks - минимальное количество блоков в первой части
+         * @param _partBlocks - минимальное количество блоков в каждой из последующих частей
+         * @return Список xml частей, каждую из которых можно загрузить отдельно, или список
+         *         из исходного xml, если его не удалось разделить
+         * @note Таблицы не разделяются между частями
+         */
+        static QStringList splitXml(const QString& _xml, int _firstPartBlocks, int _partBlocks);
+
+    public:
+        /**
+         * @brief Состояние обработки таблиц при последовательном формировании xml блоков
+         */
+        struct TableState {
+            /**
+             * @brief Находимся ли внутри таблицы
+             */
+            bool isInTable = false;
+
+            /**
+             * @brief Началась ли вторая колонка таблицы
+             */
+            bool isSecondColumn = false;
+
+            bool operator==(const TableState& _other) const {
+                return isInTable == _other.isInTable
+                        && isSecondColumn == _other.isSecondColumn;
+            }
+            bool operator!=(const TableState& _other) const {
+                return !(*this == _other);
+            }
+        };
+
+        /**
+         * @brief Данные группы блоков, по которым формируется её xml
+         * @note Не ссылаются на документ, поэтому xml по ним можно формировать в другом потоке
+         */
+        struct BlockData {
+            /**
+             * @brief Тип первого блока группы
+             */
+            ScenarioBlockStyle::Type type = ScenarioBlockStyle::Undefined;
+
+            /**
+             * @brief Нужно ли записывать блок как элемент сценария
+             */
+            bool needWrite = true;
+
+            /**
+             * @brief Имя тэга элемента
+             */
+            QString nodeName;
+
+            /**
+             * @brief Находится ли блок внутри таблицы
+             */
+            bool isInTable = false;
+
+            /**
+             * @brief Разделитель колонок таблицы, предшествующий блоку
+             */
+            QString splitterXml;
+
+            /**
+             * @brief Текст блока и текст окончания разорванного абзаца, если оно было сшито
+             */
+            /** @{ */
+            QString text;
+            bool hasBreakEnd = false;
+            QString breakEndText;
+            /** @} */
+
+            /**
+             * @brief Атрибуты элемента: uuid, цвета, штамп, заголовок и закладка
+             */
+            /** @{ */
+            QString uuidColorsAndTitle;
+            QString bookmark;
+            /** @} */
+
+            /**
+             * @brief Форматы текста с редакторскими заметками и пользовательским форматированием
+             */
+            /** @{ */
+            bool hasReviewMarks = false;
+            QVector<QTextLayout::FormatRange> reviewRanges;
+            bool hasFormatting = false;
+            QVector<QTextLayout::FormatRange> formattingRanges;
+            /** @} */
+        };
+
     public:
         /**
          * @brief Конструктор фасада для работы с xml
@@ -47,6 +152,33 @@ namespace BusinessLogic
          */
         QString scenarioToXml();
 
+        /**
+         * @brief Сформировать xml блока, используется при формировании xml всего сценария
+         * @param _block - блок, с которого начинается формирование. Если блок разорван, то в xml
+         *        попадает и его продолжение, а по завершении _block указывает на последний
+         *        из обработанных блоков
+         * @param _state - состояние обработки таблиц, обновляется по ходу формирования
+         */
+        QString blockToXml(QTextBlock& _block, TableState& _state);
+
+        /**
+         * @brief Собрать данные группы блоков для формирования xml
+         * @note Параметры совпадают с параметрами blockToXml
+         */
+        BlockData blockData(QTextBlock& _block, TableState& _state);
+
+        /**
+         * @brief Сформировать xml по данным группы блоков
+         * @note Не обращается к документу, поэтому может вызываться из любого потока
+         */
+        static QString blockDataToXml(const BlockData& _data);
+
+        /**
+         * @brief Сформировать хэш блока, меняющийся при любом изменении, влияющем на его xml
+         * @note Используется, чтобы не формировать повторно xml неизменившихся блоков
+         */
+        static quint64 blockHash(const QTextBlock& _block);
+
         /**
          * @brief Записать сценарий в xml-строку из заданного диапазона текста
          */
@@ -65,6 +197,13 @@ namespace BusinessLogic
          */
         void xmlToScenario(int _position, const QString& _xml, bool _remainLinkedData = false);
 
+        /**
+         * @brief Дописать сценарий из xml в конец документа
+         * @note Каждый блок xml вставляется новым блоком документа, так же как при загрузке
+         *       сценария целиком, данные о сценах сохраняются
+         */
+        void appendXmlToScenario(const QString& _xml);
+
         /**
          * @brief Загрузить сценарий из xml после заданного элемента для его родителя
          * @return Позиция вставки
@@ -87,13 +226,14 @@ namespace BusinessLogic
 
         /**
          * @brief Преобразование xml-текста в сценарий (сценарий созданый с версии 0.5.3)
+         * @param _appendBlocks - вставлять ли первый блок xml новым блоком, а не в текущий
          */
-        void xmlToScenarioV1(int _position, const QString& _xml, bool _remainLinkedData);
+        void xmlToScenarioV1(int _position, const QString& _xml, bool _remainLinkedData, bool _appendBlocks = false);
 
         /**
-         * @brief Есть ли в документе элемент с таким идентификатором
+         * @brief Получить идентификаторы всех элементов документа
          */
-        bool isScenarioHaveUuid(const QString& _uuid) const;
+        QSet<QString> scenarioUuids() const;
 
     private:
         /**
@@ -108,12 +248,6 @@ namespace BusinessLogic
         int m_lastMimeFrom;
         int m_lastMimeTo;
         /** @} */
-
-        /**
-         * @brief Закешированное xml-содержимое блоков
-         * @note Используется, для ускорения формирования xml всего сценария
-         */
-        QCache<quint64, QString> m_xmlCache;
     };
 }
 
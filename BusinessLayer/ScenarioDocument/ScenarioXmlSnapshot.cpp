@@ -0,0 +1,1031 @@
+#include "ScenarioXmlSnapshot.h"
+
+#include "ScenarioTemplate.h"
+
+#include <3rd_party/Helpers/DiffMatchPatchHelper.h>
+#include <3rd_party/Helpers/TreapHelper.h>
+
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+using BusinessLogic::ScenarioBlockStyle;
+using BusinessLogic::ScenarioXml;
+using BusinessLogic::ScenarioXmlSnapshot;
+
+namespace {
+    /**
+     * @brief Модуль и основание полиномиального хэша
+     */
+    /** @{ */
+    const quint64 kHashModulo = (quint64(1) << 61) - 1;
+    const quint64 kHashBase = 1000003;
+    /** @} */
+
+    /**
+     * @brief Количество блоков, начиная с которого xml снимка формируется в нескольких потоках
+     */
+    const int kParallelXmlMinBlocks = 1000;
+
+    /**
+     * @brief Произведение по модулю 2^61 - 1 без использования 128-битной арифметики
+     */
+    static quint64 mulMod(quint64 _lhs, quint64 _rhs)
+    {
+        const quint64 lhsLow = quint32(_lhs);
+        const quint64 lhsHigh = _lhs >> 32;
+        const quint64 rhsLow = quint32(_rhs);
+        const quint64 rhsHigh = _rhs >> 32;
+        const quint64 low = lhsLow * rhsLow;
+        const quint64 middle = lhsLow * rhsHigh + rhsLow * lhsHigh;
+        const quint64 high = lhsHigh * rhsHigh;
+        quint64 result = (low & kHashModulo) + (low >> 61) + (high << 3) + (middle >> 29) + (middle << 35 >> 3) + 1;
+        result = (result & kHashModulo) + (result >> 61);
+        result = (result & kHashModulo) + (result >> 61);
+        return result - 1;
+    }
+
+    /**
+     * @brief Сумма по модулю 2^61 - 1
+     */
+    static quint64 addMod(quint64 _lhs, quint64 _rhs)
+    {
+        const quint64 result = _lhs + _rhs;
+        return result >= kHashModulo ? result - kHashModulo : result;
+    }
+
+    /**
+     * @brief Рассчитать хэш текста и основание в степени его длины
+     */
+    static void hashText(const QString& _text, quint64& _hash, quint64& _power)
+    {
+        _hash = 0;
+        _power = 1;
+        for (const QChar& character : _text) {
+            _hash = addMod(mulMod(_hash, kHashBase), quint64(character.unicode()) + 1);
+            _power = mulMod(_power, kHashBase);
+        }
+    }
+
+    /**
+     * @brief Является ли блок продолжением разорванного абзаца или декорацией
+     * @note Xml таких блоков зависит от предыдущих, поэтому их нельзя формировать отдельно
+     */
+    static bool isBreakContinuation(const QTextBlock& _block)
+    {
+        const QTextBlockFormat format = _block.blockFormat();
+        return format.boolProperty(ScenarioBlockStyle::PropertyIsCorrection)
+                || format.boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionEnd);
+    }
+
+    /**
+     * @brief Получить хэш блока, по которому можно использовать ранее сформированный xml,
+     *        или 0, если xml блока зависит от соседних блоков и должен формироваться заново
+     */
+    static quint64 reusableBlockHash(const QTextBlock& _block)
+    {
+        const QTextBlockFormat format = _block.blockFormat();
+        if (format.boolProperty(ScenarioBlockStyle::PropertyIsCorrection)
+            || format.boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionStart)
+            || format.boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionEnd)
+            || ScenarioBlockStyle::forBlock(_block) == ScenarioBlockStyle::PageSplitter) {
+            return 0;
+        }
+
+        return ScenarioXml::blockHash(_block);
+    }
+}
+
+struct ScenarioXmlSnapshot::Node
+{
+    Node* left = nullptr;
+    Node* right = nullptr;
+    quint32 priority = TreapHelper::nextPriority();
+
+    //
+    // Данные блока
+    //
+
+    /**
+     * @brief Xml блока, для блоков вошедших в группу разорванного абзаца пуст
+     */
+    QString xml;
+
+    /**
+     * @brief Хэш xml блока и основание в степени длины его xml
+     */
+    quint64 xmlHash = 0;
+    quint64 xmlPower = 1;
+
+    /**
+     * @brief Длина плоского текста, соответствующего xml блока
+     */
+    int xmlPlainSize = 0;
+
+    /**
+     * @brief Длина блока в документе
+     */
+    int blockLength = 0;
+
+    /**
+     * @brief Является ли блок продолжением группы, xml которой записан в предыдущем узле
+     */
+    bool isContinuation = false;
+
+    /**
+     * @brief Хэш блока, по которому был сформирован xml, или 0, если xml нельзя использовать
+     *        повторно без формирования
+     */
+    quint64 blockHash = 0;
+
+    /**
+     * @brief Состояние обработки таблиц перед блоком и после него
+     */
+    ScenarioXml::TableState stateBefore;
+    ScenarioXml::TableState state;
+
+    /**
+     * @brief Изменились ли данные блока, от которых зависит xml, после формирования узла
+     */
+    bool isDirty = false;
+
+    //
+    // Агрегированные значения поддерева
+    //
+
+    int count = 1;
+    int dirtyCount = 0;
+    int length = 0;
+    int xmlSize = 0;
+    int plainSize = 0;
+    quint64 hash = 0;
+    quint64 power = 1;
+};
+
+
+quint64 ScenarioXmlSnapshot::textHash(const QString& _text)
+{
+    quint64 hash = 0, power = 1;
+    hashText(_text, hash, power);
+    return hash;
+}
+
+ScenarioXmlSnapshot::ScenarioXmlSnapshot(QTextDocument* _document, ScenarioXml* _xmlHandler) :
+    m_document(_document),
+    m_xmlHandler(_xmlHandler),
+    m_header(ScenarioXml::mimeHeader()),
+    m_footer(ScenarioXml::mimeFooter())
+{
+    Q_ASSERT(m_document);
+
+    quint64 power = 1;
+    hashText(m_header, m_headerHash, power);
+    hashText(m_footer, m_footerHash, m_footerPower);
+}
+
+ScenarioXmlSnapshot::~ScenarioXmlSnapshot()
+{
+    destroy(m_root);
+}
+
+void ScenarioXmlSnapshot::rebuild()
+{
+    //
+    // Узлы прежнего снимка используем как кэш xml блоков с теми же порядковыми номерами
+    //
+    QVector<Node*> cachedNodes;
+    collect(m_root, cachedNodes);
+    m_root = nullptr;
+    m_isXmlActual = false;
+    m_isChangeKnown = false;
+    m_isFullValidationNeeded = false;
+
+    if (m_xmlHandler != nullptr) {
+        //
+        // Данные блоков собираем из документа последовательно, т.к. он не допускает
+        // одновременного обращения из нескольких потоков
+        //
+        QVector<Node*> nodes;
+        nodes.reserve(m_document->blockCount());
+        QVector<PendingNode> pendingNodes;
+        ScenarioXml::TableState state;
+        for (QTextBlock block = m_document->begin(); block.isValid(); block = block.next()) {
+            appendGroup(block, state, nodes, &cachedNodes, &pendingNodes);
+        }
+
+        //
+        // ... а xml по ним для большого документа формируем параллельно, порядок блоков
+        //     при этом определяется узлами, поэтому xml получается таким же, как и при
+        //     последовательном формировании
+        //
+        auto buildNodeXml = [] (PendingNode& _pendingNode) {
+            setNodeXml(_pendingNode.first, ScenarioXml::blockDataToXml(_pendingNode.second));
+        };
+        if (pendingNodes.size() >= kParallelXmlMinBlocks) {
+            QtConcurrent::blockingMap(pendingNodes, buildNodeXml);
+        } else {
+            std::for_each(pendingNodes.begin(), pendingNodes.end(), buildNodeXml);
+        }
+
+        m_root = build(nodes);
+    }
+
+    //
+    // Удаляем узлы, которые не пригодились
+    //
+    qDeleteAll(cachedNodes);
+}
+
+void ScenarioXmlSnapshot::update(int _position, int _charsRemoved, int _charsAdded)
+{
+    if (m_root == nullptr
+        || _position < 0) {
+        rebuild();
+        return;
+    }
+
+    //
+    // Определим диапазон затронутых изменением блоков в снимке
+    //
+    const int lastSnapshotPosition = m_root->length - 1;
+    int firstIndex = indexAtPosition(qMin(_position, lastSnapshotPosition));
+    const int lastIndex = indexAtPosition(qMin(_position + _charsRemoved, lastSnapshotPosition));
+    //
+    // ... и в документе
+    //
+    const int lastDocumentPosition = m_document->characterCount() - 1;
+    QTextBlock firstBlock = m_document->findBlock(qMin(_position, lastDocumentPosition));
+    const QTextBlock lastBlock = m_document->findBlock(qMin(_position + _charsAdded, lastDocumentPosition));
+    //
+    // ... блоки до позиции изменения должны совпадать, в противном случае снимок
+    //     не соответствует документу и его нужно сформировать заново
+    //
+    if (!firstBlock.isValid()
+        || !lastBlock.isValid()
+        || firstBlock.blockNumber() != firstIndex) {
+        rebuild();
+        return;
+    }
+
+    //
+    // Если изменение затронуло продолжение разорванного абзаца, то формировать xml нужно
+    // начиная с первого блока абзаца
+    //
+    while (firstIndex > 0
+           && (nodeAt(firstIndex)->isContinuation
+               || isBreakContinuation(firstBlock))) {
+        --firstIndex;
+        firstBlock = firstBlock.previous();
+    }
+
+    //
+    // Формируем xml изменившихся блоков
+    //
+    ScenarioXml::TableState state = firstIndex > 0
+                                    ? nodeAt(firstIndex - 1)->state
+                                    : ScenarioXml::TableState();
+    const int lastBlockNumber = lastBlock.blockNumber();
+    const int nodesCount = m_root->count;
+    QVector<Node*> nodes;
+    int blockNumber = firstIndex;
+    int replaceToIndex = lastIndex;
+    QTextBlock block = firstBlock;
+    forever {
+        blockNumber += appendGroup(block, state, nodes);
+
+        //
+        // Если дошли до конца документа, то заменяем и все оставшиеся узлы
+        //
+        block = block.next();
+        if (!block.isValid()) {
+            replaceToIndex = nodesCount - 1;
+            break;
+        }
+
+        //
+        // Блоки после изменённого диапазона не изменились и соответствуют узлам снимка
+        // со смещением, поэтому продолжаем формирование только до тех пор, пока состояние
+        // обработки таблиц или разорванный абзац отличаются от сохранённых в снимке
+        //
+        if (blockNumber > lastBlockNumber) {
+            replaceToIndex = lastIndex + (blockNumber - 1 - lastBlockNumber);
+            if (replaceToIndex >= nodesCount - 1
+                || (nodeAt(replaceToIndex)->state == state
+                    && !nodeAt(replaceToIndex + 1)->isContinuation
+                    && !isBreakContinuation(block))) {
+                break;
+            }
+        }
+    }
+
+    //
+    // Заменяем узлы изменившихся блоков
+    //
+    Node* left = nullptr;
+    Node* middle = nullptr;
+    Node* right = nullptr;
+    split(m_root, firstIndex, left, right);
+    const int replacedCount = qMin(replaceToIndex, nodesCount - 1) - firstIndex + 1;
+    split(right, replacedCount, middle, right);
+    destroy(middle);
+    markChanged(firstIndex, replacedCount, nodes.size());
+    m_root = merge(merge(left, build(nodes)), right);
+    m_isXmlActual = false;
+
+    //
+    // Если после обновления снимок не соответствует документу, формируем его заново
+    //
+    if (m_root == nullptr
+        || m_root->count != m_document->blockCount()
+        || m_root->length != m_document->characterCount()) {
+        rebuild();
+    }
+}
+
+void ScenarioXmlSnapshot::markBlockChanged(const QTextBlock& _block)
+{
+    if (m_root == nullptr
+        || !_block.isValid()) {
+        return;
+    }
+
+    //
+    // Пока изменение документа не завершено, порядковые номера блоков могут не соответствовать
+    // узлам снимка, в таком случае при проверке сверяем весь документ.
+    // NOTE: если количество блоков не изменилось, то блоки вне изменяемого диапазона сохраняют
+    //       свои номера, а узлы блоков внутри него будут сформированы заново при обновлении
+    //
+    if (m_root->count != m_document->blockCount()
+        || m_root->length != m_document->characterCount()) {
+        m_isFullValidationNeeded = true;
+        return;
+    }
+
+    markDirty(m_root, _block.blockNumber());
+}
+
+bool ScenarioXmlSnapshot::isValidationNeeded() const
+{
+    return m_isFullValidationNeeded
+            || (m_root != nullptr && m_root->dirtyCount > 0);
+}
+
+void ScenarioXmlSnapshot::validate()
+{
+    if (m_xmlHandler == nullptr) {
+        return;
+    }
+
+    if (m_root == nullptr
+        || m_root->count != m_document->blockCount()
+        || m_root->length != m_document->characterCount()) {
+        rebuild();
+        return;
+    }
+
+    if (m_isFullValidationNeeded) {
+        m_isFullValidationNeeded = false;
+        validateAll();
+        return;
+    }
+
+    //
+    // Формируем заново xml только тех групп блоков, данные которых изменились
+    //
+    while (m_root != nullptr
+           && m_root->dirtyCount > 0) {
+        const QTextBlock block = m_document->findBlockByNumber(firstDirtyIndex());
+        update(block.position(), 0, 0);
+    }
+
+#ifndef QT_NO_DEBUG
+    //
+    // В отладочной сборке сверяем весь документ, чтобы обнаружить изменения данных блоков,
+    // о которых снимок не был уведомлён
+    //
+    const bool hasMissedChanges = validateAll();
+    Q_ASSERT_X(!hasMissedChanges, Q_FUNC_INFO, "Block data changed without notifying the xml snapshot");
+#endif
+}
+
+bool ScenarioXmlSnapshot::validateAll()
+{
+    if (m_root == nullptr
+        || m_root->count != m_document->blockCount()
+        || m_root->length != m_document->characterCount()) {
+        rebuild();
+        return true;
+    }
+
+    QVector<Node*> nodes;
+    nodes.reserve(m_root->count);
+    collect(m_root, nodes);
+
+    //
+    // Все блоки сверяются с документом, поэтому отметки об изменении данных больше не нужны
+    //
+    const bool hasDirtyNodes = m_root->dirtyCount > 0;
+    for (Node* node : nodes) {
+        node->isDirty = false;
+    }
+
+    bool isChanged = false;
+    int index = 0;
+    ScenarioXml::TableState state;
+    for (QTextBlock block = m_document->begin(); block.isValid(); block = block.next()) {
+        //
+        // Если изменилась структура групп блоков, то снимок нужно сформировать заново
+        //
+        const int nodeIndex = index;
+        Node* node = index < nodes.size() ? nodes.at(index) : nullptr;
+        if (node == nullptr
+            || node->isContinuation
+            || node->blockLength != block.length()) {
+            rebuild();
+            return true;
+        }
+        ++index;
+
+        //
+        // Xml блока, не изменившегося с момента его формирования, не формируем повторно
+        //
+        const quint64 blockHash = reusableBlockHash(block);
+        if (blockHash != 0
+            && node->blockHash == blockHash
+            && node->stateBefore == state) {
+            state = node->state;
+            continue;
+        }
+
+        QTextBlock groupBlock = block;
+        node->stateBefore = state;
+        const QString xml = m_xmlHandler->blockToXml(block, state);
+        while (groupBlock != block) {
+            groupBlock = groupBlock.next();
+            if (!groupBlock.isValid()) {
+                break;
+            }
+
+            Node* continuationNode = index < nodes.size() ? nodes.at(index) : nullptr;
+            if (continuationNode == nullptr
+                || !continuationNode->isContinuation
+                || continuationNode->blockLength != groupBlock.length()) {
+                rebuild();
+                return true;
+            }
+            continuationNode->state = state;
+            ++index;
+        }
+
+        //
+        // Обновляем xml блока, если он изменился
+        //
+        node->blockHash = blockHash;
+        node->state = state;
+        if (node->xml != xml) {
+            setNodeXml(node, xml);
+            markChanged(nodeIndex, 1, 1);
+            isChanged = true;
+        }
+    }
+
+    if (index != nodes.size()) {
+        rebuild();
+        return true;
+    }
+
+    if (isChanged
+        || hasDirtyNodes) {
+        pullSubtree(m_root);
+    }
+    if (isChanged) {
+        m_isXmlActual = false;
+    }
+    return isChanged;
+}
+
+void ScenarioXmlSnapshot::markSaved()
+{
+    m_isChangeKnown = true;
+    m_changedFrom = 0;
+    m_changedTo = -1;
+}
+
+bool ScenarioXmlSnapshot::changeSinceSaved(int _contextLength, Change& _change)
+{
+    if (!m_isChangeKnown
+        || m_root == nullptr
+        || m_changedFrom > m_changedTo) {
+        return false;
+    }
+
+    //
+    // Расширяем фрагмент неизменными блоками, чтобы в патч попал контекст изменения
+    //
+    int from = m_changedFrom;
+    int to = qMin(m_changedTo, m_root->count - 1);
+    expandRange(from, to, _contextLength);
+
+    //
+    // Собираем xml фрагмента и определяем его положение
+    //
+    Node* left = nullptr;
+    Node* middle = nullptr;
+    Node* right = nullptr;
+    split(m_root, from, left, right);
+    split(right, to - from + 1, middle, right);
+
+    _change.xmlPosition = m_header.size() + (left != nullptr ? left->xmlSize : 0);
+    _change.xmlTailSize = (right != nullptr ? right->xmlSize : 0) + m_footer.size();
+    _change.plainPosition = left != nullptr ? left->plainSize : 0;
+    _change.xml.clear();
+    _change.xml.reserve(middle != nullptr ? middle->xmlSize : 0);
+    appendXml(middle, _change.xml);
+
+    m_root = merge(merge(left, middle), right);
+    return true;
+}
+
+bool ScenarioXmlSnapshot::fragment(int _plainFrom, int _plainTo, int _contextLength, Fragment& _fragment) const
+{
+    if (m_root == nullptr
+        || _plainFrom < 0
+        || _plainFrom > _plainTo
+        || _plainTo > m_root->plainSize) {
+        return false;
+    }
+
+    //
+    // Определим узлы, в которые входит диапазон, и расширим их контекстом
+    //
+    int from = indexAtPlainPosition(_plainFrom);
+    int to = indexAtPlainPosition(qMax(_plainFrom, _plainTo - 1));
+    expandRange(from, to, _contextLength);
+    collectFragment(from, to, _fragment);
+    return true;
+}
+
+bool ScenarioXmlSnapshot::xmlFragment(int _xmlFrom, int _xmlTo, Fragment& _fragment) const
+{
+    if (m_root == nullptr) {
+        return false;
+    }
+
+    //
+    // Переводим диапазон в позиции xml блоков, отбрасывая обрамление
+    //
+    const int from = qMax(_xmlFrom - m_header.size(), 0);
+    const int to = qMin(_xmlTo - m_header.size(), m_root->xmlSize);
+    if (from >= to) {
+        return false;
+    }
+
+    collectFragment(indexAtXmlPosition(from), indexAtXmlPosition(to - 1), _fragment);
+    return true;
+}
+
+quint64 ScenarioXmlSnapshot::hash() const
+{
+    quint64 hash = m_headerHash;
+    if (m_root != nullptr) {
+        hash = addMod(mulMod(hash, m_root->power), m_root->hash);
+    }
+    return addMod(mulMod(hash, m_footerPower), m_footerHash);
+}
+
+QString ScenarioXmlSnapshot::xml() const
+{
+    if (!m_isXmlActual) {
+        QString xml;
+        xml.reserve(m_header.size() + (m_root != nullptr ? m_root->xmlSize : 0) + m_footer.size());
+        xml.append(m_header);
+        appendXml(m_root, xml);
+        xml.append(m_footer);
+
+        m_xml = xml;
+        m_isXmlActual = true;
+    }
+
+    return m_xml;
+}
+
+int ScenarioXmlSnapshot::appendGroup(QTextBlock& _block, ScenarioXml::TableState& _state, QVector<Node*>& _nodes,
+    QVector<Node*>* _cachedNodes, QVector<PendingNode>* _pendingNodes)
+{
+    //
+    // Если блок не изменился с момента формирования узла с тем же порядковым номером,
+    // то используем этот узел, забирая его из кэша
+    //
+    const quint64 blockHash = reusableBlockHash(_block);
+    const int index = _nodes.size();
+    if (blockHash != 0
+        && _cachedNodes != nullptr
+        && index < _cachedNodes->size()) {
+        Node* cachedNode = _cachedNodes->at(index);
+        if (cachedNode != nullptr
+            && !cachedNode->isDirty
+            && cachedNode->blockHash == blockHash
+            && cachedNode->stateBefore == _state
+            && cachedNode->blockLength == _block.length()) {
+            (*_cachedNodes)[index] = nullptr;
+            _state = cachedNode->state;
+            _nodes.append(cachedNode);
+            return 1;
+        }
+    }
+
+    QTextBlock groupBlock = _block;
+
+    Node* node = new Node;
+    node->blockHash = blockHash;
+    node->stateBefore = _state;
+    if (_pendingNodes != nullptr) {
+        _pendingNodes->append(PendingNode(node, m_xmlHandler->blockData(_block, _state)));
+    } else {
+        setNodeXml(node, m_xmlHandler->blockToXml(_block, _state));
+    }
+    node->blockLength = groupBlock.length();
+    node->state = _state;
+    _nodes.append(node);
+
+    //
+    // Для блоков, xml которых был сформирован вместе с первым, добавляем пустые узлы
+    //
+    int blocksCount = 1;
+    while (groupBlock != _block) {
+        groupBlock = groupBlock.next();
+        if (!groupBlock.isValid()) {
+            break;
+        }
+
+        Node* continuationNode = new Node;
+        continuationNode->blockLength = groupBlock.length();
+        continuationNode->isContinuation = true;
+        continuationNode->stateBefore = _state;
+        continuationNode->state = _state;
+        _nodes.append(continuationNode);
+        ++blocksCount;
+    }
+
+    return blocksCount;
+}
+
+void ScenarioXmlSnapshot::setNodeXml(Node* _node, const QString& _xml)
+{
+    _node->xml = _xml;
+    hashText(_node->xml, _node->xmlHash, _node->xmlPower);
+    _node->xmlPlainSize = DiffMatchPatchHelper::plainLength(_node->xml);
+}
+
+void ScenarioXmlSnapshot::markChanged(int _index, int _removed, int _added)
+{
+    const int lastAdded = _index + _added - 1;
+    if (m_changedFrom > m_changedTo) {
+        m_changedFrom = _index;
+        m_changedTo = lastAdded;
+        return;
+    }
+
+    //
+    // Узлы после заменённых сдвигаются, а заменённые целиком входят в изменённый диапазон
+    //
+    m_changedFrom = qMin(m_changedFrom, _index);
+    if (m_changedTo >= _index + _removed) {
+        m_changedTo += _added - _removed;
+    } else {
+        m_changedTo = qMax(m_changedTo, lastAdded);
+    }
+}
+
+void ScenarioXmlSnapshot::expandRange(int& _from, int& _to, int _contextLength) const
+{
+    for (int context = 0; _from > 0 && context < _contextLength; ) {
+        --_from;
+        context += nodeAt(_from)->xmlPlainSize;
+    }
+    for (int context = 0; _to < m_root->count - 1 && context < _contextLength; ) {
+        ++_to;
+        context += nodeAt(_to)->xmlPlainSize;
+    }
+}
+
+void ScenarioXmlSnapshot::collectFragment(int _from, int _to, Fragment& _fragment) const
+{
+    //
+    // Фрагмент должен состоять из целых групп блоков
+    //
+    while (_from > 0
+           && nodeAt(_from)->isContinuation) {
+        --_from;
+    }
+    while (_to < m_root->count - 1
+           && nodeAt(_to + 1)->isContinuation) {
+        ++_to;
+    }
+
+    //
+    // Собираем группы блоков фрагмента
+    //
+    int position = 0;
+    lengthsBefore(_from, position, _fragment.xmlPosition, _fragment.plainPosition);
+    _fragment.xmlPosition += m_header.size();
+    _fragment.parts.clear();
+    for (int index = _from; index <= _to; ++index) {
+        const Node* node = nodeAt(index);
+        if (!node->isContinuation
+            || _fragment.parts.isEmpty()) {
+            Fragment::Part part;
+            part.xml = node->xml;
+            part.position = position;
+            _fragment.parts.append(part);
+        }
+        _fragment.parts.last().length += node->blockLength;
+        position += node->blockLength;
+    }
+}
+
+int ScenarioXmlSnapshot::firstDirtyIndex() const
+{
+    int index = 0;
+    Node* node = m_root;
+    while (node != nullptr) {
+        const int leftCount = node->left != nullptr ? node->left->count : 0;
+        if (node->left != nullptr
+            && node->left->dirtyCount > 0) {
+            node = node->left;
+        } else if (node->isDirty) {
+            return index + leftCount;
+        } else {
+            index += leftCount + 1;
+            node = node->right;
+        }
+    }
+    return -1;
+}
+
+ScenarioXmlSnapshot::Node* ScenarioXmlSnapshot::nodeAt(int _index) const
+{
+    Node* node = m_root;
+    while (node != nullptr) {
+        const int leftCount = node->left != nullptr ? node->left->count : 0;
+        if (_index < leftCount) {
+            node = node->left;
+        } else if (_index == leftCount) {
+            break;
+        } else {
+            _index -= leftCount + 1;
+            node = node->right;
+        }
+    }
+    return node;
+}
+
+int ScenarioXmlSnapshot::indexAtPosition(int _position) const
+{
+    int index = 0;
+    Node* node = m_root;
+    while (node != nullptr) {
+        const int leftCount = node->left != nullptr ? node->left->count : 0;
+        const int leftLength = node->left != nullptr ? node->left->length : 0;
+        if (_position < leftLength) {
+            node = node->left;
+        } else if (_position < leftLength + node->blockLength) {
+            return index + leftCount;
+        } else {
+            _position -= leftLength + node->blockLength;
+            index += leftCount + 1;
+            node = node->right;
+        }
+    }
+    return qMax(0, index - 1);
+}
+
+int ScenarioXmlSnapshot::indexAtPlainPosition(int _plainPosition) const
+{
+    int index = 0;
+    Node* node = m_root;
+    while (node != nullptr) {
+        const int leftCount = node->left != nullptr ? node->left->count : 0;
+        const int leftPlainSize = node->left != nullptr ? node->left->plainSize : 0;
+        if (_plainPosition < leftPlainSize) {
+            node = node->left;
+        } else if (_plainPosition < leftPlainSize + node->xmlPlainSize) {
+            return index + leftCount;
+        } else {
+            _plainPosition -= leftPlainSize + node->xmlPlainSize;
+            index += leftCount + 1;
+            node = node->right;
+        }
+    }
+    return qMax(0, index - 1);
+}
+
+int ScenarioXmlSnapshot::indexAtXmlPosition(int _xmlPosition) const
+{
+    int index = 0;
+    Node* node = m_root;
+    while (node != nullptr) {
+        const int leftCount = node->left != nullptr ? node->left->count : 0;
+        const int leftXmlSize = node->left != nullptr ? node->left->xmlSize : 0;
+        if (_xmlPosition < leftXmlSize) {
+            node = node->left;
+        } else if (_xmlPosition < leftXmlSize + node->xml.size()) {
+            return index + leftCount;
+        } else {
+            _xmlPosition -= leftXmlSize + node->xml.size();
+            index += leftCount + 1;
+            node = node->right;
+        }
+    }
+    return qMax(0, index - 1);
+}
+
+void ScenarioXmlSnapshot::lengthsBefore(int _index, int& _length, int& _xmlSize, int& _plainSize) const
+{
+    _length = 0;
+    _xmlSize = 0;
+    _plainSize = 0;
+    Node* node = m_root;
+    while (node != nullptr) {
+        const int leftCount = node->left != nullptr ? node->left->count : 0;
+        if (_index <= leftCount) {
+            node = node->left;
+            continue;
+        }
+
+        if (Node* left = node->left) {
+            _length += left->length;
+            _xmlSize += left->xmlSize;
+            _plainSize += left->plainSize;
+        }
+        _length += node->blockLength;
+        _xmlSize += node->xml.size();
+        _plainSize += node->xmlPlainSize;
+        _index -= leftCount + 1;
+        node = node->right;
+    }
+}
+
+void ScenarioXmlSnapshot::pull(Node* _node)
+{
+    _node->count = 1;
+    _node->dirtyCount = _node->isDirty ? 1 : 0;
+    _node->length = _node->blockLength;
+    _node->xmlSize = _node->xml.size();
+    _node->plainSize = _node->xmlPlainSize;
+    _node->hash = _node->xmlHash;
+    _node->power = _node->xmlPower;
+
+    if (Node* left = _node->left) {
+        _node->count += left->count;
+        _node->dirtyCount += left->dirtyCount;
+        _node->length += left->length;
+        _node->xmlSize += left->xmlSize;
+        _node->plainSize += left->plainSize;
+        _node->hash = addMod(mulMod(left->hash, _node->power), _node->hash);
+        _node->power = mulMod(left->power, _node->power);
+    }
+
+    if (Node* right = _node->right) {
+        _node->count += right->count;
+        _node->dirtyCount += right->dirtyCount;
+        _node->length += right->length;
+        _node->xmlSize += right->xmlSize;
+        _node->plainSize += right->plainSize;
+        _node->hash = addMod(mulMod(_node->hash, right->power), right->hash);
+        _node->power = mulMod(_node->power, right->power);
+    }
+}
+
+void ScenarioXmlSnapshot::pullSubtree(Node* _node)
+{
+    if (_node == nullptr) {
+        return;
+    }
+
+    pullSubtree(_node->left);
+    pullSubtree(_node->right);
+    pull(_node);
+}
+
+ScenarioXmlSnapshot::Node* ScenarioXmlSnapshot::build(const QVector<Node*>& _nodes)
+{
+    //
+    // Строим дерево за линейное время, поддерживая правую ветвь
+    //
+    QVector<Node*> rightBranch;
+    for (Node* node : _nodes) {
+        Node* lastRemoved = nullptr;
+        while (!rightBranch.isEmpty()
+               && rightBranch.last()->priority < node->priority) {
+            lastRemoved = rightBranch.takeLast();
+        }
+        node->left = lastRemoved;
+        node->right = nullptr;
+        if (!rightBranch.isEmpty()) {
+            rightBranch.last()->right = node;
+        }
+        rightBranch.append(node);
+    }
+
+    Node* root = rightBranch.isEmpty() ? nullptr : rightBranch.first();
+    pullSubtree(root);
+    return root;
+}
+
+ScenarioXmlSnapshot::Node* ScenarioXmlSnapshot::merge(Node* _left, Node* _right)
+{
+    if (_left == nullptr) {
+        return _right;
+    }
+    if (_right == nullptr) {
+        return _left;
+    }
+
+    if (_left->priority > _right->priority) {
+        _left->right = merge(_left->right, _right);
+        pull(_left);
+        return _left;
+    }
+
+    _right->left = merge(_left, _right->left);
+    pull(_right);
+    return _right;
+}
+
+void ScenarioXmlSnapshot::split(Node* _node, int _count, Node*& _left, Node*& _right)
+{
+    if (_node == nullptr) {
+        _left = nullptr;
+        _right = nullptr;
+        return;
+    }
+
+    const int leftCount = _node->left != nullptr ? _node->left->count : 0;
+    if (_count <= leftCount) {
+        split(_node->left, _count, _left, _node->left);
+        _right = _node;
+    } else {
+        split(_node->right, _count - leftCount - 1, _node->right, _right);
+        _left = _node;
+    }
+    pull(_node);
+}
+
+bool ScenarioXmlSnapshot::markDirty(Node* _node, int _index)
+{
+    if (_node == nullptr) {
+        return false;
+    }
+
+    bool isMarked = false;
+    const int leftCount = _node->left != nullptr ? _node->left->count : 0;
+    if (_index < leftCount) {
+        isMarked = markDirty(_node->left, _index);
+    } else if (_index == leftCount) {
+        isMarked = !_node->isDirty;
+        _node->isDirty = true;
+    } else {
+        isMarked = markDirty(_node->right, _index - leftCount - 1);
+    }
+
+    if (isMarked) {
+        ++_node->dirtyCount;
+    }
+    return isMarked;
+}
+
+void ScenarioXmlSnapshot::collect(Node* _node, QVector<Node*>& _nodes)
+{
+    if (_node == nullptr) {
+        return;
+    }
+
+    collect(_node->left, _nodes);
+    _nodes.append(_node);
+    collect(_node->right, _nodes);
+}
+
+void ScenarioXmlSnapshot::appendXml(const Node* _node, QString& _xml)
+{
+    if (_node == nullptr) {
+        return;
+    }
+
+    appendXml(_node->left, _xml);
+    _xml.append(_node->xml);
+    appendXml(_node->right, _xml);
+}
+
+void ScenarioXmlSnapshot::destroy(Node* _node)
+{
+    if (_node == nullptr) {
+        return;
+    }
+
+    destroy(_node->left);
+    destroy(_node->right);
+    delete _node;
+}
@@ -0,0 +1,325 @@
+#ifndef SCENARIOXMLSNAPSHOT_H
+#define SCENARIOXMLSNAPSHOT_H
+
+#include "ScenarioXml.h"
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class QTextBlock;
+class QTextDocument;
+
+
+namespace BusinessLogic
+{
+    /**
+     * @brief Снимок xml сценария, собранный из xml отдельных блоков
+     *
+     * Xml блоков хранится в декартовом дереве по неявному ключу (порядковому номеру блока),
+     * каждый узел которого содержит длину блока в документе и полиномиальный хэш своего xml,
+     * а также агрегированные значения для поддерева. Это позволяет при изменении текста
+     * переформировать xml только затронутых блоков и пересчитать хэш всего сценария за
+     * логарифмическое время, а строку с полным xml собирать лишь тогда, когда она нужна
+     */
+    class ScenarioXmlSnapshot
+    {
+    public:
+        /**
+         * @brief Фрагмент xml, изменившийся с момента последнего сохранения
+         */
+        struct Change {
+            /**
+             * @brief Позиция фрагмента в xml, одинаковая для сохранённого и текущего xml
+             */
+            int xmlPosition = 0;
+
+            /**
+             * @brief Длина неизменной части xml после фрагмента
+             */
+            int xmlTailSize = 0;
+
+            /**
+             * @brief Позиция фрагмента в плоском тексте, без xml-тэгов
+             */
+            int plainPosition = 0;
+
+            /**
+             * @brief Текущий xml фрагмента
+             */
+            QString xml;
+        };
+
+        /**
+         * @brief Фрагмент документа из целых групп блоков
+         */
+        struct Fragment {
+            /**
+             * @brief Группа блоков, xml которой формируется целиком
+             */
+            struct Part {
+                /**
+                 * @brief Xml группы
+                 */
+                QString xml;
+
+                /**
+                 * @brief Позиция группы в документе
+                 */
+                int position = 0;
+
+                /**
+                 * @brief Длина группы в документе, включая перенос строки после последнего блока
+                 */
+                int length = 0;
+            };
+
+            /**
+             * @brief Позиция фрагмента в xml сценария
+             */
+            int xmlPosition = 0;
+
+            /**
+             * @brief Позиция фрагмента в плоском тексте, без xml-тэгов
+             */
+            int plainPosition = 0;
+
+            /**
+             * @brief Группы блоков фрагмента
+             */
+            QVector<Part> parts;
+        };
+
+        /**
+         * @brief Рассчитать хэш текста
+         * @note Для одинакового текста совпадает с хэшем снимка
+         */
+        static quint64 textHash(const QString& _text);
+
+    public:
+        ScenarioXmlSnapshot(QTextDocument* _document, ScenarioXml* _xmlHandler);
+        ~ScenarioXmlSnapshot();
+
+        /**
+         * @brief Сформировать снимок по всему документу
+         */
+        void rebuild();
+
+        /**
+         * @brief Обновить снимок после изменения текста документа
+         * @note Параметры соответствуют сигналу QTextDocument::contentsChange
+         */
+        void update(int _position, int _charsRemoved, int _charsAdded);
+
+        /**
+         * @brief Отметить блок, данные которого изменились без изменения текста документа
+         *        (например пользовательские данные блока), его xml будет сформирован при проверке
+         */
+        void markBlockChanged(const QTextBlock& _block);
+
+        /**
+         * @brief Есть ли блоки, изменившиеся без изменения текста документа
+         */
+        bool isValidationNeeded() const;
+
+        /**
+         * @brief Обновить xml блоков, отмеченных как изменившиеся
+         * @note В отладочной сборке дополнительно сверяет снимок со всем документом
+         */
+        void validate();
+
+        /**
+         * @brief Отметить текущее состояние снимка как сохранённое
+         */
+        void markSaved();
+
+        /**
+         * @brief Получить фрагмент xml, изменившийся с момента отметки сохранения
+         * @param _contextLength - минимальная длина неизменного плоского текста,
+         *        добавляемого к фрагменту с каждой стороны
+         * @return Удалось ли определить фрагмент, это невозможно, если с момента отметки
+         *         снимок формировался заново
+         */
+        bool changeSinceSaved(int _contextLength, Change& _change);
+
+        /**
+         * @brief Получить фрагмент документа, включающий заданный диапазон плоского текста
+         * @param _contextLength - минимальная длина плоского текста, добавляемого к фрагменту
+         *        с каждой стороны
+         * @return Удалось ли определить фрагмент
+         */
+        bool fragment(int _plainFrom, int _plainTo, int _contextLength, Fragment& _fragment) const;
+
+        /**
+         * @brief Получить фрагмент документа, включающий заданный диапазон xml сценария
+         * @note Части диапазона, попадающие в обрамление xml, не учитываются
+         * @return Удалось ли определить фрагмент, это невозможно, если диапазон целиком
+         *         находится в обрамлении xml
+         */
+        bool xmlFragment(int _xmlFrom, int _xmlTo, Fragment& _fragment) const;
+
+        /**
+         * @brief Хэш xml сценария
+         */
+        quint64 hash() const;
+
+        /**
+         * @brief Xml сценария
+         */
+        QString xml() const;
+
+    private:
+        /**
+         * @brief Узел дерева
+         */
+        struct Node;
+
+        /**
+         * @brief Узел и данные блоков, по которым нужно сформировать его xml
+         */
+        using PendingNode = QPair<Node*, ScenarioXml::BlockData>;
+
+        /**
+         * @brief Сформировать узлы для группы блоков, начинающейся с заданного
+         * @param _cachedNodes - узлы прежнего снимка, узел блока с тем же порядковым номером
+         *        используется вместо формирования нового, если блок с тех пор не изменился
+         * @param _pendingNodes - если задан, то xml узла не формируется, а узел вместе с данными
+         *        блоков добавляется в этот список
+         * @return Количество блоков вошедших в группу
+         */
+        int appendGroup(QTextBlock& _block, ScenarioXml::TableState& _state, QVector<Node*>& _nodes,
+            QVector<Node*>* _cachedNodes = nullptr, QVector<PendingNode>* _pendingNodes = nullptr);
+
+        /**
+         * @brief Сверить снимок со всем документом и обновить блоки, xml которых изменился
+         * @return Изменился ли xml хотя бы одного блока
+         */
+        bool validateAll();
+
+        /**
+         * @brief Задать xml узла, рассчитав его хэш и длину плоского текста
+         */
+        static void setNodeXml(Node* _node, const QString& _xml);
+
+        /**
+         * @brief Расширить диапазон изменённых узлов с учётом замены узлов
+         * @param _index - порядковый номер первого заменённого узла
+         * @param _removed - количество удалённых узлов
+         * @param _added - количество добавленных узлов
+         */
+        void markChanged(int _index, int _removed, int _added);
+
+        /**
+         * @brief Расширить диапазон узлов соседними узлами, чтобы с каждой стороны было
+         *        не меньше заданной длины плоского текста
+         */
+        void expandRange(int& _from, int& _to, int _contextLength) const;
+
+        /**
+         * @brief Собрать фрагмент из целых групп блоков, включающий заданные узлы
+         */
+        void collectFragment(int _from, int _to, Fragment& _fragment) const;
+
+        /**
+         * @brief Получить порядковый номер первого отмеченного как изменившийся узла или -1
+         */
+        int firstDirtyIndex() const;
+
+        /**
+         * @brief Получить узел по порядковому номеру блока
+         */
+        Node* nodeAt(int _index) const;
+
+        /**
+         * @brief Получить порядковый номер блока, в который входит заданная позиция
+         */
+        int indexAtPosition(int _position) const;
+
+        /**
+         * @brief Получить порядковый номер узла, в который входит заданная позиция плоского текста
+         */
+        int indexAtPlainPosition(int _plainPosition) const;
+
+        /**
+         * @brief Получить порядковый номер узла, в xml которого входит заданная позиция
+         * @note Позиция отсчитывается от начала xml блоков, без обрамления
+         */
+        int indexAtXmlPosition(int _xmlPosition) const;
+
+        /**
+         * @brief Получить длину в документе, длину xml и длину плоского текста блоков
+         *        перед заданным узлом
+         */
+        void lengthsBefore(int _index, int& _length, int& _xmlSize, int& _plainSize) const;
+
+        /**
+         * @brief Операции с деревом
+         */
+        /** @{ */
+        static void pull(Node* _node);
+        static void pullSubtree(Node* _node);
+        static Node* build(const QVector<Node*>& _nodes);
+        static Node* merge(Node* _left, Node* _right);
+        static void split(Node* _node, int _count, Node*& _left, Node*& _right);
+        static bool markDirty(Node* _node, int _index);
+        static void collect(Node* _node, QVector<Node*>& _nodes);
+        static void appendXml(const Node* _node, QString& _xml);
+        static void destroy(Node* _node);
+        /** @} */
+
+    private:
+        /**
+         * @brief Документ, для которого формируется снимок
+         */
+        QTextDocument* m_document = nullptr;
+
+        /**
+         * @brief Обработчик xml
+         */
+        ScenarioXml* m_xmlHandler = nullptr;
+
+        /**
+         * @brief Корень дерева
+         */
+        Node* m_root = nullptr;
+
+        /**
+         * @brief Обрамление xml сценария и его хэши
+         */
+        /** @{ */
+        QString m_header;
+        quint64 m_headerHash = 0;
+        QString m_footer;
+        quint64 m_footerHash = 0;
+        quint64 m_footerPower = 1;
+        /** @} */
+
+        /**
+         * @brief Диапазон узлов, изменившихся с момента отметки сохранения, пуст, если начало
+         *        больше конца
+         */
+        /** @{ */
+        bool m_isChangeKnown = false;
+        int m_changedFrom = 0;
+        int m_changedTo = -1;
+        /** @} */
+
+        /**
+         * @brief Нужно ли при проверке сверить со снимком весь документ, т.к. изменившийся блок
+         *        не удалось сопоставить с узлом
+         */
+        bool m_isFullValidationNeeded = false;
+
+        /**
+         * @brief Последний собранный xml сценария
+         */
+        /** @{ */
+        mutable QString m_xml;
+        mutable bool m_isXmlActual = false;
+        /** @} */
+
+        Q_DISABLE_COPY(ScenarioXmlSnapshot)
+    };
+}
+
+#endif // SCENARIOXMLSNAPSHOT_H
@@ -19,7 +19,7 @@ ScriptBookmarksModel::ScriptBookmarksModel(BusinessLogic::ScenarioTextDocument*
 {
     Q_ASSERT(_parent);
 
-    connect(m_document, &ScenarioTextDocument::contentsChange, this, &ScriptBookmarksModel::aboutUpdateBookmarksModel);
+    connect(m_document, &ScenarioTextDocument::mergedContentsChange, this, &ScriptBookmarksModel::aboutUpdateBookmarksModel);
 }
 
 int ScriptBookmarksModel::rowCount(const QModelIndex& _parent) const
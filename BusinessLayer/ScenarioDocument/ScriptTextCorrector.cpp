@@ -81,6 +81,8 @@ ScriptTextCorrector::ScriptTextCorrector(QTextDocument* _document, const QString
     m_templateName(_templateName)
 {
     Q_ASSERT_X(m_document, Q_FUNC_INFO, "Document couldn't be a nullptr");
+
+    connect(m_document, &QTextDocument::contentsChange, this, &ScriptTextCorrector::aboutContentsChange);
 }
 
 void ScriptTextCorrector::setNeedToCorrectCharactersNames(bool _need)
@@ -105,6 +107,10 @@ void ScriptTextCorrector::clear()
     m_lastDocumentSize = QSizeF();
     m_currentBlockNumber = 0;
     m_blockItems.clear();
+    m_lastBlockCount = 0;
+    m_lastCharacterCount = 0;
+    m_changeStart = -1;
+    m_changeEnd = -1;
 }
 
 void ScriptTextCorrector::correct(int _position, int _charRemoved, int _charAdded)
@@ -147,6 +153,33 @@ int ScriptTextCorrector::correctedPosition(int _position) const
     return _position + positionDelta;
 }
 
+void ScriptTextCorrector::aboutContentsChange(int _position, int _charsRemoved, int _charsAdded)
+{
+    //
+    // Собственные изменения учитываются в ходе корректировки разрывов
+    //
+    if (m_isPageBreaksCorrectionInProgress) {
+        return;
+    }
+
+    //
+    // Расширяем диапазон изменённого текста, конец диапазона смещается вместе с текстом после изменения
+    //
+    const int changeEnd = _position + _charsAdded;
+    if (m_changeStart == -1) {
+        m_changeStart = _position;
+        m_changeEnd = changeEnd;
+        return;
+    }
+
+    m_changeStart = std::min(m_changeStart, _position);
+    if (m_changeEnd >= _position + _charsRemoved) {
+        m_changeEnd += _charsAdded - _charsRemoved;
+    } else {
+        m_changeEnd = std::max(m_changeEnd, changeEnd);
+    }
+}
+
 void ScriptTextCorrector::correctCharactersNames(int _position, int _charsRemoved, int _charsAdded)
 {
     //
@@ -310,9 +343,17 @@ void ScriptTextCorrector::correctPageBreaks(int _position)
     }
 
     //
-    // Карту декораций перестраиваем целиком
+    // Определим начало изменённого текста, учитывая все изменения с момента последней корректировки
     //
-    m_decorations.clear();
+    int changeStart = _position;
+    int changeEnd = _position;
+    if (_position != -1
+        && m_changeStart != -1) {
+        changeStart = std::min(_position, m_changeStart);
+        changeEnd = std::max(_position, m_changeEnd);
+    }
+    m_changeStart = -1;
+    m_changeEnd = -1;
 
     //
     // Определим список блоков для принудительной ручной проверки
@@ -320,8 +361,9 @@ void ScriptTextCorrector::correctPageBreaks(int _position)
     //       в предыдущих и следующих за переносом блоках
     //
     QSet<int> blocksToRecheck;
-    if (_position != -1) {
-        QTextBlock blockToRecheck = m_document->findBlock(_position);
+    int firstBlockToRecheck = 0;
+    if (changeStart != -1) {
+        QTextBlock blockToRecheck = m_document->findBlock(changeStart);
         //
         // ... спускаемся на два блока вперёд
         //
@@ -333,7 +375,8 @@ void ScriptTextCorrector::correctPageBreaks(int _position)
         //
         int recheckBlocksCount = 5;
         do {
-            blocksToRecheck.insert(blockToRecheck.blockNumber());
+            firstBlockToRecheck = blockToRecheck.blockNumber();
+            blocksToRecheck.insert(firstBlockToRecheck);
             blockToRecheck = blockToRecheck.previous();
         } while (blockToRecheck.isValid()
                  && (recheckBlocksCount-- > 0
@@ -342,21 +385,49 @@ void ScriptTextCorrector::correctPageBreaks(int _position)
                      || blockToRecheck.blockFormat().boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionEnd)));
     }
 
+    //
+    // Определим блок, с которого начнём корректировку - начало страницы перед изменённым текстом,
+    // или начало документа, если корректируем весь документ
+    //
+    QTextBlock block = m_document->begin();
+    if (changeStart != -1) {
+        block = findPageStartBlock(m_document->findBlockByNumber(firstBlockToRecheck));
+    }
+
+    //
+    // Запомним предыдущую раскладку блоков после начала корректировки, чтобы определить момент,
+    // когда разрывы страниц снова совпадут с ней и дальнейшая корректировка не нужна
+    //
+    const bool canStopOnPreviousLayout = changeStart != -1;
+    const QVector<BlockInfo> previousBlockItems = m_blockItems;
+    const QMap<int, int> previousDecorations = m_decorations;
+    //
+    // ... декорации до начала корректировки не изменятся, а остальные определим заново
+    //
+    for (auto iter = m_decorations.lowerBound(block.position()); iter != m_decorations.end(); ) {
+        iter = m_decorations.erase(iter);
+    }
+
     //
     // Начинаем работу с документом
     //
+    m_isPageBreaksCorrectionInProgress = true;
     ScriptTextCursor cursor(m_document);
     cursor.beginEditBlock();
+    //
+    // ... конец изменённого текста отслеживаем курсором, чтобы учесть добавление декораций
+    //
+    QTextCursor changeEndCursor(m_document);
+    changeEndCursor.setPosition(std::min(std::max(changeEnd, 0), m_document->characterCount() - 1));
 
     //
-    // Идём по каждому блоку документа с самого начала
+    // Идём по каждому блоку документа, начиная с найденного
     //
-    QTextBlock block = m_document->begin();
+    m_currentBlockNumber = block.blockNumber();
     //
     // ... значение нижней позиции последнего блока относительно начала страницы
     //
     qreal lastBlockHeight = 0.0;
-    m_currentBlockNumber = 0;
     while (block.isValid()) {
         //
         // Пропускаем невидимые блоки
@@ -413,6 +484,43 @@ void ScriptTextCorrector::correctPageBreaks(int _position)
                 // но влезает хотя бы одна строка
                 && (lastBlockHeight + blockFormat.topMargin() + blockLineHeight < pageHeight);
 
+        //
+        // Если после изменённого текста блок начинает страницу так же, как и при предыдущей
+        // корректировке, то дальше раскладка блоков не изменится и корректировку можно завершить
+        //
+        if (canStopOnPreviousLayout
+            && qFuzzyCompare(lastBlockHeight, 0.0)
+            && block.position() > changeEndCursor.position()
+            && !blocksToRecheck.contains(m_currentBlockNumber)
+            && !blockFormat.boolProperty(ScenarioBlockStyle::PropertyIsCorrection)
+            && !blockFormat.boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionStart)
+            && !blockFormat.boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionEnd)) {
+            //
+            // ... блоки после изменения сместились на разницу в количестве блоков
+            //
+            const int blocksDelta = m_document->blockCount() - m_lastBlockCount;
+            const BlockInfo previousBlockInfo = previousBlockItems.value(m_currentBlockNumber - blocksDelta);
+            if (previousBlockInfo.isValid()
+                && qFuzzyCompare(previousBlockInfo.height, blockHeight)
+                && qFuzzyCompare(previousBlockInfo.top, 0.0)) {
+                //
+                // ... переносим параметры оставшихся блоков
+                //
+                for (int blockNumber = m_currentBlockNumber; blockNumber < m_blockItems.size(); ++blockNumber) {
+                    m_blockItems[blockNumber] = previousBlockItems.value(blockNumber - blocksDelta);
+                }
+                //
+                // ... и их декорации
+                //
+                const int positionDelta = m_document->characterCount() - m_lastCharacterCount;
+                for (auto iter = previousDecorations.lowerBound(block.position() - positionDelta);
+                     iter != previousDecorations.end(); ++iter) {
+                    m_decorations.insert(iter.key() + positionDelta, iter.value());
+                }
+                break;
+            }
+        }
+
         //
         // Проверяем, изменилась ли позиция блока,
         // и что текущий блок это не изменённый блок под курсором
@@ -1080,6 +1188,10 @@ void ScriptTextCorrector::correctPageBreaks(int _position)
     }
 
     cursor.endEditBlock();
+    m_isPageBreaksCorrectionInProgress = false;
+
+    m_lastBlockCount = m_document->blockCount();
+    m_lastCharacterCount = m_document->characterCount();
 }
 
 void ScriptTextCorrector::moveCurrentBlockWithThreePreviousToNextPage(const QTextBlock& _prePrePreviousBlock,
@@ -1295,6 +1407,28 @@ void ScriptTextCorrector::breakDialogue(const QTextBlockFormat& _blockFormat, qr
     }
 }
 
+QTextBlock ScriptTextCorrector::findPageStartBlock(const QTextBlock& _block) const
+{
+    for (QTextBlock block = _block; block.isValid(); block = block.previous()) {
+        //
+        // Страница должна начинаться с обычного видимого блока, позиция которого известна
+        //
+        const int blockNumber = block.blockNumber();
+        const QTextBlockFormat blockFormat = block.blockFormat();
+        if (block.isVisible()
+            && blockNumber < m_blockItems.size()
+            && m_blockItems[blockNumber].isValid()
+            && qFuzzyCompare(m_blockItems[blockNumber].top, 0.0)
+            && !blockFormat.boolProperty(ScenarioBlockStyle::PropertyIsCorrection)
+            && !blockFormat.boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionStart)
+            && !blockFormat.boolProperty(ScenarioBlockStyle::PropertyIsBreakCorrectionEnd)) {
+            return block;
+        }
+    }
+
+    return m_document->begin();
+}
+
 QTextBlock ScriptTextCorrector::findPreviousBlock(const QTextBlock& _block)
 {
     QTextBlock previousBlock = _block.previous();
@@ -60,6 +60,11 @@ namespace BusinessLogic
         int correctedPosition(int _position) const;
 
     private:
+        /**
+         * @brief Запомнить изменение текста документа для последующей корректировки разрывов
+         */
+        void aboutContentsChange(int _position, int _charsRemoved, int _charsAdded);
+
         /**
          * @brief Скорректировать имена персонажей
          */
@@ -118,6 +123,13 @@ namespace BusinessLogic
          */
         QTextBlock findPreviousBlock(const QTextBlock& _block);
 
+        /**
+         * @brief Найти блок, начинающий страницу, на которой находится заданный блок
+         * @note Используются параметры блоков с предыдущей корректировки, если начало страницы
+         *       определить не удалось, то возвращается первый блок документа
+         */
+        QTextBlock findPageStartBlock(const QTextBlock& _block) const;
+
         /**
          * @brief Найти следующий блок, который не является декорацией
          */
@@ -199,6 +211,27 @@ namespace BusinessLogic
          */
         QVector<BlockInfo> m_blockItems;
 
+        /**
+         * @brief Количество блоков и символов документа после последней корректировки разрывов
+         */
+        /** @{ */
+        int m_lastBlockCount = 0;
+        int m_lastCharacterCount = 0;
+        /** @} */
+
+        /**
+         * @brief Диапазон текста, изменённого с момента последней корректировки разрывов
+         */
+        /** @{ */
+        int m_changeStart = -1;
+        int m_changeEnd = -1;
+        /** @} */
+
+        /**
+         * @brief Выполняется ли корректировка разрывов
+         */
+        bool m_isPageBreaksCorrectionInProgress = false;
+
         /**
          * @brief Список декораций документа <позиция, длина>
          * @note Используется для поиска положения курсора при наложении патча
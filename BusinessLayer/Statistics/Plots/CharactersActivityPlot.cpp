@@ -11,7 +11,6 @@
 #include <Domain/Research.h>
 
 #include <3rd_party/Helpers/TextEditHelper.h>
-#include <3rd_party/Widgets/PagesTextEdit/PageTextEdit.h>
 
 #include <QApplication>
 #include <QTextBlock>
@@ -22,13 +21,6 @@
 using namespace BusinessLogic;
 
 namespace {
-	/**
-	 * @brief Стиль документа
-	 */
-	static ScenarioTemplate editorStyle() {
-		return ScenarioTemplateFacade::getTemplate();
-	}
-
 	/**
 	 * @brief Цвет для графика по персонажу
 	 *		  Пробуем получить неповторяющие пастельные цвета
@@ -53,12 +45,6 @@ QString CharactersActivityPlot::plotName(const BusinessLogic::StatisticsParamete
 
 Plot CharactersActivityPlot::makePlot(QTextDocument* _scenario, const BusinessLogic::StatisticsParameters& _parameters) const
 {
-	PageTextEdit edit;
-	edit.setUsePageMode(true);
-	edit.setPageFormat(::editorStyle().pageSizeId());
-	edit.setPageMargins(::editorStyle().pageMargins());
-	edit.setDocument(_scenario->clone());
-
 	//
 	// Сформируем регулярное выражение для выуживания молчаливых персонажей
 	//
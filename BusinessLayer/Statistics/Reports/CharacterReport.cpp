@@ -5,9 +5,11 @@
 #include <BusinessLayer/ScenarioDocument/ScenarioTextBlockParsers.h>
 
 #include <3rd_party/Helpers/TextEditHelper.h>
-#include <3rd_party/Widgets/PagesTextEdit/PageTextEdit.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageMetrics.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageTextLayout.h>
 
 #include <QApplication>
+#include <QScopedPointer>
 #include <QPalette>
 #include <QTextBlock>
 #include <QTextDocument>
@@ -40,17 +42,15 @@ QString CharacterReport::makeReport(QTextDocument* _scenario,
     }
 
 
-    PageTextEdit edit;
-    edit.setUsePageMode(true);
-    edit.setPageFormat(::editorStyle().pageSizeId());
-    edit.setPageMargins(::editorStyle().pageMargins());
-    edit.setDocument(_scenario->clone());
+    QScopedPointer<QTextDocument> pagedScenario(_scenario->clone());
+    PageTextLayout::setupDocument(pagedScenario.data(),
+        PageMetrics(::editorStyle().pageSizeId(), ::editorStyle().pageMargins()));
 
     //
     // Бежим по документу и собираем информацию о сценах
     //
     QTextBlock block = _scenario->begin();
-    QTextCursor cursor = edit.textCursor();
+    QTextCursor cursor(pagedScenario.data());
     QList<ReportData*> reportScenesDataList;
     ReportData* currentData = 0;
     bool saveDialogues = false;
@@ -63,7 +63,7 @@ QString CharacterReport::makeReport(QTextDocument* _scenario,
             currentData->scene = TextEditHelper::smartToUpper(block.text());
             //
             cursor.setPosition(block.position());
-            currentData->page = edit.cursorPage(cursor);
+            currentData->page = PageTextLayout::cursorPage(cursor);
             //
             if (SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(block.userData())) {
                 currentData->number = info->sceneNumber();
@@ -6,9 +6,11 @@
 #include <BusinessLayer/Chronometry/ChronometerFacade.h>
 
 #include <3rd_party/Helpers/TextEditHelper.h>
-#include <3rd_party/Widgets/PagesTextEdit/PageTextEdit.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageMetrics.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageTextLayout.h>
 
 #include <QApplication>
+#include <QScopedPointer>
 #include <QTextBlock>
 #include <QTextDocument>
 
@@ -33,17 +35,15 @@ QString LocationReport::makeReport(QTextDocument* _scenario,
 	const BusinessLogic::StatisticsParameters& _parameters) const
 {
 
-	PageTextEdit edit;
-	edit.setUsePageMode(true);
-	edit.setPageFormat(::editorStyle().pageSizeId());
-	edit.setPageMargins(::editorStyle().pageMargins());
-	edit.setDocument(_scenario->clone());
+	QScopedPointer<QTextDocument> pagedScenario(_scenario->clone());
+	PageTextLayout::setupDocument(pagedScenario.data(),
+		PageMetrics(::editorStyle().pageSizeId(), ::editorStyle().pageMargins()));
 
 	//
 	// Бежим по документу и собираем информацию о сценах
 	//
 	QTextBlock block = _scenario->begin();
-	QTextCursor cursor = edit.textCursor();
+	QTextCursor cursor(pagedScenario.data());
 	QList<ReportData*> reportScenesDataList;
 	ReportData* currentData = 0;
 	while (block.isValid()) {
@@ -54,7 +54,7 @@ QString LocationReport::makeReport(QTextDocument* _scenario,
             currentData->name = TextEditHelper::smartToUpper(block.text());
 			//
 			cursor.setPosition(block.position());
-			currentData->page = edit.cursorPage(cursor);
+			currentData->page = PageTextLayout::cursorPage(cursor);
 			//
 			if (SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(block.userData())) {
 				currentData->number = info->sceneNumber();
@@ -11,9 +11,11 @@
 #include <Domain/Research.h>
 
 #include <3rd_party/Helpers/TextEditHelper.h>
-#include <3rd_party/Widgets/PagesTextEdit/PageTextEdit.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageMetrics.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageTextLayout.h>
 
 #include <QApplication>
+#include <QScopedPointer>
 #include <QTextBlock>
 #include <QTextDocument>
 #include <QTextEdit>
@@ -39,11 +41,9 @@ QString SceneReport::reportName(const StatisticsParameters&) const
 QString SceneReport::makeReport(QTextDocument* _scenario,
 	const BusinessLogic::StatisticsParameters& _parameters) const
 {
-	PageTextEdit edit;
-	edit.setUsePageMode(true);
-	edit.setPageFormat(::editorStyle().pageSizeId());
-	edit.setPageMargins(::editorStyle().pageMargins());
-	edit.setDocument(_scenario->clone());
+	QScopedPointer<QTextDocument> pagedScenario(_scenario->clone());
+	PageTextLayout::setupDocument(pagedScenario.data(),
+		PageMetrics(::editorStyle().pageSizeId(), ::editorStyle().pageMargins()));
 
 	//
 	// Сформируем регулярное выражение для выуживания молчаливых персонажей
@@ -68,7 +68,7 @@ QString SceneReport::makeReport(QTextDocument* _scenario,
 	// Бежим по документу и собираем информацию о сценах и персонажах в них
 	//
 	QTextBlock block = _scenario->begin();
-	QTextCursor cursor = edit.textCursor();
+	QTextCursor cursor(pagedScenario.data());
 	QList<SceneData*> reportScenesDataList;
 	SceneData* currentData = 0;
 	QStringList characters;
@@ -80,7 +80,7 @@ QString SceneReport::makeReport(QTextDocument* _scenario,
             currentData->name = TextEditHelper::smartToUpper(block.text());
 			//
 			cursor.setPosition(block.position());
-			currentData->page = edit.cursorPage(cursor);
+			currentData->page = PageTextLayout::cursorPage(cursor);
 			//
 			if (SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*>(block.userData())) {
 				currentData->number = info->sceneNumber();
@@ -12,9 +12,11 @@
 #include <DataLayer/DataStorageLayer/ResearchStorage.h>
 
 #include <3rd_party/Helpers/TextEditHelper.h>
-#include <3rd_party/Widgets/PagesTextEdit/PageTextEdit.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageMetrics.h>
+#include <3rd_party/Widgets/PagesTextEdit/PageTextLayout.h>
 
 #include <QApplication>
+#include <QScopedPointer>
 #include <QTextBlock>
 #include <QTextDocument>
 
@@ -136,14 +138,12 @@ QString SummaryReport::makeReport(QTextDocument* _scenario, const BusinessLogic:
         //
         // Статистика по текстовой состовляющей
         //
-        PageTextEdit edit;
-        edit.setUsePageMode(true);
-        edit.setPageFormat(::editorStyle().pageSizeId());
-        edit.setPageMargins(::editorStyle().pageMargins());
-        edit.setDocument(_scenario->clone());
+        QScopedPointer<QTextDocument> pagedScenario(_scenario->clone());
+        PageTextLayout::setupDocument(pagedScenario.data(),
+            PageMetrics(::editorStyle().pageSizeId(), ::editorStyle().pageMargins()));
 
         const qreal chron = ChronometerFacade::calculate(_scenario);
-        const int pageCount = edit.document()->pageCount();
+        const int pageCount = pagedScenario->pageCount();
         const Counter counter = CountersFacade::calculateFull(_scenario);
 
         html.append("<table width=\"100%\">");
@@ -11,6 +11,8 @@
 #include "Plots/StoryStructureAnalisysPlot.h"
 #include "Plots/CharactersActivityPlot.h"
 
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
+
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
 #include <DataLayer/DataStorageLayer/ScenarioDataStorage.h>
 #include <DataLayer/Database/Database.h>
@@ -19,9 +21,21 @@
 #include <QDateTime>
 #include <QFileInfo>
 
+namespace {
+	/**
+	 * @brief Дождаться загрузки сценария целиком, т.к. отчёты и графики строятся по всему тексту
+	 */
+	static void finishLoading(QTextDocument* _scenario) {
+		if (BusinessLogic::ScenarioTextDocument* scenario = qobject_cast<BusinessLogic::ScenarioTextDocument*>(_scenario)) {
+			scenario->finishLoading();
+		}
+	}
+}
 
 QString BusinessLogic::StatisticsFacade::makeReport(QTextDocument* _scenario, const BusinessLogic::StatisticsParameters& _parameters)
 {
+	::finishLoading(_scenario);
+
 	QString result;
 	switch (_parameters.type) {
 		default:
@@ -92,6 +106,8 @@ QString BusinessLogic::StatisticsFacade::makeReport(QTextDocument* _scenario, co
 BusinessLogic::Plot BusinessLogic::StatisticsFacade::makePlot(
 	QTextDocument* _scenario, const BusinessLogic::StatisticsParameters& _parameters)
 {
+	::finishLoading(_scenario);
+
 	BusinessLogic::Plot result;
 	switch (_parameters.type) {
 		default:
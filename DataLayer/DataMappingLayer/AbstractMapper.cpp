@@ -3,22 +3,26 @@
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
 
 #include <DataLayer/Database/Database.h>
-#include <DataLayer/Database/DatabaseHelper.h>
+#include <DataLayer/Database/DatabaseHistoryWriter.h>
 
-#include <3rd_party/Helpers/QVariantMapWriter.h>
-
-#include <QApplication>
-#include <QDateTime>
 #include <QDebug>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QStringList>
 #include <QVariant>
-#include <QUuid>
+#include <QVector>
 
 
 using namespace DataMappingLayer;
 using namespace DatabaseLayer;
 
+namespace {
+    /**
+     * @brief Максимальное количество параметров в одном запросе, поддерживаемое sqlite
+     */
+    const int kMaxBindValuesCount = 999;
+}
+
 
 AbstractMapper::AbstractMapper()
 {
@@ -133,8 +137,7 @@ void AbstractMapper::abstractInsert(DomainObject* _subject)
     //
     // Сформируем запрос на добавление данных в базу
     //
-    QSqlQuery q_insert = Database::query();
-    q_insert.prepare(insertQuery);
+    QSqlQuery q_insert = Database::preparedQuery(insertQuery);
     foreach (const QVariant& value, insertValues) {
         q_insert.addBindValue(value);
     }
@@ -145,6 +148,106 @@ void AbstractMapper::abstractInsert(DomainObject* _subject)
     executeSql(q_insert);
 }
 
+QList<DomainObject*> AbstractMapper::abstractInsert(const QList<DomainObject*>& _subjects)
+{
+    QList<DomainObject*> insertedSubjects;
+    if (_subjects.isEmpty()) {
+        return insertedSubjects;
+    }
+
+    //
+    // Установим идентификаторы для новых объектов одним диапазоном
+    // и добавим их в список загруженных объектов
+    //
+    Identifier nextId = findNextIdentifier();
+    for (DomainObject* subject : _subjects) {
+        subject->setId(nextId);
+        m_loadedObjectsMap.insert(nextId, subject);
+        nextId = nextId.next();
+    }
+
+    //
+    // Получим данные для формирования запросов на их добавление
+    //
+    QStringList insertQueries;
+    QVector<QVariantList> insertValues;
+    insertValues.reserve(_subjects.size());
+    bool isSameInsertQuery = true;
+    for (DomainObject* subject : _subjects) {
+        QVariantList values;
+        insertQueries.append(insertStatement(subject, values));
+        insertValues.append(values);
+        isSameInsertQuery = isSameInsertQuery && insertQueries.last() == insertQueries.first();
+    }
+    const QString insertQuery = insertQueries.first();
+
+    //
+    // Определим группу параметров одной строки данных, чтобы повторить её в многострочном запросе
+    //
+    const int valuesIndex = insertQuery.indexOf("VALUES");
+    const int rowStart = valuesIndex == -1 ? -1 : insertQuery.indexOf("(", valuesIndex);
+    const int rowEnd = rowStart == -1 ? -1 : insertQuery.indexOf(")", rowStart);
+    const QString rowPlaceholders = rowEnd == -1 ? QString() : insertQuery.mid(rowStart, rowEnd - rowStart + 1);
+    const int rowValuesCount = insertValues.first().size();
+
+    //
+    // Если для запросов нужно вести историю изменений, или запросы не удаётся объединить, то
+    // добавляем данные построчно, переиспользуя подготовленные запросы
+    //
+    if (isHistoryNeeded(insertQuery)
+        || !isSameInsertQuery
+        || rowValuesCount == 0
+        || rowPlaceholders.count('?') != rowValuesCount) {
+        Database::transaction();
+        for (int row = 0; row < insertValues.size(); ++row) {
+            QSqlQuery q_insert = Database::preparedQuery(insertQueries.at(row));
+            for (const QVariant& value : insertValues.at(row)) {
+                q_insert.addBindValue(value);
+            }
+            if (executeSql(q_insert)) {
+                insertedSubjects.append(_subjects.at(row));
+            }
+        }
+        Database::commit();
+        return insertedSubjects;
+    }
+
+    //
+    // В противном случае добавляем данные многострочными запросами, не превышая
+    // ограничение sqlite на количество параметров в запросе
+    //
+    const int maxRowsCount = qMax(1, kMaxBindValuesCount / rowValuesCount);
+    Database::transaction();
+    for (int firstRow = 0; firstRow < insertValues.size(); firstRow += maxRowsCount) {
+        const int rowsCount = qMin(maxRowsCount, insertValues.size() - firstRow);
+        QString rowsPlaceholders = rowPlaceholders;
+        for (int row = 1; row < rowsCount; ++row) {
+            rowsPlaceholders.append(", ");
+            rowsPlaceholders.append(rowPlaceholders);
+        }
+
+        //
+        // Текст многострочного запроса зависит от количества строк, поэтому не кэшируем его
+        //
+        QSqlQuery q_insert = Database::query();
+        q_insert.prepare(insertQuery.left(rowStart) + rowsPlaceholders + insertQuery.mid(rowEnd + 1));
+        for (int row = firstRow; row < firstRow + rowsCount; ++row) {
+            for (const QVariant& value : insertValues.at(row)) {
+                q_insert.addBindValue(value);
+            }
+        }
+        //
+        // Многострочный запрос добавляет либо все свои строки, либо ни одной
+        //
+        if (executeSql(q_insert)) {
+            insertedSubjects.append(_subjects.mid(firstRow, rowsCount));
+        }
+    }
+    Database::commit();
+
+    return insertedSubjects;
+}
+
 bool AbstractMapper::abstractUpdate(DomainObject* _subject)
 {
     //
@@ -165,8 +268,7 @@ bool AbstractMapper::abstractUpdate(DomainObject* _subject)
         //
         // Сформируем запрос на обновление данных в базе
         //
-        QSqlQuery q_update = Database::query();
-        q_update.prepare(updateQuery);
+        QSqlQuery q_update = Database::preparedQuery(updateQuery);
         foreach (const QVariant& value, updateValues) {
             q_update.addBindValue(value);
         }
@@ -204,8 +306,7 @@ void AbstractMapper::abstractDelete(DomainObject* _subject)
     //
     // Сформируем запрос на удаление данных из базы
     //
-    QSqlQuery q_delete = Database::query();
-    q_delete.prepare(deleteQuery);
+    QSqlQuery q_delete = Database::preparedQuery(deleteQuery);
     foreach (const QVariant& value, deleteValues) {
         q_delete.addBindValue(value);
     }
@@ -225,6 +326,14 @@ void AbstractMapper::abstractDelete(DomainObject* _subject)
 
 bool AbstractMapper::executeSql(QSqlQuery& _sqlQuery)
 {
+    //
+    // Запрос, для которого ведётся история, выполняем в группе изменений, чтобы он был
+    // зафиксирован вместе с записью истории и остальными изменениями той же операции
+    //
+    if (isHistoryNeeded(_sqlQuery.lastQuery())) {
+        DatabaseHistoryWriter::beginGroup();
+    }
+
     //
     // Если запрос завершился с ошибкой, выводим отладочную информацию
     //
@@ -243,48 +352,29 @@ bool AbstractMapper::executeSql(QSqlQuery& _sqlQuery)
     else {
         Database::setLastError(QString());
 
-        //
-        // NOTE: Оптимизация размера файла проекта
-        // Сохраняем всё, кроме изменений сценария и текста самого сценария
-        //
-        if (!_sqlQuery.lastQuery().contains(" scenario_changes ")
-            && !_sqlQuery.lastQuery().contains(" scenario ")) {
-
-            QSqlQuery q_history(_sqlQuery);
-            q_history.prepare("INSERT INTO _database_history (id, query, query_values, username, datetime) VALUES(?, ?, ?, ?, ?);");
-            //
-            // ... uuid
-            //
-            q_history.addBindValue(QUuid::createUuid().toString());
+        if (isHistoryNeeded(_sqlQuery.lastQuery())) {
             //
-            // ... запрос
+            // NOTE: Запись сохраняется вместе с другими накопившимися записями перед
+            //       фиксацией транзакции, или группы изменений
             //
-            q_history.addBindValue(_sqlQuery.lastQuery());
-            //
-            // ... данные в сжатом виде
-            //
-            QString valueString = QVariantMapWriter::mapToDataString(_sqlQuery.boundValues());
-            valueString = DatabaseHelper::compress(valueString);
-            q_history.addBindValue(valueString);
-            //
-            // ... имя пользовтаеля
-            //
-            q_history.addBindValue(DataStorageLayer::StorageFacade::userName());
-            //
-            // ... время выполнения
-            //
-            q_history.addBindValue(QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss:zzz"));
-
-            //
-            // Сохраняем данные
-            //
-            q_history.exec();
+            DatabaseHistoryWriter::enqueue(
+                _sqlQuery.lastQuery(), _sqlQuery.boundValues(), DataStorageLayer::StorageFacade::userName());
         }
     }
 
     return true;
 }
 
+bool AbstractMapper::isHistoryNeeded(const QString& _query)
+{
+    //
+    // NOTE: Оптимизация размера файла проекта
+    // Сохраняем всё, кроме изменений сценария и текста самого сценария
+    //
+    return !_query.contains(" scenario_changes ")
+            && !_query.contains(" scenario ");
+}
+
 DomainObject* AbstractMapper::loadObjectFromDatabase(const Identifier& _id)
 {
     QSqlQuery query = Database::query();
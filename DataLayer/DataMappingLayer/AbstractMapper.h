@@ -57,6 +57,13 @@ namespace DataMappingLayer
         DomainObject * abstractFind(const Identifier& _id);
         DomainObjectsItemModel * abstractFindAll(const QString& _filter = QString());
         void abstractInsert(DomainObject* _subject);
+        /**
+         * @brief Добавить сразу несколько объектов
+         * @note Идентификаторы выделяются одним диапазоном, а данные добавляются многострочными
+         *       запросами, если для запросов не нужно вести историю изменений
+         * @return Объекты, данные которых удалось добавить в базу данных
+         */
+        QList<DomainObject*> abstractInsert(const QList<DomainObject*>& _subjects);
         bool abstractUpdate(DomainObject* _subject);
         void abstractDelete(DomainObject* _subject);
 
@@ -65,6 +72,11 @@ namespace DataMappingLayer
          */
         bool executeSql(QSqlQuery& _sqlQuery);
 
+        /**
+         * @brief Нужно ли сохранять запрос в истории изменений
+         */
+        static bool isHistoryNeeded(const QString& _query);
+
     protected:
         AbstractMapper();
 
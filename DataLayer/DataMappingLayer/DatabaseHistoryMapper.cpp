@@ -2,6 +2,7 @@
 
 #include <DataLayer/Database/Database.h>
 #include <DataLayer/Database/DatabaseHelper.h>
+#include <DataLayer/Database/DatabaseHistoryWriter.h>
 
 #include <3rd_party/Helpers/QVariantMapWriter.h>
 
@@ -13,6 +14,7 @@
 using DataMappingLayer::DatabaseHistoryMapper;
 using DatabaseLayer::Database;
 using DatabaseLayer::DatabaseHelper;
+using DatabaseLayer::DatabaseHistoryWriter;
 
 namespace {
     const QString ID_KEY = "id";
@@ -25,6 +27,8 @@ namespace {
 
 QList<QString> DatabaseHistoryMapper::history(const QString& _fromDatetime)
 {
+    DatabaseHistoryWriter::flush();
+
     QSqlQuery q_loader = Database::query();
     q_loader.exec(
         QString("SELECT %1 FROM _database_history WHERE %2 >= '%3'")
@@ -41,6 +45,8 @@ QList<QString> DatabaseHistoryMapper::history(const QString& _fromDatetime)
 
 QMap<QString, QString> DatabaseHistoryMapper::last()
 {
+    DatabaseHistoryWriter::flush();
+
     QSqlQuery q_loader = Database::query();
     q_loader.exec(
         QString("SELECT %1, %2 FROM _database_history ORDER BY %2 DESC LIMIT 1")
@@ -57,6 +63,8 @@ QMap<QString, QString> DatabaseHistoryMapper::last()
 
 QMap<QString, QString> DatabaseHistoryMapper::historyRecord(const QString& _uuid)
 {
+    DatabaseHistoryWriter::flush();
+
     QSqlQuery q_loader = Database::query();
     q_loader.exec(
         QString("SELECT %1, %2, %3, %4, %5 FROM _database_history WHERE %1 = '%6'")
@@ -76,6 +84,8 @@ QMap<QString, QString> DatabaseHistoryMapper::historyRecord(const QString& _uuid
 
 bool DatabaseHistoryMapper::contains(const QString& _uuid) const
 {
+    DatabaseHistoryWriter::flush();
+
     QSqlQuery q_loader = Database::query();
     q_loader.exec(
         QString("SELECT COUNT(%1) AS size FROM _database_history WHERE %1 = '%2'")
@@ -89,11 +99,11 @@ bool DatabaseHistoryMapper::contains(const QString& _uuid) const
 void DatabaseHistoryMapper::storeHistoryRecord(const QString& _uuid, const QString& _query,
     const QString& _queryValues, const QString& _username, const QString& _datetime)
 {
-    QSqlQuery q_saver = Database::query();
-    q_saver.prepare(
-        QString("INSERT INTO _database_history (%1, %2, %3, %4, %5) VALUES(?, ?, ?, ?, ?)")
-        .arg(ID_KEY, QUERY_KEY, QUERY_VALUES_KEY, USERNAME_KEY, DATETIME_KEY)
-        );
+    QSqlQuery q_saver =
+            Database::preparedQuery(
+                QString("INSERT INTO _database_history (%1, %2, %3, %4, %5) VALUES(?, ?, ?, ?, ?)")
+                .arg(ID_KEY, QUERY_KEY, QUERY_VALUES_KEY, USERNAME_KEY, DATETIME_KEY)
+                );
     q_saver.addBindValue(_uuid);
     q_saver.addBindValue(_query);
     q_saver.addBindValue(_queryValues);
@@ -104,8 +114,7 @@ void DatabaseHistoryMapper::storeHistoryRecord(const QString& _uuid, const QStri
 
 void DatabaseHistoryMapper::applyHistoryRecord(const QString& _query, const QString& _queryValues)
 {
-    QSqlQuery q_saver = Database::query();
-    q_saver.prepare(_query);
+    QSqlQuery q_saver = Database::preparedQuery(_query);
     const QString valuesUncompressed = DatabaseHelper::uncompress(_queryValues);
     const QVariantMap values = QVariantMapWriter::dataStringToMap(valuesUncompressed);
     foreach (const QString& key, values.keys()) {
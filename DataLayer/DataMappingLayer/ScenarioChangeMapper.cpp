@@ -13,8 +13,64 @@ using namespace DataMappingLayer;
 namespace {
     const QString kColumns = " id, uuid, datetime, username, undo_patch, redo_patch, is_draft ";
     const QString kTableName = " scenario_changes ";
+
+    /**
+     * @brief Колонки заголовка изменения, патчи загружаются отдельно по запросу
+     */
+    const QString kHeaderColumns = " id, uuid, datetime, username, is_draft ";
+}
+
+ScenarioChangePatchMapper::ScenarioChangePatchMapper()
+{
+    //
+    // Кэшируем патчи только для последних запрошенных изменений
+    //
+    m_patchesCache.setMaxCost(50);
+}
+
+QString ScenarioChangePatchMapper::undoPatch(const ScenarioChange* _forChange) const
+{
+    return patches(_forChange).first;
+}
+
+QString ScenarioChangePatchMapper::redoPatch(const ScenarioChange* _forChange) const
+{
+    return patches(_forChange).second;
+}
+
+void ScenarioChangePatchMapper::remove(const ScenarioChange* _forChange) const
+{
+    m_patchesCache.remove(_forChange->id().value());
+}
+
+QPair<QString, QString> ScenarioChangePatchMapper::patches(const ScenarioChange* _forChange) const
+{
+    //
+    // Патчи загружаются по идентификатору изменения, поэтому по нему же и кэшируются
+    //
+    const int key = _forChange->id().value();
+    //
+    // Если патчей нет в кэше, загрузим их из базы данных
+    //
+    if (!m_patchesCache.contains(key)) {
+        QSqlQuery query =
+                DatabaseLayer::Database::preparedQuery(
+                    "SELECT undo_patch, redo_patch FROM " + kTableName + " WHERE id = ? ");
+        query.addBindValue(_forChange->id().value());
+        query.exec();
+        query.next();
+        const QPair<QString, QString> patches(query.value("undo_patch").toString(), query.value("redo_patch").toString());
+        query.finish();
+
+        m_patchesCache.insert(key, new QPair<QString, QString>(patches));
+        return patches;
+    }
+
+    return *m_patchesCache.object(key);
 }
 
+// ****
+
 ScenarioChange* ScenarioChangeMapper::find(const Identifier& _id)
 {
     return dynamic_cast<ScenarioChange*>(abstractFind(_id));
@@ -34,6 +90,31 @@ ScenarioChangesTable* ScenarioChangeMapper::findAll(const QString& _queryFilter)
 void ScenarioChangeMapper::insert(ScenarioChange* _change)
 {
     abstractInsert(_change);
+
+    //
+    // Сохранённые патчи больше не держим в памяти
+    //
+    if (!DatabaseLayer::Database::hasError()) {
+        _change->setPatchWrapper(&m_patchWrapper);
+    }
+}
+
+void ScenarioChangeMapper::insert(const QList<ScenarioChange*>& _changes)
+{
+    QList<DomainObject*> changes;
+    changes.reserve(_changes.size());
+    for (ScenarioChange* change : _changes) {
+        changes.append(change);
+    }
+    const QList<DomainObject*> insertedChanges = abstractInsert(changes);
+
+    //
+    // Сохранённые патчи больше не держим в памяти, а патчи изменений, которые сохранить
+    // не удалось, оставляем, т.к. загрузить их будет неоткуда
+    //
+    for (DomainObject* change : insertedChanges) {
+        dynamic_cast<ScenarioChange*>(change)->setPatchWrapper(&m_patchWrapper);
+    }
 }
 
 void ScenarioChangeMapper::update(ScenarioChange* _change)
@@ -43,18 +124,22 @@ void ScenarioChangeMapper::update(ScenarioChange* _change)
 
 void ScenarioChangeMapper::remove(ScenarioChange* _change)
 {
+    m_patchWrapper.remove(_change);
     abstractDelete(_change);
 }
 
 bool ScenarioChangeMapper::contains(const QString& _uuid, const QString& _datetime)
 {
-    QSqlQuery checker = DatabaseLayer::Database::query();
-    checker.prepare("SELECT COUNT(id) FROM " + kTableName + " WHERE uuid = ? AND datetime = ?");
+    QSqlQuery checker =
+            DatabaseLayer::Database::preparedQuery(
+                "SELECT COUNT(id) FROM " + kTableName + " WHERE uuid = ? AND datetime = ?");
     checker.addBindValue(_uuid);
     checker.addBindValue(_datetime);
     checker.exec();
     checker.next();
-    return checker.value(0).toInt();
+    const bool contains = checker.value(0).toInt();
+    checker.finish();
+    return contains;
 }
 
 QList<QPair<QString, QString>> ScenarioChangeMapper::uuids() const
@@ -70,22 +155,25 @@ QList<QPair<QString, QString>> ScenarioChangeMapper::uuids() const
 
 ScenarioChange ScenarioChangeMapper::change(const QString& _uuid, const QString& _datetime) const
 {
-    QSqlQuery loader = DatabaseLayer::Database::query();
-    loader.prepare("SELECT " + kColumns + " FROM " + kTableName + " WHERE uuid = ? AND datetime = ? ");
+    QSqlQuery loader =
+            DatabaseLayer::Database::preparedQuery(
+                "SELECT " + kColumns + " FROM " + kTableName + " WHERE uuid = ? AND datetime = ? ");
     loader.addBindValue(_uuid);
     loader.addBindValue(_datetime);
     loader.exec();
     loader.next();
-    return
-            ScenarioChange(Identifier(), _uuid, QDateTime::fromString(loader.value("datetime").toString(), "yyyy-MM-dd hh:mm:ss:zzz"),
-                loader.value("username").toString(), loader.value("undo_patch").toString(),
-                loader.value("redo_patch").toString(), loader.value("is_draft").toInt());
+    const ScenarioChange change(Identifier(), _uuid,
+        QDateTime::fromString(loader.value("datetime").toString(), "yyyy-MM-dd hh:mm:ss:zzz"),
+        loader.value("username").toString(), loader.value("undo_patch").toString(),
+        loader.value("redo_patch").toString(), loader.value("is_draft").toInt());
+    loader.finish();
+    return change;
 }
 
 QString ScenarioChangeMapper::findStatement(const Identifier& _id) const
 {
     QString findStatement =
-            QString("SELECT " + kColumns +
+            QString("SELECT " + kHeaderColumns +
                     " FROM " + kTableName +
                     " WHERE id = %1 "
                     )
@@ -95,7 +183,7 @@ QString ScenarioChangeMapper::findStatement(const Identifier& _id) const
 
 QString ScenarioChangeMapper::findAllStatement() const
 {
-    return "SELECT " + kColumns + " FROM  " + kTableName;
+    return "SELECT " + kHeaderColumns + " FROM  " + kTableName;
 }
 
 QString ScenarioChangeMapper::insertStatement(DomainObject* _subject, QVariantList& _insertValues) const
@@ -160,11 +248,11 @@ DomainObject* ScenarioChangeMapper::doLoad(const Identifier& _id, const QSqlReco
     const QUuid uuid = QUuid(_record.value("uuid").toString());
     const QDateTime datetime = QDateTime::fromString(_record.value("datetime").toString(), "yyyy-MM-dd hh:mm:ss:zzz");
     const QString user = _record.value("username").toString();
-    const QString undoPatch = _record.value("undo_patch").toString();
-    const QString redoPatch = _record.value("redo_patch").toString();
     const bool isDraft = _record.value("is_draft").toInt();
 
-    return new ScenarioChange(_id, uuid, datetime, user, undoPatch, redoPatch, isDraft);
+    ScenarioChange* change = new ScenarioChange(_id, uuid, datetime, user, QString(), QString(), isDraft);
+    change->setPatchWrapper(&m_patchWrapper);
+    return change;
 }
 
 void ScenarioChangeMapper::doLoad(DomainObject* _domainObject, const QSqlRecord& _record)
@@ -179,11 +267,7 @@ void ScenarioChangeMapper::doLoad(DomainObject* _domainObject, const QSqlRecord&
         const QString user = _record.value("username").toString();
         change->setUser(user);
 
-        const QString undoPatch = _record.value("undo_patch").toString();
-        change->setUndoPatch(undoPatch);
-
-        const QString redoPatch = _record.value("redo_patch").toString();
-        change->setRedoPatch(redoPatch);
+        change->setPatchWrapper(&m_patchWrapper);
 
         const bool isDraft = _record.value("is_draft").toInt();
         change->setIsDraft(isDraft);
@@ -4,16 +4,54 @@
 #include "AbstractMapper.h"
 #include "MapperFacade.h"
 
-namespace Domain {
-    class ScenarioChange;
-    class ScenarioChangesTable;
-}
+#include <Domain/ScenarioChange.h>
+
+#include <QCache>
+#include <QPair>
 
 using namespace Domain;
 
 
 namespace DataMappingLayer
 {
+    /**
+     * @brief Класс загрузчика патчей изменений сценария
+     */
+    class ScenarioChangePatchMapper : public Domain::AbstractPatchWrapper
+    {
+    public:
+        ScenarioChangePatchMapper();
+
+        /**
+         * @brief Получить патч для отмены заданного изменения
+         */
+        QString undoPatch(const ScenarioChange* _forChange) const override;
+
+        /**
+         * @brief Получить патч для повтора/наложения заданного изменения
+         */
+        QString redoPatch(const ScenarioChange* _forChange) const override;
+
+        /**
+         * @brief Удалить патчи заданного изменения из кэша
+         */
+        void remove(const ScenarioChange* _forChange) const;
+
+    private:
+        /**
+         * @brief Получить патчи отмены и повтора заданного изменения
+         */
+        QPair<QString, QString> patches(const ScenarioChange* _forChange) const;
+
+    private:
+        /**
+         * @brief Кэш загруженных патчей
+         */
+        mutable QCache<int, QPair<QString, QString>> m_patchesCache;
+    };
+
+    // ****
+
     class ScenarioChangeMapper : public AbstractMapper
     {
     public:
@@ -21,6 +59,10 @@ namespace DataMappingLayer
         ScenarioChangesTable* findLast(int count);
         ScenarioChangesTable* findAll(const QString& _queryFilter = QString());
         void insert(ScenarioChange* _change);
+        /**
+         * @brief Добавить сразу несколько изменений
+         */
+        void insert(const QList<ScenarioChange*>& _changes);
         void update(ScenarioChange* _change);
         void remove(ScenarioChange* _change);
 
@@ -56,6 +98,11 @@ namespace DataMappingLayer
 
         // Для доступа к конструктору
         friend class MapperFacade;
+
+        /**
+         * @brief Загрузчик патчей для изменений сценария
+         */
+        ScenarioChangePatchMapper m_patchWrapper;
     };
 }
 
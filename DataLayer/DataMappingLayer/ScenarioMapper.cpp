@@ -1,13 +1,34 @@
 #include "ScenarioMapper.h"
 
+#include <DataLayer/Database/Database.h>
+#include <DataLayer/Database/ScriptBinaryFormat.h>
+
 #include <Domain/Scenario.h>
 
+#include <QApplication>
+
 using namespace DataMappingLayer;
 
 
 namespace {
 	const QString kColumns = " id, scheme, text, is_draft ";
 	const QString kTableName = " scenario ";
+
+	/**
+	 * @brief Получить текст сценария из значения колонки, он может храниться как строкой,
+	 *		  так и в двоичном формате
+	 * @note Если текст прочитать не удалось, то сохраняется ошибка, а проекты с таким текстом
+	 *		 не открываются, чтобы не перезаписать его пустым
+	 */
+	static QString textFromValue(const QVariant& _value) {
+		QString text;
+		if (!DatabaseLayer::ScriptBinaryFormat::xmlFromValue(_value, text)) {
+			DatabaseLayer::Database::setLastError(
+				QApplication::translate("DataMappingLayer::ScenarioMapper",
+					"Script text is saved in an unsupported format."));
+		}
+		return text;
+	}
 }
 
 Scenario* ScenarioMapper::find(const Identifier& _id)
@@ -30,6 +51,11 @@ void ScenarioMapper::update(Scenario* _scenario)
 	abstractUpdate(_scenario);
 }
 
+void ScenarioMapper::setBinaryTextFormat(bool _isBinary)
+{
+	m_isBinaryTextFormat = _isBinary;
+}
+
 QString ScenarioMapper::findStatement(const Identifier& _id) const
 {
 	QString findStatement =
@@ -58,7 +84,7 @@ QString ScenarioMapper::insertStatement(DomainObject* _subject, QVariantList& _i
 	_insertValues.clear();
 	_insertValues.append(scenario->id().value());
 	_insertValues.append(scenario->scheme());
-	_insertValues.append(scenario->text());
+	_insertValues.append(textValue(scenario->text()));
 	_insertValues.append(scenario->isDraft() ? "1" : "0");
 
 	return insertStatement;
@@ -77,7 +103,7 @@ QString ScenarioMapper::updateStatement(DomainObject* _subject, QVariantList& _u
 	Scenario* scenario = dynamic_cast<Scenario*>(_subject);
 	_updateValues.clear();
 	_updateValues.append(scenario->scheme());
-	_updateValues.append(scenario->text());
+	_updateValues.append(textValue(scenario->text()));
 	_updateValues.append(scenario->isDraft() ? "1" : "0");
 	_updateValues.append(scenario->id().value());
 
@@ -97,7 +123,7 @@ QString ScenarioMapper::deleteStatement(DomainObject* _subject, QVariantList& _d
 DomainObject* ScenarioMapper::doLoad(const Identifier& _id, const QSqlRecord& _record)
 {
 	const QString scheme = _record.value("scheme").toString();
-	const QString text = _record.value("text").toString();
+	const QString text = ::textFromValue(_record.value("text"));
 	const bool isDraft = _record.value("is_draft").toInt();
 
 	return new Scenario(_id, scheme, text, isDraft);
@@ -109,7 +135,7 @@ void ScenarioMapper::doLoad(DomainObject* _domainObject, const QSqlRecord& _reco
 		const QString scheme = _record.value("scheme").toString();
 		scenario->setScheme(scheme);
 
-		const QString text = _record.value("text").toString();
+		const QString text = ::textFromValue(_record.value("text"));
 		scenario->setText(text);
 
 		const bool isDraft = _record.value("is_draft").toInt();
@@ -117,6 +143,19 @@ void ScenarioMapper::doLoad(DomainObject* _domainObject, const QSqlRecord& _reco
 	}
 }
 
+QVariant ScenarioMapper::textValue(const QString& _text) const
+{
+	//
+	// NOTE: Пустой текст сохраняем строкой, т.к. пустой результат чтения двоичного формата
+	//		 означает повреждённые данные
+	//
+	if (m_isBinaryTextFormat
+		&& !_text.isEmpty()) {
+		return DatabaseLayer::ScriptBinaryFormat::fromXml(_text);
+	}
+	return _text;
+}
+
 DomainObjectsItemModel* ScenarioMapper::modelInstance()
 {
 	return new ScenariosTable;
@@ -22,6 +22,12 @@ namespace DataMappingLayer
         void insert(Scenario* _scenario);
         void update(Scenario* _scenario);
 
+        /**
+         * @brief Сохранять ли текст сценария в двоичном формате
+         * @note Загружается текст в любом из форматов
+         */
+        void setBinaryTextFormat(bool _isBinary);
+
     protected:
         QString findStatement(const Identifier& _id) const;
         QString findAllStatement() const;
@@ -37,6 +43,16 @@ namespace DataMappingLayer
     private:
         ScenarioMapper();
 
+        /**
+         * @brief Получить значение колонки для сохранения текста сценария в текущем формате
+         */
+        QVariant textValue(const QString& _text) const;
+
+        /**
+         * @brief Сохранять ли текст сценария в двоичном формате
+         */
+        bool m_isBinaryTextFormat = false;
+
         // Для доступа к конструктору
         friend class MapperFacade;
     };
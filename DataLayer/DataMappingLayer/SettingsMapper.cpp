@@ -12,8 +12,7 @@ using namespace DatabaseLayer;
 
 void SettingsMapper::setValue(const QString& _key, const QString& _value)
 {
-	QSqlQuery q_loader = Database::query();
-	q_loader.prepare("INSERT INTO system_variables VALUES (?, ?)");
+	QSqlQuery q_loader = Database::preparedQuery("INSERT INTO system_variables VALUES (?, ?)");
 	q_loader.addBindValue(_key);
 	q_loader.addBindValue(_value);
 	q_loader.exec();
@@ -21,12 +20,13 @@ void SettingsMapper::setValue(const QString& _key, const QString& _value)
 
 QString SettingsMapper::value(const QString& _key)
 {
-	QSqlQuery q_loader = Database::query();
-	q_loader.prepare("SELECT value FROM system_variables WHERE variable = ?");
+	QSqlQuery q_loader = Database::preparedQuery("SELECT value FROM system_variables WHERE variable = ?");
 	q_loader.addBindValue(_key);
 	q_loader.exec();
 	q_loader.next();
-	return q_loader.value("value").toString();
+	const QString value = q_loader.value("value").toString();
+	q_loader.finish();
+	return value;
 }
 
 SettingsMapper::SettingsMapper()
@@ -2,7 +2,6 @@
 
 #include "SettingsStorage.h"
 
-#include <DataLayer/Database/Database.h>
 #include <DataLayer/DataMappingLayer/MapperFacade.h>
 #include <DataLayer/DataMappingLayer/ScenarioChangeMapper.h>
 
@@ -132,16 +131,19 @@ void ScenarioChangeStorage::removeLast()
 void ScenarioChangeStorage::store()
 {
     //
-    // Сохраняем все несохранённые изменения
+    // Сохраняем все несохранённые изменения одним пакетом
     //
-    DatabaseLayer::Database::transaction();
-    foreach (DomainObject* domainObject, allToSave()->toList()) {
-        ScenarioChange* change = dynamic_cast<ScenarioChange*>(domainObject);
-        if (!change->id().isValid()) {
-            MapperFacade::scenarioChangeMapper()->insert(change);
+    // NOTE: В список на сохранение попадают только изменения сценария
+    //
+    QList<ScenarioChange*> changesToInsert;
+    const QList<DomainObject*> changesToSave = allToSave()->toList();
+    changesToInsert.reserve(changesToSave.size());
+    for (DomainObject* domainObject : changesToSave) {
+        if (!domainObject->id().isValid()) {
+            changesToInsert.append(static_cast<ScenarioChange*>(domainObject));
         }
     }
-    DatabaseLayer::Database::commit();
+    MapperFacade::scenarioChangeMapper()->insert(changesToInsert);
 
     //
     // Очищаем список на сохранение
@@ -1,4 +1,5 @@
 #include "ScenarioStorage.h"
+#include "SettingsStorage.h"
 
 #include <DataLayer/DataMappingLayer/MapperFacade.h>
 #include <DataLayer/DataMappingLayer/ScenarioMapper.h>
@@ -12,6 +13,18 @@
 using namespace DataStorageLayer;
 using namespace DataMappingLayer;
 
+namespace {
+	/**
+	 * @brief Настроить формат, в котором сохраняется текст сценария
+	 */
+	static void setupTextFormat() {
+		const bool isBinary =
+				StorageFacade::settingsStorage()->value(
+					"application/binary-script-format", SettingsStorage::ApplicationSettings).toInt();
+		MapperFacade::scenarioMapper()->setBinaryTextFormat(isBinary);
+	}
+}
+
 
 ScenariosTable* ScenarioStorage::all()
 {
@@ -48,6 +61,7 @@ Scenario* ScenarioStorage::current(bool _isDraft)
 		//
 		// ... сохраним сценарий в базе данных
 		//
+		::setupTextFormat();
 		MapperFacade::scenarioMapper()->insert(currentScenario);
 		//
 		// ... добавим в список
@@ -62,6 +76,7 @@ void ScenarioStorage::storeScenario(Scenario* _scenario)
 {
 	Q_ASSERT(_scenario);
 
+	::setupTextFormat();
 	MapperFacade::scenarioMapper()->update(_scenario);
 }
 
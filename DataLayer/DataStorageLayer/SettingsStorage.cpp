@@ -79,6 +79,7 @@ void SettingsStorage::setVariantValue(const QString& _key, const QVariant& _valu
     // Кэшируем значение
     //
     cacheValue(_key, _value, _settingsPlace);
+    ++m_revision;
 
     //
     // Сохраняем его в заданное хранилище
@@ -106,6 +107,7 @@ void SettingsStorage::setValues(const QMap<QString, QString>& _values, const QSt
     // Кэшируем значение
     //
     cacheValue(_valuesGroup, QVariant::fromValue<QMap<QString, QString> >(_values), _settingsPlace);
+    ++m_revision;
 
     //
     // Сохраняем его в заданное хранилище
@@ -276,6 +278,7 @@ void SettingsStorage::resetValues(SettingsStorage::SettingsPlace _settingsPlace)
         // Сбрасываем кэш
         //
         m_cachedValuesApp.clear();
+        ++m_revision;
 
         //
         // Восстанавливаем значения по умолчанию
@@ -290,6 +293,11 @@ void SettingsStorage::resetValues(SettingsStorage::SettingsPlace _settingsPlace)
     }
 }
 
+int SettingsStorage::revision() const
+{
+    return m_revision;
+}
+
 void SettingsStorage::saveApplicationStateAndGeometry(QWidget* _widget)
 {
     m_appSettings.beginGroup(STATE_AND_GEOMETRY_KEY);
@@ -585,6 +593,8 @@ SettingsStorage::SettingsStorage()
                            );
     m_defaultValues.insert("application/autosave", "1");
     m_defaultValues.insert("application/autosave-interval", "5");
+    m_defaultValues.insert("application/binary-script-format", "0");
+    m_defaultValues.insert("application/database-synchronous", "1");
     m_defaultValues.insert("application/save-backups", "1");
     m_defaultValues.insert("application/save-backups-folder",
         QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/KITScenarist/backups");
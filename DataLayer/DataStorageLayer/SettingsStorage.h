@@ -51,6 +51,13 @@ namespace DataStorageLayer
 		 */
 		void resetValues(SettingsPlace _settingsPlace);
 
+		/**
+		 * @brief Получить ревизию настроек
+		 * @note Увеличивается при каждом изменении настроек, что позволяет кэшировать
+		 *		 производные от настроек значения
+		 */
+		int revision() const;
+
 		/**
 		 * @brief Сохранить и загрузить положения окон, слайдеров, заголовков таблиц и т.п.
 		 */
@@ -100,6 +107,11 @@ namespace DataStorageLayer
 		QMap<QString, QVariant> m_cachedValuesDb;
 		/** @} */
 
+		/**
+		 * @brief Ревизия настроек
+		 */
+		int m_revision = 0;
+
 		/**
 		 * @brief Загрузить параметр из кэша
 		 */
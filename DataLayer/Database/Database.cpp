@@ -1,5 +1,8 @@
 #include "Database.h"
 
+#include "DatabaseHistoryWriter.h"
+#include "ScriptBinaryFormat.h"
+
 #include <BusinessLayer/ScenarioDocument/ScenarioXml.h>
 
 #include <Domain/Research.h>
@@ -13,6 +16,7 @@
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QTextCodec>
+#include <QThread>
 #include <QUuid>
 #include <QVariant>
 #include <QXmlStreamWriter>
@@ -42,6 +46,45 @@ namespace {
                 "application-version-mobile";
 #endif
     }
+
+    /**
+     * @brief Максимальное количество подготовленных запросов в кэше
+     */
+    const int kPreparedQueriesMaxCount = 128;
+
+    /**
+     * @brief Размер отображаемой в память части файла базы данных
+     */
+    const qint64 kMmapSize = 256 * 1024 * 1024;
+
+    /**
+     * @brief Размер кэша страниц базы данных в килобайтах
+     */
+    const int kPageCacheSizeKb = 16 * 1024;
+
+    /**
+     * @brief Индексы проекта, в формате имя индекса - таблица и колонки
+     */
+    static QList<QPair<QString, QString>> projectIndexes() {
+        return {
+            //
+            // Поиск изменений сценария по идентификатору и дате
+            //
+            { "scenario_changes_uuid_datetime_idx", "scenario_changes (uuid, datetime)" },
+            //
+            // Выборка истории изменений начиная с заданной даты
+            //
+            { "database_history_datetime_idx", "_database_history (datetime)" },
+            //
+            // Дочерние элементы разработки
+            //
+            { "research_parent_id_idx", "research (parent_id, sort_order)" },
+            //
+            // Выборка персонажей и локаций
+            //
+            { "research_type_name_idx", "research (type, name)" }
+        };
+    }
 }
 
 
@@ -70,6 +113,27 @@ bool Database::canOpenFile(const QString& _databaseFileName, bool _isLocal)
                 QApplication::translate("DatabaseLayer::Database",
                     "Project was modified in higher version. You need update application to latest version for open it.");
         }
+        //
+        // 2. Если текст сценария сохранён в двоичном формате, который не поддерживается,
+        //    то его нельзя открывать, иначе при сохранении он будет перезаписан пустым.
+        //    Для этого достаточно проверить заголовок, поэтому текст целиком не загружаем
+        //
+        else if (q_checker.exec(
+                     QString("SELECT substr(text, 1, %1) AS header FROM scenario")
+                     .arg(ScriptBinaryFormat::kHeaderSize))) {
+            while (q_checker.next()) {
+                const QVariant header = q_checker.value("header");
+                if (header.type() == QVariant::ByteArray
+                    && ScriptBinaryFormat::isBinary(header.toByteArray())
+                    && !ScriptBinaryFormat::isSupported(header.toByteArray())) {
+                    canOpen = false;
+                    s_openFileError =
+                        QApplication::translate("DatabaseLayer::Database",
+                            "Script text is saved in an unsupported format. You need update application to latest version for open it.");
+                    break;
+                }
+            }
+        }
     }
 
     QSqlDatabase::removeDatabase("tmp_database");
@@ -123,6 +187,13 @@ void Database::setCurrentFile(const QString& _databaseFileName)
 void Database::closeCurrentFile()
 {
     if (QSqlDatabase::contains(CONNECTION_NAME)) {
+        checkpoint();
+
+        //
+        // Запросы должны быть удалены до удаления соединения
+        //
+        s_preparedQueries.clear();
+
         QSqlDatabase::removeDatabase(CONNECTION_NAME);
     }
 }
@@ -137,6 +208,87 @@ QSqlQuery Database::query()
     return QSqlQuery(instanse());
 }
 
+QSqlQuery Database::preparedQuery(const QString& _statement)
+{
+    if (QSqlQuery* cachedQuery = s_preparedQueries.object(_statement)) {
+        //
+        // Если результаты выборки ещё читаются, то запрос может выполняться при их обработке,
+        // поэтому сбрасывать её нельзя и для него подготавливаем отдельный запрос
+        //
+        const bool isResultsReading =
+                cachedQuery->isActive()
+                && cachedQuery->isSelect()
+                && cachedQuery->at() != QSql::AfterLastRow;
+        if (isResultsReading) {
+            QSqlQuery query = Database::query();
+            query.prepare(_statement);
+            return query;
+        }
+
+        //
+        // Сбрасываем результаты предыдущего выполнения, чтобы не удерживать блокировку чтения
+        //
+        cachedQuery->finish();
+        return *cachedQuery;
+    }
+
+    QSqlQuery query = Database::query();
+    if (query.prepare(_statement)) {
+        s_preparedQueries.insert(_statement, new QSqlQuery(query));
+    }
+    return query;
+}
+
+int Database::synchronousLevel()
+{
+    return s_synchronousLevel;
+}
+
+void Database::setSynchronousLevel(int _level)
+{
+    s_synchronousLevel = qBound(0, _level, 2);
+}
+
+void Database::checkpoint()
+{
+    //
+    // Фиксируем отложенную группу изменений, чтобы она тоже попала в файл
+    //
+    DatabaseHistoryWriter::flush();
+
+    QSqlQuery q_checkpoint = Database::query();
+    q_checkpoint.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+}
+
+bool Database::checkpoint(const QString& _databaseFile)
+{
+    bool isCheckpointed = false;
+
+    //
+    // Соединение с базой данных можно использовать только в создавшем его потоке,
+    // поэтому для каждого потока открываем отдельное соединение
+    //
+    const QString connectionName =
+            QString("database_checkpoint [%1]").arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(SQL_DRIVER, connectionName);
+        database.setDatabaseName(_databaseFile);
+        if (database.open()) {
+            //
+            // Первая колонка результата показывает, что перенос был прерван из-за блокировки
+            //
+            QSqlQuery q_checkpoint(database);
+            isCheckpointed =
+                    q_checkpoint.exec("PRAGMA wal_checkpoint(TRUNCATE)")
+                    && q_checkpoint.next()
+                    && q_checkpoint.value(0).toInt() == 0;
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    return isCheckpointed;
+}
+
 void Database::transaction()
 {
     //
@@ -160,13 +312,19 @@ void Database::commit()
     --s_openedTransactions;
 
     //
-    // При закрытии корневой транзакции фиксируем изменения в базе данных
+    // При закрытии корневой транзакции фиксируем изменения в базе данных вместе с историей
     //
     if (s_openedTransactions == 0) {
+        DatabaseHistoryWriter::flush();
         instanse().commit();
     }
 }
 
+bool Database::isTransactionOpened()
+{
+    return s_openedTransactions > 0;
+}
+
 
 //********
 // Скрытая часть
@@ -179,6 +337,8 @@ QString Database::DATABASE_NAME   = ":memory:";
 QString Database::s_openFileError = QString();
 QString Database::s_lastError = QString();
 int Database::s_openedTransactions = 0;
+QCache<QString, QSqlQuery> Database::s_preparedQueries(kPreparedQueriesMaxCount);
+int Database::s_synchronousLevel = 1;
 
 QSqlDatabase Database::instanse()
 {
@@ -201,6 +361,8 @@ void Database::open(QSqlDatabase& _database, const QString& _connectionName, con
     _database.setDatabaseName(_databaseName);
     _database.open();
 
+    setupConnection(_database);
+
     Database::States states = checkState(_database);
 
     if (!states.testFlag(SchemeFlag))
@@ -213,6 +375,25 @@ void Database::open(QSqlDatabase& _database, const QString& _connectionName, con
         updateDatabase(_database);
 }
 
+void Database::setupConnection(QSqlDatabase& _database)
+{
+    QSqlQuery q_setup(_database);
+
+    //
+    // Журнал упреждающей записи позволяет не переписывать файл и не синхронизировать его
+    // с диском при фиксации каждой транзакции
+    //
+    q_setup.exec("PRAGMA journal_mode = WAL");
+    q_setup.exec(QString("PRAGMA synchronous = %1").arg(s_synchronousLevel));
+
+    //
+    // Читаем файл через отображение в память и держим побольше страниц в кэше
+    //
+    q_setup.exec(QString("PRAGMA mmap_size = %1").arg(kMmapSize));
+    q_setup.exec(QString("PRAGMA cache_size = -%1").arg(kPageCacheSizeKb));
+    q_setup.exec("PRAGMA temp_store = MEMORY");
+}
+
 // Проверка состояния базы данных
 // например:
 // - БД отсутствует
@@ -239,9 +420,18 @@ Database::States Database::checkState(QSqlDatabase& _database)
         //
         // Созданы ли индексы
         //
-        if (q_checker.exec("SELECT COUNT(*) as size FROM sqlite_master WHERE type = 'index' ") &&
+        // NOTE: Проверяем именно индексы проекта, т.к. sqlite сам создаёт индексы для
+        //       первичных ключей и уникальных колонок
+        //
+        QStringList indexesNames;
+        for (const auto& index : projectIndexes()) {
+            indexesNames.append(QString("'%1'").arg(index.first));
+        }
+        if (q_checker.exec(
+                QString("SELECT COUNT(*) as size FROM sqlite_master WHERE type = 'index' AND name IN (%1) ")
+                .arg(indexesNames.join(", "))) &&
             q_checker.next() &&
-            q_checker.record().value("size").toInt()) {
+            q_checker.record().value("size").toInt() == indexesNames.size()) {
             states = states | Database::IndexesFlag;
         }
 
@@ -404,7 +594,14 @@ void Database::createTables(QSqlDatabase& _database)
 
 void Database::createIndexes(QSqlDatabase& _database)
 {
-    Q_UNUSED(_database);
+    QSqlQuery q_creator(_database);
+    _database.transaction();
+
+    for (const auto& index : projectIndexes()) {
+        q_creator.exec(QString("CREATE INDEX IF NOT EXISTS %1 ON %2").arg(index.first, index.second));
+    }
+
+    _database.commit();
 }
 
 void Database::createEnums(QSqlDatabase& _database)
@@ -693,6 +890,10 @@ void Database::updateDatabase(QSqlDatabase& _database)
                 || versionBuild <= 1) {
                 updateDatabaseTo_0_7_2(_database);
             }
+            if (versionMinor < 7
+                || versionBuild <= 2) {
+                updateDatabaseTo_0_7_3(_database);
+            }
         }
     }
 
@@ -1030,9 +1231,10 @@ void Database::updateDatabaseTo_0_5_0(QSqlDatabase& _database)
         // Сам сценарий
         //
         q_updater.exec("SELECT text FROM scenario WHERE is_draft = 0");
-        if (q_updater.next()) {
+        QString scenarioXml;
+        if (q_updater.next()
+            && ScriptBinaryFormat::xmlFromValue(q_updater.record().value("text"), scenarioXml)) {
             const QString defaultScenarioXml = BusinessLogic::ScenarioXml::defaultTextXml();
-            const QString scenarioXml = q_updater.record().value("text").toString();
             const QString undoPatch = DiffMatchPatchHelper::makePatchXml(scenarioXml, defaultScenarioXml);
             const QString redoPatch = DiffMatchPatchHelper::makePatchXml(defaultScenarioXml, scenarioXml);
             q_updater.prepare("INSERT INTO scenario_changes (uuid, datetime, username, undo_patch, redo_patch) "
@@ -1064,7 +1266,10 @@ void Database::updateDatabaseTo_0_5_6(QSqlDatabase& _database)
         QMap<int, QString> scenarioTexts;
         while (q_updater.next()) {
             const int id = q_updater.record().value("id").toInt();
-            QString text = q_updater.record().value("text").toString();
+            QString text;
+            if (!ScriptBinaryFormat::xmlFromValue(q_updater.record().value("text"), text)) {
+                continue;
+            }
             //
             // Заменяем старые теги на новые
             //
@@ -1126,7 +1331,10 @@ void Database::updateDatabaseTo_0_5_9(QSqlDatabase& _database)
         QMap<int, QString> scenarioTexts;
         while (q_updater.next()) {
             const int id = q_updater.record().value("id").toInt();
-            QString text = q_updater.record().value("text").toString();
+            QString text;
+            if (!ScriptBinaryFormat::xmlFromValue(q_updater.record().value("text"), text)) {
+                continue;
+            }
 
             //
             // Вытаскиваем описание папок/групп/сцен и вставляем после заголовков или персонажей сцен
@@ -1261,7 +1469,10 @@ void Database::updateDatabaseTo_0_7_1(QSqlDatabase& _database)
         QMap<int, QString> scenarioTexts;
         while (q_updater.next()) {
             const int id = q_updater.record().value("id").toInt();
-            QString text = q_updater.record().value("text").toString();
+            QString text;
+            if (!ScriptBinaryFormat::xmlFromValue(q_updater.record().value("text"), text)) {
+                continue;
+            }
             //
             // Заменяем старые теги на новые
             //
@@ -1538,3 +1749,17 @@ void Database::updateDatabaseTo_0_7_2(QSqlDatabase& _database)
 
     _database.commit();
 }
+
+void Database::updateDatabaseTo_0_7_3(QSqlDatabase& _database)
+{
+    //
+    // Индексы создаются только если их ещё нет, поэтому повторное обновление безопасно
+    //
+    createIndexes(_database);
+
+    //
+    // Обновим статистику планировщика запросов
+    //
+    QSqlQuery q_updater(_database);
+    q_updater.exec("ANALYZE");
+}
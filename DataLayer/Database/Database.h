@@ -1,7 +1,9 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <QCache>
 #include <QSqlDatabase>
+#include <QSqlQuery>
 
 
 namespace DatabaseLayer
@@ -49,6 +51,39 @@ namespace DatabaseLayer
          */
         static QSqlQuery query();
 
+        /**
+         * @brief Получить подготовленный запрос для заданного текста
+         * @note Подготовленные запросы кэшируются для текущего соединения, поэтому текст запроса
+         *       не должен содержать подставленных значений и зависеть от количества данных,
+         *       только параметры для привязки. Результаты выборки нужно дочитать до конца, или
+         *       завершить вызовом finish(), иначе пока они не прочитаны, для того же текста
+         *       будет подготавливаться отдельный запрос
+         */
+        static QSqlQuery preparedQuery(const QString& _statement);
+
+        /**
+         * @brief Уровень синхронизации записи на диск (0 - OFF, 1 - NORMAL, 2 - FULL)
+         * @note Применяется при открытии соединения
+         */
+        /** @{ */
+        static int synchronousLevel();
+        static void setSynchronousLevel(int _level);
+        /** @} */
+
+        /**
+         * @brief Перенести изменения из журнала в файл базы данных
+         * @note Нужно делать перед копированием файла проекта. Работает через основное
+         *       соединение, поэтому вызывать можно только из главного потока
+         */
+        static void checkpoint();
+
+        /**
+         * @brief Перенести изменения из журнала в заданный файл базы данных
+         * @note Использует отдельное соединение, поэтому может вызываться из любого потока
+         * @return Удалось ли перенести все изменения
+         */
+        static bool checkpoint(const QString& _databaseFile);
+
         /**
          * @brief Запустить транзакцию, если ещё не запущена
          */
@@ -56,9 +91,15 @@ namespace DatabaseLayer
 
         /**
          * @brief Зафиксировать транзакцию, если она была запущена
+         * @note Перед фиксацией корневой транзакции сохраняет накопленную историю изменений
          */
         static void commit();
 
+        /**
+         * @brief Запущена ли транзакция
+         */
+        static bool isTransactionOpened();
+
         /**
          * @brief Состояния базы данных
          */
@@ -96,6 +137,16 @@ namespace DatabaseLayer
          */
         static int s_openedTransactions;
 
+        /**
+         * @brief Подготовленные запросы текущего соединения, вытесняются давно не использованные
+         */
+        static QCache<QString, QSqlQuery> s_preparedQueries;
+
+        /**
+         * @brief Уровень синхронизации записи на диск
+         */
+        static int s_synchronousLevel;
+
         /**
          * @brief Получить объект текущей базы данных
          */
@@ -108,6 +159,12 @@ namespace DatabaseLayer
                 const QString& _connectionName,
                 const QString& _databaseName
                 );
+
+        /**
+         * @brief Настроить соединение: режим журнала, синхронизацию и кэширование
+         */
+        static void setupConnection(QSqlDatabase& _database);
+
         static Database::States checkState(QSqlDatabase& _database);
         static void createTables(QSqlDatabase& _database);
         static void createIndexes(QSqlDatabase& _database);
@@ -219,6 +276,13 @@ namespace DatabaseLayer
          * - добавлена таблица переходов
          */
         static void updateDatabaseTo_0_7_2(QSqlDatabase& _database);
+
+        /**
+         * @brief Обновить базу данных до версии 0.7.3
+         *
+         * - добавлены индексы для поиска изменений сценария, истории изменений и элементов разработки
+         */
+        static void updateDatabaseTo_0_7_3(QSqlDatabase& _database);
     };
 
     Q_DECLARE_OPERATORS_FOR_FLAGS(Database::States)
@@ -0,0 +1,161 @@
+#include "DatabaseHistoryWriter.h"
+
+#include "Database.h"
+#include "DatabaseHelper.h"
+
+#include <3rd_party/Helpers/QVariantMapWriter.h>
+
+#include <QDateTime>
+#include <QSqlQuery>
+#include <QTimer>
+#include <QUuid>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+using DatabaseLayer::Database;
+using DatabaseLayer::DatabaseHelper;
+using DatabaseLayer::DatabaseHistoryWriter;
+
+namespace {
+    /**
+     * @brief Запрос на добавление записи в историю изменений
+     */
+    const QString kInsertStatement =
+            "INSERT INTO _database_history (id, query, query_values, username, datetime) VALUES(?, ?, ?, ?, ?);";
+
+    /**
+     * @brief Количество записей, начиная с которого их значения сжимаются в нескольких потоках
+     */
+    const int kParallelCompressMinRecords = 64;
+
+    /**
+     * @brief Запись истории изменений
+     */
+    struct Record {
+        QString query;
+        QVariantMap values;
+        QString username;
+        QString datetime;
+
+        /**
+         * @brief Значения запроса в сжатом виде
+         */
+        QString compressedValues;
+    };
+
+    /**
+     * @brief Записи, ожидающие фиксации транзакции
+     */
+    QVector<Record> s_records;
+
+    /**
+     * @brief Открыта ли транзакция группы изменений
+     */
+    bool s_isGroupOpened = false;
+
+    /**
+     * @brief Сохранить записи подготовленным запросом основного соединения
+     */
+    static void insertRecords(QVector<Record>& _records) {
+        //
+        // Сериализуем и сжимаем значения, для большой группы записей в нескольких потоках
+        //
+        auto compressValues = [] (Record& _record) {
+            _record.compressedValues = DatabaseHelper::compress(QVariantMapWriter::mapToDataString(_record.values));
+        };
+        if (_records.size() >= kParallelCompressMinRecords) {
+            QtConcurrent::blockingMap(_records, compressValues);
+        } else {
+            std::for_each(_records.begin(), _records.end(), compressValues);
+        }
+
+        QSqlQuery q_writer = Database::preparedQuery(kInsertStatement);
+        for (const Record& record : _records) {
+            //
+            // ... uuid
+            //
+            q_writer.addBindValue(QUuid::createUuid().toString());
+            //
+            // ... запрос
+            //
+            q_writer.addBindValue(record.query);
+            //
+            // ... данные в сжатом виде
+            //
+            q_writer.addBindValue(record.compressedValues);
+            //
+            // ... имя пользователя
+            //
+            q_writer.addBindValue(record.username);
+            //
+            // ... время выполнения
+            //
+            q_writer.addBindValue(record.datetime);
+
+            q_writer.exec();
+        }
+    }
+}
+
+
+void DatabaseHistoryWriter::beginGroup()
+{
+    if (s_isGroupOpened
+        || Database::isTransactionOpened()) {
+        return;
+    }
+
+    //
+    // Все изменения до возврата в цикл событий фиксируем одной транзакцией
+    //
+    s_isGroupOpened = true;
+    Database::transaction();
+    QTimer::singleShot(0, [] { DatabaseHistoryWriter::flush(); });
+}
+
+void DatabaseHistoryWriter::enqueue(const QString& _query, const QVariantMap& _values, const QString& _username)
+{
+    const Record record = {
+        _query, _values, _username,
+        QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss:zzz"),
+        QString()
+    };
+
+    //
+    // Внутри транзакции накапливаем записи, они будут сохранены перед её фиксацией
+    //
+    if (Database::isTransactionOpened()) {
+        s_records.append(record);
+        return;
+    }
+
+    //
+    // Запрос вне транзакции и группы уже зафиксирован, поэтому и запись о нём сохраняем сразу
+    //
+    QVector<Record> records = { record };
+    insertRecords(records);
+}
+
+void DatabaseHistoryWriter::flush()
+{
+    //
+    // Фиксируем группу изменений, при этом сохраняются и накопленные записи
+    //
+    if (s_isGroupOpened) {
+        s_isGroupOpened = false;
+        Database::commit();
+    }
+
+    //
+    // Если снаружи открыта ещё и транзакция, то записи сохраняем, не дожидаясь её фиксации
+    //
+    if (s_records.isEmpty()) {
+        return;
+    }
+
+    QVector<Record> records;
+    records.swap(s_records);
+    insertRecords(records);
+}
@@ -0,0 +1,42 @@
+#ifndef DATABASEHISTORYWRITER_H
+#define DATABASEHISTORYWRITER_H
+
+#include <QString>
+#include <QVariantMap>
+
+
+namespace DatabaseLayer
+{
+    /**
+     * @brief Запись истории изменений базы данных группами
+     *
+     * Записи о запросах накапливаются и сохраняются через основное соединение перед фиксацией
+     * корневой транзакции, поэтому попадают в базу данных вместе с изменёнными данными. Запросы,
+     * выполняемые вне транзакции, объединяются в группу: перед первым из них открывается
+     * транзакция, которая фиксируется при возврате в цикл событий, так что массовое изменение
+     * сохраняется одной транзакцией. Сериализация и сжатие значений большой группы записей
+     * выполняются в нескольких потоках
+     */
+    class DatabaseHistoryWriter
+    {
+    public:
+        /**
+         * @brief Начать группу изменений, если запрос выполняется вне транзакции
+         */
+        static void beginGroup();
+
+        /**
+         * @brief Добавить запись о выполненном запросе
+         */
+        static void enqueue(const QString& _query, const QVariantMap& _values, const QString& _username);
+
+        /**
+         * @brief Зафиксировать группу изменений и сохранить все накопленные записи
+         * @note Вызывается перед фиксацией транзакции, перед чтением истории изменений,
+         *       а значит и перед синхронизацией, и перед переносом изменений из журнала
+         */
+        static void flush();
+    };
+}
+
+#endif // DATABASEHISTORYWRITER_H
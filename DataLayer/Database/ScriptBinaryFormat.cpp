@@ -0,0 +1,498 @@
+#include "ScriptBinaryFormat.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include <QXmlStreamReader>
+#include <QtEndian>
+
+using DatabaseLayer::ScriptBinaryFormat;
+
+namespace {
+    /**
+     * @brief Сигнатура данных в двоичном формате
+     */
+    const QByteArray kSignature = "KITSCRPT";
+
+    /**
+     * @brief Вид содержимого данных
+     */
+    enum class Payload : quint8 {
+        //
+        // Последовательность лексем
+        //
+        Tokens = 0,
+        //
+        // Исходный xml целиком
+        //
+        Xml = 1
+    };
+
+    /**
+     * @brief Вид лексемы
+     */
+    enum class Token : quint8 {
+        StartElement = 1,
+        EmptyElement = 2,
+        EndElement = 3,
+        Text = 4,
+        CData = 5,
+        Raw = 6
+    };
+
+    /**
+     * @brief Записать число
+     */
+    static void writeUInt32(QByteArray& _data, quint32 _value) {
+        uchar bytes[sizeof(quint32)];
+        qToLittleEndian(_value, bytes);
+        _data.append(reinterpret_cast<const char*>(bytes), sizeof(quint32));
+    }
+
+    /**
+     * @brief Записать строку, предварив её длиной
+     */
+    static void writeString(QByteArray& _data, const QString& _string) {
+        const QByteArray utf8 = _string.toUtf8();
+        writeUInt32(_data, utf8.size());
+        _data.append(utf8);
+    }
+
+    /**
+     * @brief Последовательное чтение данных
+     */
+    class DataReader
+    {
+    public:
+        DataReader(const QByteArray& _data, int _position) :
+            m_data(_data),
+            m_position(_position)
+        {
+        }
+
+        /**
+         * @brief Все ли данные прочитаны
+         */
+        bool atEnd() const {
+            return m_position >= m_data.size();
+        }
+
+        /**
+         * @brief Корректны ли прочитанные данные
+         */
+        bool isValid() const {
+            return m_isValid;
+        }
+
+        /**
+         * @brief Отметить данные как повреждённые
+         */
+        void setInvalid() {
+            m_isValid = false;
+        }
+
+        quint8 readByte() {
+            if (!canRead(1)) {
+                return 0;
+            }
+            return static_cast<quint8>(m_data.at(m_position++));
+        }
+
+        quint32 readUInt32() {
+            if (!canRead(sizeof(quint32))) {
+                return 0;
+            }
+            const quint32 value = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(m_data.constData()) + m_position);
+            m_position += sizeof(quint32);
+            return value;
+        }
+
+        QString readString() {
+            const quint32 size = readUInt32();
+            if (!canRead(size)) {
+                return QString();
+            }
+            const QString string = QString::fromUtf8(m_data.constData() + m_position, size);
+            m_position += size;
+            return string;
+        }
+
+    private:
+        /**
+         * @brief Можно ли прочитать заданное количество байт
+         */
+        bool canRead(quint32 _size) {
+            if (!m_isValid
+                || _size > static_cast<quint32>(m_data.size() - m_position)) {
+                m_isValid = false;
+            }
+            return m_isValid;
+        }
+
+    private:
+        const QByteArray& m_data;
+        int m_position = 0;
+        bool m_isValid = true;
+    };
+
+    /**
+     * @brief Экранировать текст внутри тэга
+     */
+    static QString escapedText(const QString& _text) {
+        QString text = _text;
+        return text.replace("&", "&amp;").replace("<", "&lt;").replace(">", "&gt;");
+    }
+
+    /**
+     * @brief Экранировать значение атрибута
+     * @note Так же, как это делается при формировании xml сценария
+     */
+    static QString escapedAttribute(const QString& _value) {
+        QString value = _value;
+        return
+                value.replace("&", "&amp;")
+                .replace("<", "&lt;")
+                .replace(">", "&gt;")
+                .replace("\"", "&quot;")
+                .replace("\n", "&#10;");
+    }
+
+    /**
+     * @brief Сформировать данные с заданным содержимым
+     */
+    static QByteArray makeData(Payload _payload) {
+        QByteArray data = kSignature;
+        writeUInt32(data, ScriptBinaryFormat::kVersion);
+        data.append(static_cast<char>(_payload));
+        return data;
+    }
+}
+
+
+bool ScriptBinaryFormat::isBinary(const QByteArray& _data)
+{
+    return _data.startsWith(kSignature);
+}
+
+bool ScriptBinaryFormat::isSupported(const QByteArray& _data)
+{
+    if (!isBinary(_data)) {
+        return false;
+    }
+
+    DataReader reader(_data, kSignature.size());
+    const quint32 version = reader.readUInt32();
+    const Payload payload = static_cast<Payload>(reader.readByte());
+    return reader.isValid()
+            && version > 0
+            && version <= kVersion
+            && (payload == Payload::Tokens || payload == Payload::Xml);
+}
+
+QByteArray ScriptBinaryFormat::fromXml(const QString& _xml)
+{
+    //
+    // Разбираем xml на лексемы, запоминая имена тэгов и атрибутов в таблице
+    //
+    QHash<QString, quint32> namesIds;
+    QStringList names;
+    auto nameId = [&namesIds, &names] (const QString& _name) {
+        auto iter = namesIds.find(_name);
+        if (iter == namesIds.end()) {
+            iter = namesIds.insert(_name, names.size());
+            names.append(_name);
+        }
+        return iter.value();
+    };
+
+    //
+    // Каждая лексема записывается по своему фрагменту исходного xml. Если по лексеме фрагмент
+    // не восстанавливается в точности, то он записывается как есть, поэтому сверять весь
+    // восстановленный xml с исходным не требуется
+    //
+    QByteArray tokens;
+    tokens.reserve(_xml.size());
+    int position = 0;
+    auto appendRaw = [&tokens, &position, &_xml] (int _end) {
+        if (_end > position) {
+            tokens.append(static_cast<char>(Token::Raw));
+            writeString(tokens, _xml.mid(position, _end - position));
+            position = _end;
+        }
+    };
+
+    QXmlStreamReader reader(_xml);
+    bool isEmptyElementOpened = false;
+    //
+    // Записаны ли как есть тэги открытых элементов
+    //
+    QVector<bool> openedElementsRaw;
+    while (!reader.atEnd()) {
+        const QXmlStreamReader::TokenType tokenType = reader.readNext();
+        const int tokenEnd = reader.characterOffset();
+        switch (tokenType) {
+            case QXmlStreamReader::StartElement:
+            case QXmlStreamReader::EndElement: {
+                //
+                // Конец пустого элемента записан вместе с его началом
+                //
+                if (tokenType == QXmlStreamReader::EndElement
+                    && isEmptyElementOpened) {
+                    isEmptyElementOpened = false;
+                    break;
+                }
+
+                //
+                // Пробельные символы, пропущенные при чтении перед тэгом, сохраняем как есть
+                //
+                const int tagStart = _xml.indexOf('<', position);
+                if (tagStart == -1) {
+                    break;
+                }
+                appendRaw(tagStart);
+
+                const QStringRef tag = _xml.midRef(tagStart, tokenEnd - tagStart);
+                const QString name = reader.qualifiedName().toString();
+                if (tokenType == QXmlStreamReader::EndElement) {
+                    const bool isStartRaw = !openedElementsRaw.isEmpty() && openedElementsRaw.takeLast();
+                    if (isStartRaw
+                        || tag != QString("</%1>").arg(name)) {
+                        appendRaw(tokenEnd);
+                    } else {
+                        tokens.append(static_cast<char>(Token::EndElement));
+                        position = tokenEnd;
+                    }
+                    break;
+                }
+
+                isEmptyElementOpened = tag.endsWith(QLatin1String("/>"));
+                const QXmlStreamAttributes attributes = reader.attributes();
+                QString restoredTag = "<" + name;
+                for (const QXmlStreamAttribute& attribute : attributes) {
+                    restoredTag.append(QString(" %1=\"%2\"")
+                                       .arg(attribute.qualifiedName().toString(),
+                                            escapedAttribute(attribute.value().toString())));
+                }
+                restoredTag.append(isEmptyElementOpened ? "/>" : ">");
+
+                const bool isRaw = tag != restoredTag;
+                if (!isEmptyElementOpened) {
+                    openedElementsRaw.append(isRaw);
+                }
+                if (isRaw) {
+                    appendRaw(tokenEnd);
+                    break;
+                }
+
+                tokens.append(static_cast<char>(isEmptyElementOpened ? Token::EmptyElement : Token::StartElement));
+                writeUInt32(tokens, nameId(name));
+                writeUInt32(tokens, attributes.size());
+                for (const QXmlStreamAttribute& attribute : attributes) {
+                    writeUInt32(tokens, nameId(attribute.qualifiedName().toString()));
+                    writeString(tokens, attribute.value().toString());
+                }
+                position = tokenEnd;
+                break;
+            }
+
+            case QXmlStreamReader::Characters: {
+                if (reader.isCDATA()) {
+                    const int cdataStart = _xml.indexOf(QLatin1String("<![CDATA["), position);
+                    const int cdataEnd = cdataStart == -1 ? -1 : _xml.indexOf(QLatin1String("]]>"), cdataStart);
+                    if (cdataEnd == -1) {
+                        break;
+                    }
+                    appendRaw(cdataStart);
+
+                    //
+                    // Содержимое берём из исходного xml, а не из прочитанного текста, в котором
+                    // переводы строк уже нормализованы
+                    //
+                    const int contentStart = cdataStart + QLatin1String("<![CDATA[").size();
+                    tokens.append(static_cast<char>(Token::CData));
+                    writeString(tokens, _xml.mid(contentStart, cdataEnd - contentStart));
+                    position = cdataEnd + QLatin1String("]]>").size();
+                    break;
+                }
+
+                //
+                // Текст продолжается до ближайшего тэга, и если в нём нет ссылок на символы
+                // и символа >, то при восстановлении он будет записан так же, как в исходном xml
+                //
+                int textEnd = _xml.indexOf('<', position);
+                if (textEnd == -1) {
+                    textEnd = _xml.size();
+                }
+                const QStringRef text = _xml.midRef(position, textEnd - position);
+                if (text.isEmpty()) {
+                    break;
+                }
+                if (text.contains('&')
+                    || text.contains('>')) {
+                    appendRaw(textEnd);
+                } else {
+                    tokens.append(static_cast<char>(Token::Text));
+                    writeString(tokens, text.toString());
+                    position = textEnd;
+                }
+                break;
+            }
+
+            case QXmlStreamReader::Invalid:
+            case QXmlStreamReader::EndDocument: {
+                break;
+            }
+
+            //
+            // Объявление xml, комментарии и прочие редкие лексемы сохраняем как есть
+            //
+            default: {
+                appendRaw(tokenEnd);
+                break;
+            }
+        }
+    }
+
+    //
+    // Некорректный xml сохраняем целиком
+    //
+    if (reader.hasError()) {
+        QByteArray data = makeData(Payload::Xml);
+        writeString(data, _xml);
+        return data;
+    }
+
+    //
+    // ... а так же всё, что осталось после корневого элемента
+    //
+    appendRaw(_xml.size());
+
+    //
+    // Собираем данные из таблицы имён и лексем
+    //
+    QByteArray data = makeData(Payload::Tokens);
+    data.reserve(data.size() + tokens.size() + names.size() * 16);
+    writeUInt32(data, names.size());
+    for (const QString& name : names) {
+        writeString(data, name);
+    }
+    data.append(tokens);
+    return data;
+}
+
+QString ScriptBinaryFormat::toXml(const QByteArray& _data)
+{
+    if (!isSupported(_data)) {
+        return QString();
+    }
+
+    DataReader reader(_data, kSignature.size() + sizeof(quint32));
+    const Payload payload = static_cast<Payload>(reader.readByte());
+    if (payload == Payload::Xml) {
+        const QString xml = reader.readString();
+        return reader.isValid() ? xml : QString();
+    }
+
+    //
+    // Считываем таблицу имён
+    //
+    const quint32 namesCount = reader.readUInt32();
+    QStringList names;
+    for (quint32 index = 0; index < namesCount && reader.isValid(); ++index) {
+        names.append(reader.readString());
+    }
+    auto readName = [&reader, &names] {
+        const quint32 id = reader.readUInt32();
+        if (id >= static_cast<quint32>(names.size())) {
+            reader.setInvalid();
+            return QString();
+        }
+        return names.at(id);
+    };
+
+    //
+    // Восстанавливаем xml по лексемам
+    //
+    QString xml;
+    xml.reserve(_data.size());
+    QVector<QString> openedElements;
+    while (!reader.atEnd() && reader.isValid()) {
+        const Token token = static_cast<Token>(reader.readByte());
+        switch (token) {
+            case Token::StartElement:
+            case Token::EmptyElement: {
+                const QString name = readName();
+                xml.append('<');
+                xml.append(name);
+                const quint32 attributesCount = reader.readUInt32();
+                for (quint32 index = 0; index < attributesCount && reader.isValid(); ++index) {
+                    xml.append(' ');
+                    xml.append(readName());
+                    xml.append("=\"");
+                    xml.append(escapedAttribute(reader.readString()));
+                    xml.append('"');
+                }
+                if (token == Token::EmptyElement) {
+                    xml.append("/>");
+                } else {
+                    xml.append('>');
+                    openedElements.append(name);
+                }
+                break;
+            }
+
+            case Token::EndElement: {
+                if (openedElements.isEmpty()) {
+                    reader.setInvalid();
+                    break;
+                }
+                xml.append("</");
+                xml.append(openedElements.takeLast());
+                xml.append('>');
+                break;
+            }
+
+            case Token::Text: {
+                xml.append(escapedText(reader.readString()));
+                break;
+            }
+
+            case Token::CData: {
+                xml.append("<![CDATA[");
+                xml.append(reader.readString());
+                xml.append("]]>");
+                break;
+            }
+
+            case Token::Raw: {
+                xml.append(reader.readString());
+                break;
+            }
+
+            default: {
+                reader.setInvalid();
+                break;
+            }
+        }
+    }
+
+    return reader.isValid() && openedElements.isEmpty() ? xml : QString();
+}
+
+bool ScriptBinaryFormat::xmlFromValue(const QVariant& _value, QString& _xml)
+{
+    if (_value.type() == QVariant::ByteArray) {
+        const QByteArray data = _value.toByteArray();
+        if (isBinary(data)) {
+            //
+            // Пустой текст в двоичном формате не сохраняется, поэтому пустой результат
+            // означает, что данные не удалось прочитать
+            //
+            _xml = toXml(data);
+            return !_xml.isEmpty();
+        }
+    }
+
+    _xml = _value.toString();
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef SCRIPTBINARYFORMAT_H
+#define SCRIPTBINARYFORMAT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+
+namespace DatabaseLayer
+{
+    /**
+     * @brief Двоичный формат хранения xml текста сценария
+     *
+     * Xml записывается последовательностью лексем, каждая из которых начинается с байта вида
+     * лексемы, а все строки предваряются своей длиной. Имена тэгов и атрибутов (в том числе
+     * типы блоков) хранятся однократно в таблице имён в начале данных, а лексемы ссылаются на
+     * них по номеру. Все числа записываются в little-endian, поэтому данные можно читать
+     * последовательно, в том числе из отображённого в память файла.
+     *
+     * Преобразование обратимо без потерь: фрагменты xml, которые не удаётся в точности
+     * восстановить из лексем, сохраняются как есть, а некорректный xml сохраняется целиком
+     */
+    class ScriptBinaryFormat
+    {
+    public:
+        /**
+         * @brief Текущая версия формата
+         */
+        static const quint32 kVersion = 1;
+
+        /**
+         * @brief Размер заголовка: сигнатуры, версии и вида содержимого
+         */
+        static const int kHeaderSize = 13;
+
+        /**
+         * @brief Являются ли данные xml сценария в двоичном формате
+         */
+        static bool isBinary(const QByteArray& _data);
+
+        /**
+         * @brief Поддерживается ли формат данных
+         * @note Проверяется только заголовок, поэтому для его проверки достаточно первых
+         *       kHeaderSize байт данных
+         */
+        static bool isSupported(const QByteArray& _data);
+
+        /**
+         * @brief Преобразовать xml в двоичный формат
+         */
+        static QByteArray fromXml(const QString& _xml);
+
+        /**
+         * @brief Восстановить xml из двоичного формата
+         * @note Для повреждённых данных, или данных более поздней версии формата, возвращается
+         *       пустая строка
+         */
+        static QString toXml(const QByteArray& _data);
+
+        /**
+         * @brief Получить xml сценария из значения колонки с текстом, он может храниться
+         *        как строкой, так и в двоичном формате
+         * @return Удалось ли восстановить xml, это невозможно для повреждённых данных,
+         *         или данных более поздней версии формата
+         */
+        static bool xmlFromValue(const QVariant& _value, QString& _xml);
+    };
+}
+
+#endif // SCRIPTBINARYFORMAT_H
@@ -60,12 +60,13 @@ void ScenarioChange::setUser(const QString& _user)
 
 QString ScenarioChange::undoPatch() const
 {
-    return m_undoPatch;
+    return m_patchWrapper != nullptr ? m_patchWrapper->undoPatch(this) : m_undoPatch;
 }
 
 void ScenarioChange::setUndoPatch(const QString& _patch)
 {
-    if (m_undoPatch != _patch) {
+    if (undoPatch() != _patch) {
+        loadPatches();
         m_undoPatch = _patch;
 
         changesNotStored();
@@ -74,12 +75,13 @@ void ScenarioChange::setUndoPatch(const QString& _patch)
 
 QString ScenarioChange::redoPatch() const
 {
-    return m_redoPatch;
+    return m_patchWrapper != nullptr ? m_patchWrapper->redoPatch(this) : m_redoPatch;
 }
 
 void ScenarioChange::setRedoPatch(const QString& _patch)
 {
-    if (m_redoPatch != _patch) {
+    if (redoPatch() != _patch) {
+        loadPatches();
         m_redoPatch = _patch;
 
         changesNotStored();
@@ -100,6 +102,26 @@ void ScenarioChange::setIsDraft(bool _isDraft)
     }
 }
 
+void ScenarioChange::setPatchWrapper(AbstractPatchWrapper* _patchWrapper)
+{
+    if (m_patchWrapper != _patchWrapper) {
+        m_patchWrapper = _patchWrapper;
+        if (m_patchWrapper != nullptr) {
+            m_undoPatch.clear();
+            m_redoPatch.clear();
+        }
+    }
+}
+
+void ScenarioChange::loadPatches()
+{
+    if (m_patchWrapper != nullptr) {
+        m_undoPatch = m_patchWrapper->undoPatch(this);
+        m_redoPatch = m_patchWrapper->redoPatch(this);
+        m_patchWrapper = nullptr;
+    }
+}
+
 // ****
 
 namespace {
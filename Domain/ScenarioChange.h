@@ -9,6 +9,28 @@
 
 namespace Domain
 {
+	class ScenarioChange;
+
+	/**
+	 * @brief Интерфейс класса для загрузки патчей изменений сценария из БД
+	 */
+	class AbstractPatchWrapper {
+	public:
+		virtual ~AbstractPatchWrapper() {}
+
+		/**
+		 * @brief Получить патч для отмены заданного изменения
+		 */
+		virtual QString undoPatch(const ScenarioChange* _forChange) const = 0;
+
+		/**
+		 * @brief Получить патч для повтора/наложения заданного изменения
+		 */
+		virtual QString redoPatch(const ScenarioChange* _forChange) const = 0;
+	};
+
+	// ****
+
 	/**
 	 * @brief Класс атома изменения сценария
 	 */
@@ -66,6 +88,19 @@ namespace Domain
 		void setIsDraft(bool _isDraft);
 		/** @} **/
 
+		/**
+		 * @brief Установить загрузчик патчей
+		 * @note Патчи, хранящиеся в самом изменении, при этом освобождаются и далее
+		 *       загружаются по запросу
+		 */
+		void setPatchWrapper(AbstractPatchWrapper* _patchWrapper);
+
+	private:
+		/**
+		 * @brief Загрузить патчи в само изменение, отказавшись от загрузчика
+		 */
+		void loadPatches();
+
 	private:
 		/**
 		 * @brief Уникальный айди
@@ -96,6 +131,11 @@ namespace Domain
 		 * @brief Изменение чистовика (0) или черновика (1)
 		 */
 		bool m_isDraft;
+
+		/**
+		 * @brief Загрузчик патчей
+		 */
+		AbstractPatchWrapper* m_patchWrapper = nullptr;
 	};
 
 	// ****
@@ -24,6 +24,11 @@ namespace {
     const QString RECENT_FILES_LIST_SETTINGS_KEY = "application/recent-files/list";
     const QString RECENT_FILES_USING_SETTINGS_KEY = "application/recent-files/using";
 
+    /**
+     * @brief Суффиксы файлов журнала, создаваемых базой данных рядом с файлом проекта
+     */
+    const QStringList kDatabaseJournalSuffixes = { "-wal", "-shm" };
+
     /**
      * @brief kit scenarist project
      */
@@ -120,6 +125,9 @@ bool ProjectsManager::setCurrentProject(const QString& _path, bool _isLocal, boo
         // Делаем проект текущим и загружаем из него БД
         // или создаём, если ранее его не существовало
         //
+        DatabaseLayer::Database::setSynchronousLevel(
+            DataStorageLayer::StorageFacade::settingsStorage()->value(
+                "application/database-synchronous", DataStorageLayer::SettingsStorage::ApplicationSettings).toInt());
         DatabaseLayer::Database::setCurrentFile(projectPath);
 
         Project newCurrentProject;
@@ -397,9 +405,20 @@ void ProjectsManager::setRemoteProjects(const QString& _xml)
     // Удаляем все старые проекты
     //
     for (const auto& fileInfo : QDir(Project::remoteProjectsDirPath()).entryInfoList(QDir::Files)) {
+        //
+        // Файлы журнала базы данных удаляем вместе с проектом, к которому они относятся
+        //
+        QString projectPath = QDir::toNativeSeparators(fileInfo.absoluteFilePath());
+        for (const QString& journalSuffix : kDatabaseJournalSuffixes) {
+            if (projectPath.endsWith(journalSuffix)) {
+                projectPath.chop(journalSuffix.size());
+                break;
+            }
+        }
+
         bool needRemoveProject = true;
         for (const auto& project : m_remoteProjects) {
-            if (project.path() == QDir::toNativeSeparators(fileInfo.absoluteFilePath())) {
+            if (project.path() == projectPath) {
                 needRemoveProject = false;
                 break;
             }
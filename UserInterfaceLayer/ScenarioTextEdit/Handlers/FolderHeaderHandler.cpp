@@ -4,6 +4,7 @@
 #include "../ScenarioTextEditHelpers.h"
 
 #include <BusinessLayer/ScenarioDocument/ScenarioTextBlockInfo.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
 
 #include <QKeyEvent>
 #include <QTextBlock>
@@ -86,8 +87,10 @@ void FolderHeaderHandler::handleEnter(QKeyEvent*)
                     if (SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*> (cursor.block().userData())) {
                         SceneHeadingBlockInfo* movedInfo = info->clone();
                         cursor.block().setUserData(nullptr);
+                        ScenarioTextDocument::markBlockDataChanged(cursor.block());
                         cursor.movePosition(QTextCursor::NextBlock);
                         cursor.block().setUserData(movedInfo);
+                        ScenarioTextDocument::markBlockDataChanged(cursor.block());
                     }
 				} else if (cursorForwardText.isEmpty()) {
 					//! В конце блока
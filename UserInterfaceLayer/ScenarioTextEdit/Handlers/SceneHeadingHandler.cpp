@@ -4,6 +4,7 @@
 
 #include <BusinessLayer/ScenarioDocument/ScenarioTextBlockParsers.h>
 #include <BusinessLayer/ScenarioDocument/ScenarioTextBlockInfo.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
 
 #include <Domain/Place.h>
 #include <Domain/Research.h>
@@ -185,8 +186,10 @@ void SceneHeadingHandler::handleEnter(QKeyEvent* _event)
                     if (SceneHeadingBlockInfo* info = dynamic_cast<SceneHeadingBlockInfo*> (cursor.block().userData())) {
                         SceneHeadingBlockInfo* movedInfo = info->clone();
                         cursor.block().setUserData(nullptr);
+                        ScenarioTextDocument::markBlockDataChanged(cursor.block());
                         cursor.movePosition(QTextCursor::NextBlock);
                         cursor.block().setUserData(movedInfo);
+                        ScenarioTextDocument::markBlockDataChanged(cursor.block());
                     }
                 } else if (cursorForwardText.isEmpty()) {
                     //! В конце блока
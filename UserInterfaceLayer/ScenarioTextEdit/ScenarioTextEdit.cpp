@@ -936,6 +936,14 @@ void ScenarioTextEdit::inputMethodEvent(QInputMethodEvent* _event)
         return;
     }
 
+    //
+    // Изменения стандартного обработчика и последующей обработки передаём в документ
+    // одним пакетом, чтобы модели документа обновлялись один раз на событие
+    //
+    if (m_document != nullptr) {
+        m_document->beginChangesBatch();
+    }
+
     //
     // Вызываем стандартный обработчик
     //
@@ -971,6 +979,10 @@ void ScenarioTextEdit::inputMethodEvent(QInputMethodEvent* _event)
     // Завершим блок операций
     //
     cursor.endEditBlock();
+
+    if (m_document != nullptr) {
+        m_document->endChangesBatch();
+    }
 }
 
 bool ScenarioTextEdit::keyPressEventReimpl(QKeyEvent* _event)
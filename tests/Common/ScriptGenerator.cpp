@@ -0,0 +1,232 @@
+#include "ScriptGenerator.h"
+
+#include <QSet>
+#include <QStringList>
+#include <QUuid>
+#include <QVector>
+
+#include <random>
+
+namespace {
+    /**
+     * @brief Слова, из которых составляется текст
+     */
+    const QStringList kWords = {
+        "the", "door", "opens", "slowly", "and", "light", "falls", "across", "floor", "she",
+        "looks", "at", "him", "without", "a", "word", "rain", "keeps", "drumming", "on",
+        "window", "somewhere", "far", "away", "dog", "barks", "they", "wait", "for", "signal"
+    };
+
+    /**
+     * @brief Имена персонажей
+     */
+    const QStringList kCharacters = { "ANNA", "MAX", "DETECTIVE ROSS", "OLD MAN", "KATE" };
+
+    /**
+     * @brief Места и время действия
+     */
+    const QStringList kLocations = { "KITCHEN", "OFFICE", "STREET", "CAR", "ROOFTOP", "STATION" };
+    const QStringList kTimes = { "DAY", "NIGHT", "MORNING", "EVENING" };
+
+    /**
+     * @brief Тип генерируемого блока
+     */
+    enum class BlockType {
+        FolderHeader,
+        FolderFooter,
+        SceneHeading,
+        Action,
+        Character,
+        Parenthetical,
+        Dialogue
+    };
+
+    /**
+     * @brief Имя узла блока в xml сценария
+     */
+    static QString nodeName(BlockType _type) {
+        switch (_type) {
+            case BlockType::FolderHeader: return "folder_header";
+            case BlockType::FolderFooter: return "folder_footer";
+            case BlockType::SceneHeading: return "scene_heading";
+            case BlockType::Action: return "action";
+            case BlockType::Character: return "character";
+            case BlockType::Parenthetical: return "parenthetical";
+            case BlockType::Dialogue: return "dialog";
+        }
+        return QString();
+    }
+
+    /**
+     * @brief Сформированный блок
+     */
+    struct Block {
+        BlockType type;
+        QString text;
+    };
+
+    /**
+     * @brief Генератор, определяющий весь текст сценария
+     */
+    class Generator
+    {
+    public:
+        explicit Generator(quint32 _seed) :
+            m_random(_seed)
+        {
+        }
+
+        int next(int _bound) {
+            return std::uniform_int_distribution<int>(0, _bound - 1)(m_random);
+        }
+
+        bool chance(qreal _probability) {
+            return std::uniform_real_distribution<qreal>(0, 1)(m_random) < _probability;
+        }
+
+        QString sentence(int _minWords, int _maxWords) {
+            const int wordsCount = _minWords + next(_maxWords - _minWords + 1);
+            QStringList words;
+            for (int index = 0; index < wordsCount; ++index) {
+                words.append(kWords.at(next(kWords.size())));
+            }
+            QString text = words.join(' ');
+            text[0] = text.at(0).toUpper();
+            return text + ".";
+        }
+
+        QString uuid() {
+            //
+            // Порядок вычисления аргументов не определён, поэтому части идентификатора
+            // получаем последовательно
+            //
+            const uint data1 = m_random();
+            const ushort data2 = next(0x10000);
+            const ushort data3 = next(0x10000);
+            uchar data4[8];
+            for (uchar& byte : data4) {
+                byte = next(0x100);
+            }
+            return QUuid(data1, data2, data3, data4[0], data4[1], data4[2], data4[3],
+                         data4[4], data4[5], data4[6], data4[7]).toString();
+        }
+
+        /**
+         * @brief Выбрать заданное количество различных номеров из диапазона
+         */
+        QSet<int> pick(int _count, int _bound) {
+            QSet<int> result;
+            const int count = qMin(_count, _bound);
+            while (result.size() < count) {
+                result.insert(next(_bound));
+            }
+            return result;
+        }
+
+    private:
+        std::mt19937 m_random;
+    };
+}
+
+
+ScriptGenerator::Parameters ScriptGenerator::typicalParameters(int _scenes)
+{
+    Parameters parameters;
+    parameters.scenes = _scenes;
+    parameters.dialogueRatio = 0.6;
+    parameters.folders = _scenes / 20;
+    parameters.reviewMarks = _scenes / 2;
+    parameters.bookmarks = _scenes / 10;
+    return parameters;
+}
+
+QString ScriptGenerator::generate(const Parameters& _parameters)
+{
+    Generator generator(_parameters.seed);
+
+    //
+    // Формируем блоки сценария, распределяя сцены по папкам поровну
+    //
+    QVector<Block> blocks;
+    QVector<int> textBlocks;
+    const int folders = qBound(0, _parameters.folders, _parameters.scenes);
+    int sceneNumber = 0;
+    for (int folder = 0; folder < qMax(folders, 1); ++folder) {
+        const int scenesInFolder =
+                folders == 0
+                ? _parameters.scenes
+                : _parameters.scenes * (folder + 1) / folders - _parameters.scenes * folder / folders;
+        if (folders > 0) {
+            blocks.append({ BlockType::FolderHeader, QString("ACT %1").arg(folder + 1) });
+        }
+
+        for (int scene = 0; scene < scenesInFolder; ++scene) {
+            ++sceneNumber;
+            blocks.append({ BlockType::SceneHeading,
+                            QString("INT. %1 - %2")
+                            .arg(kLocations.at(generator.next(kLocations.size())))
+                            .arg(kTimes.at(generator.next(kTimes.size()))) });
+            for (int fragment = 0; fragment < _parameters.fragmentsPerScene; ++fragment) {
+                if (generator.chance(_parameters.dialogueRatio)) {
+                    blocks.append({ BlockType::Character, kCharacters.at(generator.next(kCharacters.size())) });
+                    if (generator.chance(0.2)) {
+                        blocks.append({ BlockType::Parenthetical, "(quietly)" });
+                    }
+                    textBlocks.append(blocks.size());
+                    blocks.append({ BlockType::Dialogue, generator.sentence(3, 18) });
+                } else {
+                    textBlocks.append(blocks.size());
+                    blocks.append({ BlockType::Action, generator.sentence(6, 40) });
+                }
+            }
+        }
+
+        if (folders > 0) {
+            blocks.append({ BlockType::FolderFooter, QString() });
+        }
+    }
+    Q_ASSERT(sceneNumber == _parameters.scenes);
+
+    //
+    // Определим блоки с заметками и закладками, их выбираем среди блоков текста
+    //
+    QSet<int> reviewBlocks;
+    for (int index : generator.pick(_parameters.reviewMarks, textBlocks.size())) {
+        reviewBlocks.insert(textBlocks.at(index));
+    }
+    QSet<int> bookmarkBlocks;
+    for (int index : generator.pick(_parameters.bookmarks, textBlocks.size())) {
+        bookmarkBlocks.insert(textBlocks.at(index));
+    }
+
+    //
+    // Формируем xml так же, как это делает редактор
+    //
+    QString xml = "<?xml version=\"1.0\"?>\n<scenario version=\"1.0\">\n";
+    for (int index = 0; index < blocks.size(); ++index) {
+        const Block& block = blocks.at(index);
+        const QString name = nodeName(block.type);
+        xml += "<" + name;
+        if (block.type == BlockType::SceneHeading
+            || block.type == BlockType::FolderHeader) {
+            xml += QString(" uuid=\"%1\"").arg(generator.uuid());
+        }
+        if (bookmarkBlocks.contains(index)) {
+            xml += QString(" bookmark=\"Bookmark %1\" bookmark_color=\"#ff0000\"").arg(index);
+        }
+        xml += ">\n";
+        xml += "<v><![CDATA[" + block.text + "]]></v>\n";
+        if (reviewBlocks.contains(index)) {
+            const int length = qMin(block.text.length(), 10);
+            xml += "<reviews>\n";
+            xml += QString("<review from=\"0\" length=\"%1\" bgcolor=\"#ffff00\" is_highlight=\"false\" done=\"false\">\n")
+                   .arg(length);
+            xml += "<review_comment comment=\"Check this\" author=\"benchmark\" date=\"2026-01-01T10:00:00\"/>\n";
+            xml += "</review>\n";
+            xml += "</reviews>\n";
+        }
+        xml += "</" + name + ">\n";
+    }
+    xml += "</scenario>\n";
+    return xml;
+}
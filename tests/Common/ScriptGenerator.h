@@ -0,0 +1,69 @@
+#ifndef SCRIPTGENERATOR_H
+#define SCRIPTGENERATOR_H
+
+#include <QString>
+
+
+/**
+ * @brief Генератор синтетических сценариев для тестов и замеров производительности
+ *
+ * Формирует xml сценария в том же формате, в котором его сохраняет редактор. Текст
+ * определяется только параметрами, поэтому сценарии одного размера совпадают между запусками
+ */
+class ScriptGenerator
+{
+public:
+    /**
+     * @brief Параметры генерируемого сценария
+     */
+    struct Parameters {
+        /**
+         * @brief Количество сцен
+         */
+        int scenes = 100;
+
+        /**
+         * @brief Количество фрагментов текста в сцене, каждый из которых либо описание действия,
+         *        либо реплика из имени персонажа, ремарки и самой реплики
+         */
+        int fragmentsPerScene = 8;
+
+        /**
+         * @brief Доля реплик среди фрагментов текста сцены, от 0 до 1
+         */
+        qreal dialogueRatio = 0.5;
+
+        /**
+         * @brief Количество папок, по которым поровну распределяются сцены
+         */
+        int folders = 0;
+
+        /**
+         * @brief Количество редакторских заметок
+         */
+        int reviewMarks = 0;
+
+        /**
+         * @brief Количество закладок
+         */
+        int bookmarks = 0;
+
+        /**
+         * @brief Начальное значение генератора случайных чисел
+         */
+        quint32 seed = 1;
+    };
+
+    /**
+     * @brief Параметры сценария заданного количества сцен с долей реплик, папок,
+     *        заметок и закладок, характерной для полнометражных сценариев
+     */
+    static Parameters typicalParameters(int _scenes);
+
+    /**
+     * @brief Сформировать xml сценария
+     */
+    static QString generate(const Parameters& _parameters);
+};
+
+#endif // SCRIPTGENERATOR_H
@@ -0,0 +1,84 @@
+#include <3rd_party/Helpers/DiffMatchPatchHelper.h>
+
+#include <QtTest>
+
+namespace {
+    /**
+     * @brief Сформировать xml сценария из xml блоков
+     */
+    static QString scriptXml(const QString& _blocksXml) {
+        return "<?xml version=\"1.0\"?>\n<scenario version=\"1.0\">\n" + _blocksXml + "</scenario>\n";
+    }
+
+    /**
+     * @brief Сформировать xml блока описания действия с заданным экранированным текстом
+     */
+    static QString actionXml(const QString& _escapedText) {
+        return "<action>\n<v><![CDATA[" + _escapedText + "]]></v>\n</action>\n";
+    }
+}
+
+
+/**
+ * @brief Тесты вспомогательных функций сравнения xml-текстов сценария
+ */
+class DiffMatchPatchHelperTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Каждая экранирующая сущность в тексте блока считается за один символ документа
+     */
+    void removeXmlTagsCountsEntityAsOneChar();
+
+    /**
+     * @brief Позиция и длина изменённого фрагмента совпадают с позициями в документе,
+     *        если текст блоков содержит экранированные символы
+     */
+    void changedXmlWithEscapedText();
+
+    /**
+     * @brief Патч, сформированный по xml, восстанавливает экранированный текст без изменений
+     */
+    void applyPatchXmlWithEscapedText();
+};
+
+void DiffMatchPatchHelperTest::removeXmlTagsCountsEntityAsOneChar()
+{
+    QCOMPARE(::removeXmlTagsForScenario(actionXml("a &amp; b &lt; c &gt; d &quot;e&quot;")),
+             QString("a & b < c > d \"e\"\n"));
+    QCOMPARE(::removeXmlTagsForScenario(actionXml("&amp;lt;")), QString("&lt;\n"));
+    QCOMPARE(::removeXmlTagsForScenario(actionXml("&unknown; &")), QString("&unknown; &\n"));
+}
+
+void DiffMatchPatchHelperTest::changedXmlWithEscapedText()
+{
+    const QString oldXml = scriptXml(actionXml("a &amp; b") + actionXml("x &lt; y"));
+    const QString newXml = scriptXml(actionXml("a &amp; b") + actionXml("x &lt; z &amp;"));
+    const QString patch = DiffMatchPatchHelper::makePatchXml(oldXml, newXml);
+
+    const auto xmls = DiffMatchPatchHelper::changedXml(oldXml, patch);
+    QVERIFY(xmls.first.isValid());
+    QVERIFY(xmls.second.isValid());
+    //
+    // ... второй блок начинается после текста "a & b" и переноса строки
+    //
+    QCOMPARE(xmls.first.plainPos, 6);
+    QCOMPARE(xmls.first.plainLength, QString("x < y").length());
+    QCOMPARE(xmls.second.plainPos, 6);
+    QCOMPARE(xmls.second.plainLength, QString("x < z &").length());
+}
+
+void DiffMatchPatchHelperTest::applyPatchXmlWithEscapedText()
+{
+    const QString oldXml = scriptXml(actionXml("1 &lt; 2") + actionXml("Tom &amp; Jerry"));
+    const QString newXml = scriptXml(actionXml("1 &lt; 2 &gt; 0") + actionXml("Tom &amp; &quot;Jerry&quot;"));
+
+    QCOMPARE(DiffMatchPatchHelper::applyPatchXml(oldXml, DiffMatchPatchHelper::makePatchXml(oldXml, newXml)),
+             newXml);
+}
+
+QTEST_APPLESS_MAIN(DiffMatchPatchHelperTest)
+
+#include "DiffMatchPatchHelperTest.moc"
@@ -0,0 +1,13 @@
+QT += testlib xml gui
+
+TARGET = DiffMatchPatchHelperTest
+CONFIG += console testcase c++11
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    DiffMatchPatchHelperTest.cpp \
+    $$PWD/../../3rd_party/Helpers/DiffMatchPatch.cpp
@@ -0,0 +1,313 @@
+#include <BusinessLayer/ScenarioDocument/ScenarioModelItem.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioModelItemsIndex.h>
+
+#include <3rd_party/Helpers/TreapHelper.h>
+
+#include <QMap>
+#include <QSet>
+#include <QtTest>
+
+#include <iterator>
+#include <random>
+
+using BusinessLogic::ScenarioModelItem;
+using BusinessLogic::ScenarioModelItemsIndex;
+
+namespace {
+    /**
+     * @brief Элементы индекса по позициям, с которыми сверяется индекс
+     */
+    using Reference = QMap<int, ScenarioModelItem*>;
+
+    /**
+     * @brief Сместить позиции элементов так же, как это делает индекс
+     * @return Элементы, удалённые из индекса, т.к. после смещения оказались не перед смещёнными
+     */
+    static QMap<int, ScenarioModelItem*> shiftReference(Reference& _reference, int _fromPosition, int _delta) {
+        QMap<int, ScenarioModelItem*> removed;
+        const auto firstShifted = _reference.lowerBound(_fromPosition);
+        if (_delta == 0
+            || firstShifted == _reference.end()) {
+            return removed;
+        }
+
+        Reference result;
+        const int firstShiftedPosition = firstShifted.key() + _delta;
+        for (auto iter = _reference.begin(); iter != firstShifted; ++iter) {
+            if (iter.key() < firstShiftedPosition) {
+                result.insert(iter.key(), iter.value());
+            } else {
+                removed.insert(iter.key(), iter.value());
+            }
+        }
+        for (auto iter = firstShifted; iter != _reference.end(); ++iter) {
+            result.insert(iter.key() + _delta, iter.value());
+        }
+        _reference = result;
+        return removed;
+    }
+
+    /**
+     * @brief Длительность сцен, предшествующих элементу
+     */
+    static qreal referenceDurationBefore(const Reference& _reference, const ScenarioModelItem* _item) {
+        qreal duration = 0;
+        for (auto iter = _reference.begin(); iter != _reference.end() && iter.value() != _item; ++iter) {
+            if (iter.value()->type() == ScenarioModelItem::Scene) {
+                duration += iter.value()->duration();
+            }
+        }
+        return duration;
+    }
+}
+
+
+/**
+ * @brief Тесты индекса позиций элементов модели сценария и вспомогательных функций декартовых деревьев
+ */
+class ScenarioModelItemsIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Приоритеты узлов не повторяются
+     */
+    void treapPrioritiesDoNotRepeat();
+
+    /**
+     * @brief Элементы находятся по позициям, в том числе ближайшие
+     */
+    void findsItemsByPosition();
+
+    /**
+     * @brief При смещении удаляются элементы, которые оказались не перед смещёнными
+     */
+    void shiftRemovesOvertakenItems();
+
+    /**
+     * @brief После случайной последовательности изменений индекс совпадает с эталоном
+     */
+    void matchesReferenceAfterRandomEdits();
+
+    /**
+     * @brief Удалить созданные тестом элементы
+     */
+    void cleanup();
+
+private:
+    /**
+     * @brief Создать элемент
+     */
+    ScenarioModelItem* createItem();
+
+    /**
+     * @brief Сверить индекс с эталоном
+     */
+    void compare(const ScenarioModelItemsIndex& _index, const Reference& _reference, int _maxPosition);
+
+private:
+    /**
+     * @brief Созданные тестом элементы
+     */
+    QVector<ScenarioModelItem*> m_items;
+};
+
+void ScenarioModelItemsIndexTest::treapPrioritiesDoNotRepeat()
+{
+    const int prioritiesCount = 100000;
+    QSet<quint32> priorities;
+    priorities.reserve(prioritiesCount);
+    for (int index = 0; index < prioritiesCount; ++index) {
+        priorities.insert(TreapHelper::nextPriority());
+    }
+    QCOMPARE(priorities.size(), prioritiesCount);
+}
+
+void ScenarioModelItemsIndexTest::findsItemsByPosition()
+{
+    ScenarioModelItemsIndex index;
+    ScenarioModelItem* first = createItem();
+    ScenarioModelItem* second = createItem();
+    index.insert(10, first);
+    index.insert(20, second);
+
+    QCOMPARE(index.value(10), first);
+    QCOMPARE(index.value(15), static_cast<ScenarioModelItem*>(nullptr));
+    QCOMPARE(index.lowerBound(11), second);
+    QCOMPARE(index.lowerBound(21), static_cast<ScenarioModelItem*>(nullptr));
+    QCOMPARE(index.nearest(5), first);
+    QCOMPARE(index.nearest(15), first);
+    QCOMPARE(index.nearest(25), second);
+    QCOMPARE(index.previous(second), first);
+    QCOMPARE(second->position(), 20);
+
+    index.clear();
+}
+
+void ScenarioModelItemsIndexTest::shiftRemovesOvertakenItems()
+{
+    ScenarioModelItemsIndex index;
+    QVector<ScenarioModelItem*> items;
+    for (int position : { 0, 10, 20, 30 }) {
+        items.append(createItem());
+        index.insert(position, items.last());
+    }
+
+    index.shift(20, -15);
+
+    QCOMPARE(index.value(0), items.at(0));
+    QCOMPARE(index.value(5), items.at(2));
+    QCOMPARE(index.value(15), items.at(3));
+    QVERIFY(!index.contains(10));
+    QCOMPARE(items.at(1)->position(), 10);
+    QCOMPARE(index.previous(items.at(2)), items.at(0));
+
+    index.clear();
+}
+
+void ScenarioModelItemsIndexTest::matchesReferenceAfterRandomEdits()
+{
+    const int maxPosition = 300;
+    std::mt19937 random(1);
+    auto next = [&random] (int _bound) {
+        return std::uniform_int_distribution<int>(0, _bound - 1)(random);
+    };
+
+    ScenarioModelItemsIndex index;
+    Reference reference;
+    for (int step = 0; step < 2000; ++step) {
+        switch (next(5)) {
+            //
+            // Добавление нового элемента, возможно замещающего существующий
+            //
+            case 0: {
+                const int position = next(maxPosition);
+                ScenarioModelItem* item = createItem();
+                item->setDuration(next(100));
+                ScenarioModelItem* replacedItem = reference.value(position);
+                index.insert(position, item);
+                reference.insert(position, item);
+                if (replacedItem != nullptr) {
+                    QCOMPARE(replacedItem->position(), position);
+                }
+                break;
+            }
+
+            //
+            // Удаление элемента
+            //
+            case 1: {
+                if (reference.isEmpty()) {
+                    break;
+                }
+                const int position = reference.keys().at(next(reference.size()));
+                ScenarioModelItem* item = reference.take(position);
+                index.remove(item);
+                QCOMPARE(item->position(), position);
+                break;
+            }
+
+            //
+            // Смещение позиций
+            //
+            case 2: {
+                const int fromPosition = next(maxPosition);
+                const int delta = next(41) - qMin(20, fromPosition);
+                const QMap<int, ScenarioModelItem*> removed = shiftReference(reference, fromPosition, delta);
+                index.shift(fromPosition, delta);
+                for (auto iter = removed.begin(); iter != removed.end(); ++iter) {
+                    QCOMPARE(iter.value()->position(), iter.key());
+                }
+                break;
+            }
+
+            //
+            // Изменение длительности и типа элемента
+            //
+            case 3: {
+                if (reference.isEmpty()) {
+                    break;
+                }
+                ScenarioModelItem* item = reference.values().at(next(reference.size()));
+                item->setDuration(next(100));
+                item->setType(next(4) == 0 ? ScenarioModelItem::Folder : ScenarioModelItem::Scene);
+                break;
+            }
+
+            //
+            // Перемещение элемента в другую позицию
+            //
+            case 4: {
+                if (reference.isEmpty()) {
+                    break;
+                }
+                const int oldPosition = reference.keys().at(next(reference.size()));
+                const int newPosition = next(maxPosition);
+                ScenarioModelItem* item = reference.take(oldPosition);
+                index.insert(newPosition, item);
+                reference.insert(newPosition, item);
+                break;
+            }
+        }
+
+        //
+        // Позиции могут вырасти за счёт смещений
+        //
+        const int lastPosition = reference.isEmpty() ? 0 : reference.lastKey();
+        compare(index, reference, qMax(maxPosition, lastPosition) + 1);
+        if (QTest::currentTestFailed()) {
+            qWarning() << "Failed at step" << step;
+            break;
+        }
+    }
+
+    index.clear();
+}
+
+void ScenarioModelItemsIndexTest::cleanup()
+{
+    qDeleteAll(m_items);
+    m_items.clear();
+}
+
+ScenarioModelItem* ScenarioModelItemsIndexTest::createItem()
+{
+    ScenarioModelItem* item = new ScenarioModelItem(0);
+    m_items.append(item);
+    return item;
+}
+
+void ScenarioModelItemsIndexTest::compare(const ScenarioModelItemsIndex& _index, const Reference& _reference,
+    int _maxPosition)
+{
+    QCOMPARE(_index.isEmpty(), _reference.isEmpty());
+
+    for (int position = 0; position <= _maxPosition; ++position) {
+        const auto lowerBound = _reference.lowerBound(position);
+        ScenarioModelItem* expectedLowerBound = lowerBound != _reference.end() ? lowerBound.value() : nullptr;
+        ScenarioModelItem* expectedNearest = expectedLowerBound;
+        if (lowerBound == _reference.end()
+            || lowerBound.key() != position) {
+            if (lowerBound != _reference.begin()) {
+                expectedNearest = std::prev(lowerBound).value();
+            }
+        }
+
+        QCOMPARE(_index.value(position), _reference.value(position));
+        QCOMPARE(_index.lowerBound(position), expectedLowerBound);
+        QCOMPARE(_index.nearest(position), expectedNearest);
+    }
+
+    ScenarioModelItem* previous = nullptr;
+    for (auto iter = _reference.begin(); iter != _reference.end(); ++iter) {
+        QCOMPARE(iter.value()->position(), iter.key());
+        QCOMPARE(_index.previous(iter.value()), previous);
+        QCOMPARE(_index.durationBefore(iter.value()), referenceDurationBefore(_reference, iter.value()));
+        previous = iter.value();
+    }
+}
+
+QTEST_APPLESS_MAIN(ScenarioModelItemsIndexTest)
+
+#include "ScenarioModelItemsIndexTest.moc"
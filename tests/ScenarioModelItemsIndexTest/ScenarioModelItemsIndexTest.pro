@@ -0,0 +1,14 @@
+QT += testlib gui
+
+TARGET = ScenarioModelItemsIndexTest
+CONFIG += console testcase c++11
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    ScenarioModelItemsIndexTest.cpp \
+    $$PWD/../../BusinessLayer/ScenarioDocument/ScenarioModelItem.cpp \
+    $$PWD/../../BusinessLayer/ScenarioDocument/ScenarioModelItemsIndex.cpp
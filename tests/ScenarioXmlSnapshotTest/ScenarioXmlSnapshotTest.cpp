@@ -0,0 +1,225 @@
+#include <BusinessLayer/ScenarioDocument/ScenarioDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioXml.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioXmlSnapshot.h>
+
+#include <DataLayer/Database/Database.h>
+#include <DataLayer/Database/DatabaseHelper.h>
+
+#include <Domain/Scenario.h>
+
+#include <3rd_party/Helpers/DiffMatchPatchHelper.h>
+
+#include <tests/Common/ScriptGenerator.h>
+
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QtTest>
+
+#include <random>
+
+using BusinessLogic::ScenarioDocument;
+using BusinessLogic::ScenarioTextDocument;
+using BusinessLogic::ScenarioXml;
+using BusinessLogic::ScenarioXmlSnapshot;
+using DatabaseLayer::Database;
+using DatabaseLayer::DatabaseHelper;
+
+namespace {
+    /**
+     * @brief Загрузить сценарий в документ целиком
+     */
+    static void loadScript(ScenarioDocument& _document, Domain::Scenario& _scenario) {
+        _document.load(&_scenario);
+        _document.document()->finishLoading();
+        _document.document()->saveChanges();
+    }
+
+    /**
+     * @brief Изменить текст в середине документа
+     */
+    static void editMiddle(QTextDocument* _document, const QString& _edit) {
+        const QTextBlock block = _document->findBlockByNumber(_document->blockCount() / 2);
+        QTextCursor cursor(_document);
+        cursor.setPosition(block.position() + block.length() / 2);
+        if (_edit == "insert") {
+            cursor.insertText(" a & b < c > d \"e\" ");
+        } else if (_edit == "remove") {
+            cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor, 2);
+            cursor.removeSelectedText();
+        } else if (_edit == "split") {
+            cursor.insertBlock();
+        }
+    }
+}
+
+
+/**
+ * @brief Тесты снимка xml сценария: хэша и соответствия фрагментов xml блокам документа
+ */
+class ScenarioXmlSnapshotTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Подготовить базу данных, в которую сохраняются изменения текста
+     */
+    void initTestCase();
+    void cleanupTestCase();
+
+    /**
+     * @brief Xml и хэш снимка совпадают с xml, сформированным по всему документу
+     */
+    void snapshotMatchesFullXml_data();
+    void snapshotMatchesFullXml();
+
+    /**
+     * @brief Сохранённый xml и хэш совпадают с xml всего документа после каждого изменения
+     */
+    void savedXmlFollowsEdits();
+
+    /**
+     * @brief Патч, применённый к затронутому им фрагменту, даёт тот же xml, что и правка
+     *        исходного документа
+     */
+    void patchAppliedToFragment_data();
+    void patchAppliedToFragment();
+
+private:
+    /**
+     * @brief Сохранить изменения и сверить xml документа и его хэш с xml всего документа
+     */
+    void compareWithFullXml(ScenarioDocument& _document);
+
+private:
+    /**
+     * @brief Папка для файла базы данных
+     */
+    QTemporaryDir m_databaseDir;
+};
+
+void ScenarioXmlSnapshotTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_databaseDir.isValid());
+    Database::setCurrentFile(m_databaseDir.filePath("snapshot-test.kitsp"));
+}
+
+void ScenarioXmlSnapshotTest::cleanupTestCase()
+{
+    Database::closeCurrentFile();
+}
+
+void ScenarioXmlSnapshotTest::snapshotMatchesFullXml_data()
+{
+    QTest::addColumn<QString>("xml");
+
+    QTest::newRow("empty") << QString();
+    QTest::newRow("scenes") << ScriptGenerator::generate(ScriptGenerator::Parameters());
+    //
+    // ... сценарий, загружаемый по частям
+    //
+    QTest::newRow("folders, review marks and bookmarks")
+            << ScriptGenerator::generate(ScriptGenerator::typicalParameters(300));
+}
+
+void ScenarioXmlSnapshotTest::snapshotMatchesFullXml()
+{
+    QFETCH(QString, xml);
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument document;
+    loadScript(document, scenario);
+    compareWithFullXml(document);
+}
+
+void ScenarioXmlSnapshotTest::savedXmlFollowsEdits()
+{
+    Domain::Scenario scenario(Domain::Identifier(), QString(),
+                              ScriptGenerator::generate(ScriptGenerator::typicalParameters(40)), false);
+    ScenarioDocument document;
+    loadScript(document, scenario);
+
+    std::mt19937 random(1);
+    auto next = [&random] (int _bound) {
+        return std::uniform_int_distribution<int>(0, _bound - 1)(random);
+    };
+    ScenarioTextDocument* textDocument = document.document();
+    for (int step = 0; step < 100; ++step) {
+        QTextCursor cursor(textDocument);
+        cursor.setPosition(next(textDocument->characterCount() - 1));
+        switch (next(3)) {
+            case 0: {
+                cursor.insertText(" a & b < c ");
+                break;
+            }
+
+            case 1: {
+                cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, next(200));
+                cursor.removeSelectedText();
+                break;
+            }
+
+            default: {
+                cursor.insertBlock();
+                break;
+            }
+        }
+
+        compareWithFullXml(document);
+        if (QTest::currentTestFailed()) {
+            qWarning() << "Failed at step" << step;
+            break;
+        }
+    }
+}
+
+void ScenarioXmlSnapshotTest::patchAppliedToFragment_data()
+{
+    QTest::addColumn<QString>("edit");
+
+    QTest::newRow("insert escaped text") << "insert";
+    QTest::newRow("remove blocks") << "remove";
+    QTest::newRow("split block") << "split";
+}
+
+void ScenarioXmlSnapshotTest::patchAppliedToFragment()
+{
+    QFETCH(QString, edit);
+
+    const QString xml = ScriptGenerator::generate(ScriptGenerator::typicalParameters(40));
+    Domain::Scenario sourceScenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument source;
+    loadScript(source, sourceScenario);
+    Domain::Scenario targetScenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument target;
+    loadScript(target, targetScenario);
+
+    const QString oldXml = target.document()->scenarioXml();
+    editMiddle(source.document(), edit);
+    source.document()->saveChanges();
+    const QString newXml = source.document()->scenarioXml();
+    QVERIFY(oldXml != newXml);
+
+    target.document()->applyPatch(DatabaseHelper::compress(DiffMatchPatchHelper::makePatchXml(oldXml, newXml)));
+    QCOMPARE(target.document()->scenarioXml(), newXml);
+    compareWithFullXml(target);
+}
+
+void ScenarioXmlSnapshotTest::compareWithFullXml(ScenarioDocument& _document)
+{
+    ScenarioTextDocument* textDocument = _document.document();
+    textDocument->saveChanges();
+
+    ScenarioXml xmlHandler(&_document);
+    const QString fullXml = xmlHandler.scenarioToXml();
+    QCOMPARE(textDocument->scenarioXml(), fullXml);
+    QCOMPARE(textDocument->scenarioXmlHash(), ScenarioXmlSnapshot::textHash(fullXml));
+}
+
+QTEST_MAIN(ScenarioXmlSnapshotTest)
+
+#include "ScenarioXmlSnapshotTest.moc"
@@ -0,0 +1,12 @@
+QT += testlib
+
+TARGET = ScenarioXmlSnapshotTest
+CONFIG += console testcase c++11
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+include(../core.pri)
+
+SOURCES += \
+    ScenarioXmlSnapshotTest.cpp
@@ -0,0 +1,337 @@
+#include <BusinessLayer/ScenarioDocument/ScenarioDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioXml.h>
+#include <BusinessLayer/Export/DocxExporter.h>
+#include <BusinessLayer/Export/FdxExporter.h>
+#include <BusinessLayer/Export/FountainExporter.h>
+#include <BusinessLayer/Export/PdfExporter.h>
+
+#include <DataLayer/Database/Database.h>
+#include <DataLayer/Database/DatabaseHelper.h>
+
+#include <Domain/Scenario.h>
+
+#include <3rd_party/Helpers/DiffMatchPatchHelper.h>
+
+#include <tests/Common/ScriptGenerator.h>
+
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QtTest>
+
+using BusinessLogic::AbstractExporter;
+using BusinessLogic::ExportParameters;
+using BusinessLogic::ScenarioDocument;
+using BusinessLogic::ScenarioXml;
+using DatabaseLayer::Database;
+using DatabaseLayer::DatabaseHelper;
+
+namespace {
+    /**
+     * @brief Переменная окружения с количеством сцен дополнительного замера
+     */
+    const char* kScenesEnvironmentVariable = "SCRIPT_BENCHMARK_SCENES";
+
+    /**
+     * @brief Загрузить сценарий в документ целиком
+     */
+    static void loadScript(ScenarioDocument& _document, Domain::Scenario& _scenario) {
+        _document.load(&_scenario);
+        _document.document()->finishLoading();
+        _document.document()->saveChanges();
+    }
+
+    /**
+     * @brief Позиция в середине документа
+     */
+    static int middlePosition(const QTextDocument* _document) {
+        const QTextBlock block = _document->findBlockByNumber(_document->blockCount() / 2);
+        return block.position() + block.length() / 2;
+    }
+}
+
+
+/**
+ * @brief Замеры производительности основных операций со сценарием
+ *
+ * Сценарии создаются генератором, поэтому замеры воспроизводимы. Результаты в машиночитаемом
+ * виде выводятся средствами QtTest, например: ScriptBenchmark -o results.csv,csv
+ * Дополнительный размер сценария задаётся переменной окружения SCRIPT_BENCHMARK_SCENES
+ */
+class ScriptBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Подготовить базу данных, в которую сохраняются изменения текста
+     */
+    void initTestCase();
+    void cleanupTestCase();
+
+    /**
+     * @brief Загрузка сценария в документ
+     */
+    void loadScript_data();
+    void loadScript();
+
+    /**
+     * @brief Формирование xml по всему документу
+     */
+    void scenarioToXml_data();
+    void scenarioToXml();
+
+    /**
+     * @brief Ввод текста в середине документа
+     */
+    void typeText_data();
+    void typeText();
+
+    /**
+     * @brief Сохранение изменения текста
+     */
+    void saveChanges_data();
+    void saveChanges();
+
+    /**
+     * @brief Применение патча к документу
+     */
+    void applyPatch_data();
+    void applyPatch();
+
+    /**
+     * @brief Корректировка текста: имён персонажей и разрывов страниц
+     */
+    void correctText_data();
+    void correctText();
+
+    /**
+     * @brief Экспорт сценария
+     */
+    void exportScript_data();
+    void exportScript();
+
+private:
+    /**
+     * @brief Добавить строки с размерами сценариев
+     */
+    void addScriptRows(const QString& _prefix = QString());
+
+    /**
+     * @brief Создать экспортер заданного формата
+     */
+    AbstractExporter* createExporter(const QString& _format) const;
+
+private:
+    /**
+     * @brief Папка для файла базы данных и экспортированных файлов
+     */
+    QTemporaryDir m_workingDir;
+};
+
+void ScriptBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_workingDir.isValid());
+    Database::setCurrentFile(m_workingDir.filePath("benchmark.kitsp"));
+}
+
+void ScriptBenchmark::cleanupTestCase()
+{
+    Database::closeCurrentFile();
+}
+
+void ScriptBenchmark::loadScript_data()
+{
+    addScriptRows();
+}
+
+void ScriptBenchmark::loadScript()
+{
+    QFETCH(QString, xml);
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), xml, false);
+    QBENCHMARK {
+        ScenarioDocument document;
+        ::loadScript(document, scenario);
+    }
+}
+
+void ScriptBenchmark::scenarioToXml_data()
+{
+    addScriptRows();
+}
+
+void ScriptBenchmark::scenarioToXml()
+{
+    QFETCH(QString, xml);
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument document;
+    ::loadScript(document, scenario);
+    ScenarioXml xmlHandler(&document);
+    QBENCHMARK {
+        xmlHandler.scenarioToXml();
+    }
+}
+
+void ScriptBenchmark::typeText_data()
+{
+    addScriptRows();
+}
+
+void ScriptBenchmark::typeText()
+{
+    QFETCH(QString, xml);
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument document;
+    ::loadScript(document, scenario);
+    QTextCursor cursor(document.document());
+    cursor.setPosition(middlePosition(document.document()));
+    QBENCHMARK {
+        cursor.insertText("a");
+    }
+}
+
+void ScriptBenchmark::saveChanges_data()
+{
+    addScriptRows();
+}
+
+void ScriptBenchmark::saveChanges()
+{
+    QFETCH(QString, xml);
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument document;
+    ::loadScript(document, scenario);
+    QTextCursor cursor(document.document());
+    cursor.setPosition(middlePosition(document.document()));
+    QBENCHMARK {
+        cursor.insertText("a");
+        document.document()->saveChanges();
+    }
+}
+
+void ScriptBenchmark::applyPatch_data()
+{
+    addScriptRows();
+}
+
+void ScriptBenchmark::applyPatch()
+{
+    QFETCH(QString, xml);
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument document;
+    ::loadScript(document, scenario);
+    const QString oldXml = document.document()->scenarioXml();
+
+    //
+    // Патчи строятся по копии документа, в которую вносится правка
+    //
+    Domain::Scenario editedScenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument editedDocument;
+    ::loadScript(editedDocument, editedScenario);
+    QTextCursor cursor(editedDocument.document());
+    cursor.setPosition(middlePosition(editedDocument.document()));
+    cursor.insertText(" a & b < c ");
+    editedDocument.document()->saveChanges();
+    const QString newXml = editedDocument.document()->scenarioXml();
+
+    const QString forwardPatch = DatabaseHelper::compress(DiffMatchPatchHelper::makePatchXml(oldXml, newXml));
+    const QString backwardPatch = DatabaseHelper::compress(DiffMatchPatchHelper::makePatchXml(newXml, oldXml));
+    QBENCHMARK {
+        document.document()->applyPatch(forwardPatch);
+        document.document()->applyPatch(backwardPatch);
+    }
+}
+
+void ScriptBenchmark::correctText_data()
+{
+    addScriptRows();
+}
+
+void ScriptBenchmark::correctText()
+{
+    QFETCH(QString, xml);
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument document;
+    ::loadScript(document, scenario);
+    document.document()->setCorrectionOptions(true, true);
+    QBENCHMARK {
+        document.document()->correct();
+    }
+}
+
+void ScriptBenchmark::exportScript_data()
+{
+    QTest::addColumn<QString>("format");
+    QTest::addColumn<QString>("xml");
+
+    for (const QString& format : { "docx", "fdx", "fountain", "pdf" }) {
+        addScriptRows(format);
+    }
+}
+
+void ScriptBenchmark::exportScript()
+{
+    QFETCH(QString, format);
+    QFETCH(QString, xml);
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), xml, false);
+    ScenarioDocument document;
+    ::loadScript(document, scenario);
+    QScopedPointer<AbstractExporter> exporter(createExporter(format));
+    ExportParameters exportParameters;
+    exportParameters.filePath = m_workingDir.filePath("benchmark." + format);
+    QBENCHMARK {
+        exporter->exportTo(&document, exportParameters);
+    }
+}
+
+void ScriptBenchmark::addScriptRows(const QString& _prefix)
+{
+    const bool withFormat = !_prefix.isEmpty();
+    if (!withFormat) {
+        QTest::addColumn<QString>("xml");
+    }
+
+    QList<int> scenesCounts = { 100, 1000 };
+    const int environmentScenes = qEnvironmentVariableIntValue(kScenesEnvironmentVariable);
+    if (environmentScenes > 0
+        && !scenesCounts.contains(environmentScenes)) {
+        scenesCounts.append(environmentScenes);
+    }
+
+    for (int scenes : scenesCounts) {
+        const QString xml = ScriptGenerator::generate(ScriptGenerator::typicalParameters(scenes));
+        const QString rowName = QString("%1scenes_%2").arg(withFormat ? _prefix + ", " : QString()).arg(scenes);
+        if (withFormat) {
+            QTest::newRow(rowName.toUtf8().constData()) << _prefix << xml;
+        } else {
+            QTest::newRow(rowName.toUtf8().constData()) << xml;
+        }
+    }
+}
+
+AbstractExporter* ScriptBenchmark::createExporter(const QString& _format) const
+{
+    if (_format == "docx") {
+        return new BusinessLogic::DocxExporter;
+    } else if (_format == "fdx") {
+        return new BusinessLogic::FdxExporter;
+    } else if (_format == "fountain") {
+        return new BusinessLogic::FountainExporter;
+    }
+    return new BusinessLogic::PdfExporter;
+}
+
+QTEST_MAIN(ScriptBenchmark)
+
+#include "ScriptBenchmark.moc"
@@ -0,0 +1,136 @@
+#include <DataLayer/Database/ScriptBinaryFormat.h>
+
+#include <tests/Common/ScriptGenerator.h>
+
+#include <QtEndian>
+#include <QtTest>
+
+using DatabaseLayer::ScriptBinaryFormat;
+
+namespace {
+    /**
+     * @brief Позиция версии формата в данных, сразу после сигнатуры
+     */
+    const int kVersionPosition = 8;
+}
+
+
+/**
+ * @brief Тесты двоичного формата хранения xml текста сценария
+ */
+class ScriptBinaryFormatTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Xml восстанавливается из двоичного формата в точности, в том числе и тогда,
+     *        когда он не может быть представлен лексемами
+     */
+    void roundTripRestoresXml_data();
+    void roundTripRestoresXml();
+
+    /**
+     * @brief Xml, сохранённый строкой, не принимается за двоичные данные
+     */
+    void plainXmlIsNotBinary();
+
+    /**
+     * @brief Поддержка формата определяется по заголовку данных
+     */
+    void headerDefinesSupport();
+
+    /**
+     * @brief Обрезанные данные не читаются
+     */
+    void truncatedDataIsRejected();
+
+    /**
+     * @brief Данные более поздней версии формата не читаются
+     */
+    void laterVersionIsRejected();
+};
+
+void ScriptBinaryFormatTest::roundTripRestoresXml_data()
+{
+    QTest::addColumn<QString>("xml");
+
+    QTest::newRow("generated script")
+            << ScriptGenerator::generate(ScriptGenerator::typicalParameters(50));
+    QTest::newRow("escaped text and attributes")
+            << "<?xml version=\"1.0\"?>\n<scenario version=\"1.0\">\n"
+               "<action bookmark=\"a &amp; b &quot;c&quot;&#10;d\" bookmark_color=\"#ff0000\">\n"
+               "<v><![CDATA[x < y & z]]></v>\n"
+               "</action>\n"
+               "<note>a &amp; b &lt; c</note>\n"
+               "</scenario>\n";
+    QTest::newRow("empty element with space")
+            << "<scenario version=\"1.0\">\n<action>\n<v><![CDATA[text]]></v>\n<reviews />\n</action>\n</scenario>\n";
+    QTest::newRow("unusual markup")
+            << "<?xml version='1.0'?>\r\n<!-- comment -->\n<scenario version='1.0' >\r\n"
+               "<action bookmark=\"a&#9;b\"><v><![CDATA[line\r\nbreak]]></v>x &gt; y</action >\n"
+               "</scenario>\r\n\r\n";
+    QTest::newRow("malformed xml")
+            << "<scenario version=\"1.0\">\n<action>\n</scenario>\n";
+}
+
+void ScriptBinaryFormatTest::roundTripRestoresXml()
+{
+    QFETCH(QString, xml);
+
+    const QByteArray data = ScriptBinaryFormat::fromXml(xml);
+    QVERIFY(ScriptBinaryFormat::isBinary(data));
+    QCOMPARE(ScriptBinaryFormat::toXml(data), xml);
+
+    QString valueXml;
+    QVERIFY(ScriptBinaryFormat::xmlFromValue(QVariant(data), valueXml));
+    QCOMPARE(valueXml, xml);
+}
+
+void ScriptBinaryFormatTest::plainXmlIsNotBinary()
+{
+    const QString xml = ScriptGenerator::generate(ScriptGenerator::typicalParameters(5));
+    QVERIFY(!ScriptBinaryFormat::isBinary(xml.toUtf8()));
+    QVERIFY(ScriptBinaryFormat::toXml(xml.toUtf8()).isEmpty());
+
+    QString valueXml;
+    QVERIFY(ScriptBinaryFormat::xmlFromValue(QVariant(xml), valueXml));
+    QCOMPARE(valueXml, xml);
+}
+
+void ScriptBinaryFormatTest::headerDefinesSupport()
+{
+    QByteArray data = ScriptBinaryFormat::fromXml(ScriptGenerator::generate(ScriptGenerator::typicalParameters(5)));
+    QVERIFY(ScriptBinaryFormat::isSupported(data));
+    QVERIFY(ScriptBinaryFormat::isSupported(data.left(ScriptBinaryFormat::kHeaderSize)));
+    QVERIFY(!ScriptBinaryFormat::isSupported(data.left(ScriptBinaryFormat::kHeaderSize - 1)));
+
+    qToLittleEndian<quint32>(ScriptBinaryFormat::kVersion + 1,
+                             reinterpret_cast<uchar*>(data.data() + kVersionPosition));
+    QVERIFY(!ScriptBinaryFormat::isSupported(data.left(ScriptBinaryFormat::kHeaderSize)));
+}
+
+void ScriptBinaryFormatTest::truncatedDataIsRejected()
+{
+    const QByteArray data = ScriptBinaryFormat::fromXml(ScriptGenerator::generate(ScriptGenerator::typicalParameters(5)));
+    for (int size : { kVersionPosition + 2, data.size() / 2, data.size() - 1 }) {
+        const QByteArray truncatedData = data.left(size);
+        QVERIFY(ScriptBinaryFormat::toXml(truncatedData).isEmpty());
+
+        QString valueXml;
+        QVERIFY(!ScriptBinaryFormat::xmlFromValue(QVariant(truncatedData), valueXml));
+    }
+}
+
+void ScriptBinaryFormatTest::laterVersionIsRejected()
+{
+    QByteArray data = ScriptBinaryFormat::fromXml(ScriptGenerator::generate(ScriptGenerator::typicalParameters(5)));
+    qToLittleEndian<quint32>(ScriptBinaryFormat::kVersion + 1,
+                             reinterpret_cast<uchar*>(data.data() + kVersionPosition));
+    QVERIFY(ScriptBinaryFormat::isBinary(data));
+    QVERIFY(ScriptBinaryFormat::toXml(data).isEmpty());
+}
+
+QTEST_APPLESS_MAIN(ScriptBinaryFormatTest)
+
+#include "ScriptBinaryFormatTest.moc"
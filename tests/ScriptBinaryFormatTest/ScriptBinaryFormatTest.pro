@@ -0,0 +1,18 @@
+QT += testlib
+QT -= gui
+
+TARGET = ScriptBinaryFormatTest
+CONFIG += console testcase c++11
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+HEADERS += \
+    $$PWD/../Common/ScriptGenerator.h
+
+SOURCES += \
+    ScriptBinaryFormatTest.cpp \
+    $$PWD/../Common/ScriptGenerator.cpp \
+    $$PWD/../../DataLayer/Database/ScriptBinaryFormat.cpp
@@ -0,0 +1,25 @@
+#
+# Подключение ядра для тестов и замеров, которым нужно ядро целиком
+#
+# Ядро и используемые им библиотеки собираются проектом приложения, поэтому флаги
+# компоновки с ними передаются при вызове qmake:
+#     qmake CORE_LIBS="-L<каталог сборки ядра> -l<библиотека ядра> <её зависимости>"
+#
+isEmpty(CORE_LIBS) {
+    error("CORE_LIBS is not set: pass the core link flags to qmake, see tests/core.pri")
+}
+
+QT += core gui widgets xml sql concurrent printsupport network
+
+INCLUDEPATH += $$PWD/..
+
+LIBS += $$CORE_LIBS
+
+RESOURCES += \
+    $$PWD/../Resources/Resources.qrc
+
+HEADERS += \
+    $$PWD/Common/ScriptGenerator.h
+
+SOURCES += \
+    $$PWD/Common/ScriptGenerator.cpp
@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    DiffMatchPatchHelperTest \
+    ScenarioModelItemsIndexTest \
+    ScenarioXmlSnapshotTest \
+    ScriptBinaryFormatTest \
+    ScriptBenchmark